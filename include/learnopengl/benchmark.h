@@ -0,0 +1,234 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Timing of a benchmarked piece of code, all times are per call. The percentiles are over the samples, each the
+// average of iterations calls.
+struct BenchmarkResult
+{
+	std::string name;
+	double median_ns = 0.0;
+	double min_ns = 0.0;
+	double mean_ns = 0.0;
+	double p90_ns = 0.0;
+	double p99_ns = 0.0;
+	double max_ns = 0.0;
+	double stddev_ns = 0.0;
+	size_t iterations = 0;
+	size_t samples = 0;
+};
+
+// keeps the compiler from optimising away a value nobody reads
+template<typename T>
+inline void
+do_not_optimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static const volatile void* sink;
+	sink = &value;
+#endif
+}
+
+// value below which a fraction p of the sorted values lie, interpolated between the nearest two
+inline double
+percentile(const std::vector<double>& sorted, double p)
+{
+	if (sorted.empty())
+		return 0.0;
+	const double position = p * (sorted.size() - 1);
+	const size_t below = size_t(position);
+	const size_t above = std::min(below + 1, sorted.size() - 1);
+	return sorted[below] + (sorted[above] - sorted[below]) * (position - below);
+}
+
+// calls fn iterations times per sample and reports the distribution of the samples. Calls fn for warmup_ms first, at
+// least once, so caches, branch predictors and the CPU clock have settled.
+template<typename Function>
+BenchmarkResult
+run_benchmark(
+	const std::string& name,
+	size_t iterations,
+	Function&& fn,
+	unsigned int samples = 15,
+	double warmup_ms = 50.0)
+{
+	using clock = std::chrono::steady_clock;
+
+	const auto warmup_start = clock::now();
+	do
+		fn();
+	while (std::chrono::duration<double, std::milli>(clock::now() - warmup_start).count() < warmup_ms);
+
+	std::vector<double> timings;
+	timings.reserve(samples);
+	for (unsigned int s = 0; s < samples; ++s)
+	{
+		const auto start = clock::now();
+		for (size_t i = 0; i < iterations; ++i)
+			fn();
+		const auto end = clock::now();
+		timings.push_back(std::chrono::duration<double, std::nano>(end - start).count() / iterations);
+	}
+	std::sort(timings.begin(), timings.end());
+
+	BenchmarkResult result;
+	result.name = name;
+	result.median_ns = percentile(timings, 0.5);
+	result.min_ns = timings.front();
+	result.p90_ns = percentile(timings, 0.9);
+	result.p99_ns = percentile(timings, 0.99);
+	result.max_ns = timings.back();
+	for (double timing : timings)
+		result.mean_ns += timing / timings.size();
+	for (double timing : timings)
+		result.stddev_ns += (timing - result.mean_ns) * (timing - result.mean_ns) / timings.size();
+	result.stddev_ns = std::sqrt(result.stddev_ns);
+	result.iterations = iterations;
+	result.samples = timings.size();
+	return result;
+}
+
+// keeps the calling thread on one CPU so it is not migrated between samples, false where unsupported
+inline bool
+pin_current_thread(unsigned int cpu)
+{
+#if defined(_WIN32)
+	return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#elif defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+	(void)cpu;
+	return false;
+#endif
+}
+
+inline bool
+write_benchmark_json(const std::string& path, const std::vector<BenchmarkResult>& results)
+{
+	FILE* file = std::fopen(path.c_str(), "w");
+	if (!file)
+		return false;
+	std::fprintf(file, "{\n  \"benchmarks\": [");
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const BenchmarkResult& result = results[i];
+		std::string name;
+		for (char c : result.name)
+		{
+			if (c == '"' || c == '\\')
+				name += '\\';
+			name += c;
+		}
+		std::fprintf(
+			file,
+			"%s\n    {\"name\": \"%s\", \"iterations\": %zu, \"samples\": %zu, \"median_ns\": %.3f, \"min_ns\": %.3f, "
+			"\"mean_ns\": %.3f, \"p90_ns\": %.3f, \"p99_ns\": %.3f, \"max_ns\": %.3f, \"stddev_ns\": %.3f}",
+			i == 0 ? "" : ",",
+			name.c_str(),
+			result.iterations,
+			result.samples,
+			result.median_ns,
+			result.min_ns,
+			result.mean_ns,
+			result.p90_ns,
+			result.p99_ns,
+			result.max_ns,
+			result.stddev_ns);
+	}
+	std::fprintf(file, "\n  ]\n}\n");
+	return std::fclose(file) == 0;
+}
+
+inline void
+print_benchmark_result(const BenchmarkResult& result)
+{
+	std::printf("%-56s %14.1f ns  (min %14.1f ns)\n", result.name.c_str(), result.median_ns, result.min_ns);
+}
+
+// Command line of a benchmark executable: --samples n, --warmup-ms ms, --pin cpu and --json results.json. Runs,
+// prints and collects the benchmarks, finish() writes the collected results.
+class BenchmarkSuite
+{
+public:
+	unsigned int samples = 15;
+	double warmup_ms = 50.0;
+
+	BenchmarkSuite(int argc, char** argv)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			const char* value = i + 1 < argc ? argv[++i] : "";
+			if (arg == "--samples")
+				samples = std::max(1, std::atoi(value));
+			else if (arg == "--warmup-ms")
+				warmup_ms = std::atof(value);
+			else if (arg == "--pin")
+			{
+				if (!pin_current_thread(unsigned(std::atoi(value))))
+					std::printf("could not pin the benchmark thread to cpu %s\n", value);
+			}
+			else if (arg == "--json")
+				json_path = value;
+			else
+				std::printf(
+					"usage: %s [--samples 15] [--warmup-ms 50] [--pin cpu] [--json results.json]\n",
+					argv[0]);
+		}
+	}
+
+	template<typename Function>
+	const BenchmarkResult&
+	run(const std::string& name, size_t iterations, Function&& fn)
+	{
+		results.push_back(run_benchmark(name, iterations, std::forward<Function>(fn), samples, warmup_ms));
+		print_benchmark_result(results.back());
+		return results.back();
+	}
+
+	const std::vector<BenchmarkResult>&
+	get_results() const
+	{
+		return results;
+	}
+
+	// false if the JSON file could not be written
+	bool
+	finish() const
+	{
+		if (json_path.empty())
+			return true;
+		if (write_benchmark_json(json_path, results))
+			return true;
+		std::printf("failed to write %s\n", json_path.c_str());
+		return false;
+	}
+
+private:
+	std::string json_path;
+	std::vector<BenchmarkResult> results;
+};
@@ -0,0 +1,149 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <glm/glm.hpp>
+#include <learnopengl/camera.h>
+#include <learnopengl/model.h>
+
+struct Plane
+{
+	// unit vector
+	glm::vec3 normal = {0.0f, 1.0f, 0.0f};
+
+	// distance from origin to the nearest point in the plane
+	float distance = 0.0f;
+
+	Plane() = default;
+
+	Plane(const glm::vec3& point, const glm::vec3& norm)
+		: normal(glm::normalize(norm)), distance(glm::dot(normal, point)){};
+
+	float
+	get_signed_distance_to_plane(const glm::vec3& point) const
+	{
+		return glm::dot(normal, point) - distance;
+	}
+};
+
+struct Frustum
+{
+	Plane top_face;
+	Plane bottom_face;
+
+	Plane right_face;
+	Plane left_face;
+
+	Plane far_face;
+	Plane near_face;
+};
+
+inline Frustum
+create_frustum_from_camera(const Camera& cam, float aspect, float fov_y, float z_near, float z_far)
+{
+	Frustum frustum;
+	const float half_v_side = z_far * tanf(fov_y * 0.5f);
+	const float half_h_side = half_v_side * aspect;
+	const glm::vec3 front_mult_far = z_far * cam.Front;
+
+	frustum.near_face = {cam.Position + z_near * cam.Front, cam.Front};
+	frustum.far_face = {cam.Position + front_mult_far, -cam.Front};
+	frustum.right_face = {cam.Position, glm::cross(front_mult_far - cam.Right * half_h_side, cam.Up)};
+	frustum.left_face = {cam.Position, glm::cross(cam.Up, front_mult_far + cam.Right * half_h_side)};
+	frustum.top_face = {cam.Position, glm::cross(cam.Right, front_mult_far - cam.Up * half_v_side)};
+	frustum.bottom_face = {cam.Position, glm::cross(front_mult_far + cam.Up * half_v_side, cam.Right)};
+	return frustum;
+}
+
+// Axis aligned bounding box stored as center and half extents
+struct AABB
+{
+	glm::vec3 center = {0.0f, 0.0f, 0.0f};
+	glm::vec3 extents = {0.0f, 0.0f, 0.0f};
+
+	AABB() = default;
+
+	AABB(const glm::vec3& min, const glm::vec3& max) : center((max + min) * 0.5f), extents(max - center){};
+
+	glm::vec3
+	get_min() const
+	{
+		return center - extents;
+	}
+
+	glm::vec3
+	get_max() const
+	{
+		return center + extents;
+	}
+
+	// bounding box of this box after an affine transformation (Arvo's method)
+	AABB
+	transformed(const glm::mat4& model_matrix) const
+	{
+		AABB result;
+		result.center = glm::vec3(model_matrix * glm::vec4(center, 1.0f));
+		for (int i = 0; i < 3; ++i)
+		{
+			result.extents[i] = std::abs(model_matrix[0][i]) * extents.x + std::abs(model_matrix[1][i]) * extents.y +
+								std::abs(model_matrix[2][i]) * extents.z;
+		}
+		return result;
+	}
+
+	// slab test against a ray given by its origin and 1 / direction. distance is where the ray enters the box, 0 when
+	// it starts inside.
+	bool
+	intersects_ray(const glm::vec3& origin, const glm::vec3& inv_direction, float max_distance, float& distance) const
+	{
+		const glm::vec3 t0 = (get_min() - origin) * inv_direction;
+		const glm::vec3 t1 = (get_max() - origin) * inv_direction;
+		const glm::vec3 t_near = glm::min(t0, t1);
+		const glm::vec3 t_far = glm::max(t0, t1);
+		const float enter = std::max(std::max(t_near.x, t_near.y), std::max(t_near.z, 0.0f));
+		const float exit = std::min(std::min(t_far.x, t_far.y), std::min(t_far.z, max_distance));
+		distance = enter;
+		return enter <= exit;
+	}
+
+	bool
+	is_on_or_forward_plane(const Plane& plane) const
+	{
+		// compute the projection interval radius of the box onto the plane normal
+		const float r = extents.x * std::abs(plane.normal.x) + extents.y * std::abs(plane.normal.y) +
+						extents.z * std::abs(plane.normal.z);
+		return -r <= plane.get_signed_distance_to_plane(center);
+	}
+
+	// expects a box already in world space
+	bool
+	is_on_frustum(const Frustum& frustum) const
+	{
+		return is_on_or_forward_plane(frustum.left_face) && is_on_or_forward_plane(frustum.right_face) &&
+			   is_on_or_forward_plane(frustum.top_face) && is_on_or_forward_plane(frustum.bottom_face) &&
+			   is_on_or_forward_plane(frustum.near_face) && is_on_or_forward_plane(frustum.far_face);
+	}
+
+	bool
+	is_on_frustum(const Frustum& frustum, const glm::mat4& model_matrix) const
+	{
+		return transformed(model_matrix).is_on_frustum(frustum);
+	}
+};
+
+// local space bounds of every mesh of the model
+inline AABB
+generate_aabb(const Model& model)
+{
+	glm::vec3 min_aabb = glm::vec3(std::numeric_limits<float>::max());
+	glm::vec3 max_aabb = glm::vec3(std::numeric_limits<float>::lowest());
+	for (auto&& mesh : model.meshes)
+	{
+		min_aabb = glm::min(min_aabb, mesh.aabbMin);
+		max_aabb = glm::max(max_aabb, mesh.aabbMax);
+	}
+	if (model.meshes.empty())
+		return AABB();
+	return AABB(min_aabb, max_aabb);
+}
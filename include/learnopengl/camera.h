@@ -114,6 +114,16 @@ public:
 		updateCameraVectors();
 	}
 
+	// places the camera directly, e.g. along an authored path. Angles in degrees
+	void
+	SetPose(const glm::vec3& position, float yaw, float pitch)
+	{
+		Position = position;
+		Yaw = yaw;
+		Pitch = pitch;
+		updateCameraVectors();
+	}
+
 	// processes input received from a mouse scroll-wheel event. Only requires
 	// input on the vertical wheel-axis
 	void
@@ -0,0 +1,133 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/camera.h>
+
+// The per-frame camera data as the std140 block Camera of resources/shaders/camera.glsl lays it out: with only mat4
+// and vec4 members every offset is a multiple of 16 and the C++ struct matches it without padding.
+struct CameraUniformData
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 view_projection;
+	glm::mat4 inverse_view;
+	glm::mat4 inverse_projection;
+	glm::mat4 inverse_view_projection;
+	// xyz world space position, w unused
+	glm::vec4 position;
+	// width, height, 1 / width, 1 / height in pixels
+	glm::vec4 viewport;
+	// seconds since the start, frame time, near and far plane
+	glm::vec4 time;
+};
+static_assert(sizeof(CameraUniformData) == 6 * 64 + 3 * 16, "CameraUniformData must match the std140 layout");
+
+// One uniform buffer with the camera of the frame, bound once at a fixed binding point. Every program that includes
+// camera.glsl reads it from there, so a frame uploads the camera once instead of setting view and projection on every
+// program. GLSL 3.30 cannot pick the binding in the shader, bind_program() connects a program's block to it.
+class CameraUniforms
+{
+public:
+	static constexpr GLuint binding = 0;
+
+	CameraUniforms()
+	{
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraUniformData), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+	}
+
+	CameraUniforms(const CameraUniforms&) = delete;
+	CameraUniforms&
+	operator=(const CameraUniforms&) = delete;
+
+	~CameraUniforms()
+	{
+		glDeleteBuffers(1, &buffer);
+	}
+
+	// once per program, after linking; programs without the block are left alone
+	static void
+	bind_program(GLuint program)
+	{
+		const GLuint block = glGetUniformBlockIndex(program, "Camera");
+		if (block != GL_INVALID_INDEX)
+			glUniformBlockBinding(program, block, binding);
+	}
+
+	// once per frame, before drawing. The projection is only rebuilt when the zoom, the aspect or the planes change
+	void
+	update(
+		Camera& camera,
+		int width,
+		int height,
+		float time,
+		float delta_time,
+		float near_plane = 0.1f,
+		float far_plane = 100.0f)
+	{
+		const float aspect = float(width) / float(height > 0 ? height : 1);
+		if (camera.Zoom != projection_zoom || aspect != projection_aspect || near_plane != data.time.z ||
+			far_plane != data.time.w)
+		{
+			projection_zoom = camera.Zoom;
+			projection_aspect = aspect;
+			data.projection = glm::perspective(glm::radians(camera.Zoom), aspect, near_plane, far_plane);
+			data.inverse_projection = glm::inverse(data.projection);
+		}
+		data.view = camera.GetViewMatrix();
+		data.inverse_view = glm::inverse(data.view);
+		data.position = glm::vec4(camera.Position, 1.0f);
+		finish(width, height, time, delta_time, near_plane, far_plane);
+	}
+
+	// for cameras that are not a Camera, e.g. the light of a shadow pass
+	void
+	update(
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		int width,
+		int height,
+		float time,
+		float delta_time,
+		float near_plane,
+		float far_plane)
+	{
+		data.view = view;
+		data.inverse_view = glm::inverse(view);
+		data.projection = projection;
+		data.inverse_projection = glm::inverse(projection);
+		data.position = data.inverse_view[3];
+		// a later update from a Camera rebuilds its projection
+		projection_zoom = 0.0f;
+		finish(width, height, time, delta_time, near_plane, far_plane);
+	}
+
+	const CameraUniformData&
+	get_data() const
+	{
+		return data;
+	}
+
+private:
+	GLuint buffer = 0;
+	CameraUniformData data{};
+	float projection_zoom = 0.0f;
+	float projection_aspect = 0.0f;
+
+	void
+	finish(int width, int height, float time, float delta_time, float near_plane, float far_plane)
+	{
+		data.view_projection = data.projection * data.view;
+		data.inverse_view_projection = data.inverse_view * data.inverse_projection;
+		data.viewport = glm::vec4(float(width), float(height), 1.0f / float(width), 1.0f / float(height));
+		data.time = glm::vec4(time, delta_time, near_plane, far_plane);
+		glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraUniformData), &data);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+};
@@ -0,0 +1,408 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_access.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/bounding_volume.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/shader.h>
+
+// Cascaded shadow maps of a directional light, sampled by resources/shaders/shadows.glsl. The view range is split in
+// depth into slices, each covered by an orthographic shadow map in one layer of a depth texture array: near slices get
+// small texels, far slices large ones.
+//
+// A cascade is fit to the bounding sphere of its slice, whose size does not change when the camera turns, and its
+// origin is snapped to whole texels, so the texels stay in place while the camera moves and shadow edges do not
+// shimmer. The cascades from cached_from on are made larger than their slice by cache_margin and are kept as long as
+// the slice stays inside. Their static casters are drawn into a layer of their own, only again when the camera leaves
+// the cascade or the light turns; when moving casters inside them move (invalidate()), the layer is copied and only
+// the moving casters are drawn over the copy. The far cascades, which cover most of the scene, then cost nothing in
+// most frames and no more than a copy and a few draws in the others.
+class CascadedShadowMap
+{
+public:
+	static constexpr unsigned int max_cascades = 4;
+
+	// 0 splits the view range uniformly, 1 logarithmically; in between blends both (the practical split scheme)
+	float split_lambda = 0.75f;
+	// the cascades before this one follow the camera exactly and are rendered every frame
+	unsigned int cached_from = 1;
+	// extra size of the cached cascades, relative to the radius of their slice
+	float cache_margin = 0.25f;
+
+	explicit CascadedShadowMap(int resolution = 2048, unsigned int cascade_count = max_cascades)
+		: resolution(resolution), cascade_count(std::min(std::max(cascade_count, 1u), max_cascades))
+	{
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+		glTexImage3D(
+			GL_TEXTURE_2D_ARRAY,
+			0,
+			GL_DEPTH_COMPONENT32F,
+			resolution,
+			resolution,
+			2 * this->cascade_count,
+			0,
+			GL_DEPTH_COMPONENT,
+			GL_FLOAT,
+			NULL);
+		// depth comparison with bilinear filtering, 2x2 PCF for every lookup. Outside of the map nothing is shadowed
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+		const float border[] = {1.0f, 1.0f, 1.0f, 1.0f};
+		glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+		glGenFramebuffers(1, &framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0, 0);
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			std::cout << "ERROR::CASCADED_SHADOW_MAP::FRAMEBUFFER_NOT_COMPLETE" << std::endl;
+
+		// reads the static layers for the copies
+		glGenFramebuffers(1, &copy_framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, copy_framebuffer);
+		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0, this->cascade_count);
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	~CascadedShadowMap()
+	{
+		glDeleteFramebuffers(1, &copy_framebuffer);
+		glDeleteFramebuffers(1, &framebuffer);
+		glDeleteTextures(1, &texture);
+	}
+
+	CascadedShadowMap(const CascadedShadowMap&) = delete;
+	CascadedShadowMap&
+	operator=(const CascadedShadowMap&) = delete;
+
+	// places the cascades for this frame. Every caster must be inside scene_bounds: the depth range of the cascades
+	// covers it, so casters between the light and the view are not clipped
+	void
+	update(
+		const Camera& camera,
+		float aspect,
+		float near_plane,
+		float far_plane,
+		const glm::vec3& light_direction,
+		const AABB& scene_bounds)
+	{
+		const glm::vec3 direction = glm::normalize(light_direction);
+		if (direction != this->light_direction)
+		{
+			this->light_direction = direction;
+			const glm::vec3 up =
+				std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+			light_view = glm::lookAt(glm::vec3(0.0f), direction, up);
+			invalidate();
+		}
+
+		// depth range of the scene in light space, looking down -z
+		scene_min_z = std::numeric_limits<float>::max();
+		scene_max_z = -std::numeric_limits<float>::max();
+		for (int i = 0; i < 8; ++i)
+		{
+			const glm::vec3 sign(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f);
+			const glm::vec3 corner = scene_bounds.center + scene_bounds.extents * sign;
+			const float z = glm::dot(glm::vec3(glm::row(light_view, 2)), corner);
+			scene_min_z = std::min(scene_min_z, z);
+			scene_max_z = std::max(scene_max_z, z);
+		}
+
+		const float tan_y = std::tan(glm::radians(camera.Zoom) * 0.5f);
+		const float tan_x = tan_y * aspect;
+		float slice_near = near_plane;
+		static_renders = 0;
+		dynamic_renders = 0;
+		for (unsigned int i = 0; i < cascade_count; ++i)
+		{
+			const float fraction = float(i + 1) / float(cascade_count);
+			const float log_split = near_plane * std::pow(far_plane / near_plane, fraction);
+			const float uniform_split = near_plane + (far_plane - near_plane) * fraction;
+			const float slice_far = glm::mix(uniform_split, log_split, split_lambda);
+			fit(cascades[i], camera, tan_x * tan_x + tan_y * tan_y, slice_near, slice_far, i >= cached_from);
+			cascades[i].split = slice_far;
+			slice_near = slice_far;
+		}
+	}
+
+	// every cascade is rendered again, e.g. after the static geometry changed
+	void
+	invalidate()
+	{
+		for (Cascade& cascade : cascades)
+			cascade.static_dirty = true;
+	}
+
+	// the cascades whose casters may overlap the bounds draw their moving casters again. A moving caster invalidates
+	// both where it was and where it is, for its old shadow to disappear
+	void
+	invalidate(const AABB& bounds)
+	{
+		for (unsigned int i = 0; i < cascade_count; ++i)
+		{
+			if (!cascades[i].dynamic_dirty && bounds.is_on_frustum(cascades[i].casters))
+				cascades[i].dynamic_dirty = true;
+		}
+	}
+
+	// binds the layer of the static casters of the cascade and clears it, false when it is up to date and nothing
+	// must be drawn. The casters are drawn with get_light_matrix(cascade), found with get_caster_frustum(cascade),
+	// then end_render() is called
+	bool
+	begin_static(unsigned int cascade)
+	{
+		if (!cascades[cascade].static_dirty)
+			return false;
+		// a cascade that is not cached has no layer of its own for them, the moving casters are drawn over them next
+		bind_layer(cascade < cached_from ? cascade : cascade_count + cascade);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		current = cascade;
+		current_static = true;
+		return true;
+	}
+
+	// binds the layer the shadows are sampled from, with the static casters already in it, for the moving casters.
+	// False when it is up to date and nothing must be drawn
+	bool
+	begin_dynamic(unsigned int cascade)
+	{
+		if (!cascades[cascade].dynamic_dirty)
+			return false;
+		if (cascade >= cached_from)
+		{
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, copy_framebuffer);
+			glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0, cascade_count + cascade);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+			glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0, cascade);
+			glBlitFramebuffer(
+				0,
+				0,
+				resolution,
+				resolution,
+				0,
+				0,
+				resolution,
+				resolution,
+				GL_DEPTH_BUFFER_BIT,
+				GL_NEAREST);
+		}
+		bind_layer(cascade);
+		current = cascade;
+		current_static = false;
+		return true;
+	}
+
+	void
+	end_render()
+	{
+		glDisable(GL_POLYGON_OFFSET_FILL);
+		glDisable(GL_DEPTH_CLAMP);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		Cascade& cascade = cascades[current];
+		if (current_static)
+		{
+			cascade.static_dirty = false;
+			cascade.dynamic_dirty = true;
+			++static_renders;
+		}
+		else
+		{
+			cascade.dynamic_dirty = false;
+			++dynamic_renders;
+		}
+	}
+
+	// sets the uniforms of shadows.glsl, the depth texture bound to the unit
+	void
+	bind(const Shader& shader, int texture_unit) const
+	{
+		glActiveTexture(GL_TEXTURE0 + texture_unit);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+		shader.setInt("shadowMap", texture_unit);
+		shader.setInt("cascadeCount", int(cascade_count));
+		shader.setVec3("lightDirection", light_direction);
+		for (unsigned int i = 0; i < cascade_count; ++i)
+		{
+			const std::string index = "[" + std::to_string(i) + "]";
+			shader.setMat4("lightSpaceMatrices" + index, cascades[i].light_matrix);
+			shader.setFloat("cascadeSplits" + index, cascades[i].split);
+			shader.setFloat("cascadeTexelSizes" + index, cascades[i].texel_size);
+		}
+	}
+
+	const glm::mat4&
+	get_light_matrix(unsigned int cascade) const
+	{
+		return cascades[cascade].light_matrix;
+	}
+
+	// the box of the cascade, stretched toward the light over the scene: what can cast a shadow into the cascade
+	const Frustum&
+	get_caster_frustum(unsigned int cascade) const
+	{
+		return cascades[cascade].casters;
+	}
+
+	// view distance at which the cascade ends
+	float
+	get_split(unsigned int cascade) const
+	{
+		return cascades[cascade].split;
+	}
+
+	unsigned int
+	get_cascade_count() const
+	{
+		return cascade_count;
+	}
+
+	// static casters drawn into a cascade since the last update(), the expensive case
+	unsigned int
+	get_static_render_count() const
+	{
+		return static_renders;
+	}
+
+	// moving casters drawn into a cascade since the last update()
+	unsigned int
+	get_dynamic_render_count() const
+	{
+		return dynamic_renders;
+	}
+
+	GLuint
+	get_texture() const
+	{
+		return texture;
+	}
+
+private:
+	struct Cascade
+	{
+		glm::mat4 light_matrix = glm::mat4(1.0f);
+		Frustum casters;
+		float split = 0.0f;
+		float texel_size = 0.0f;
+
+		// light space box: center, half size and depth range, and the radius of the slice it was fit to
+		glm::vec2 center = glm::vec2(0.0f);
+		float half_size = 0.0f;
+		float min_z = 0.0f;
+		float max_z = 0.0f;
+		float radius = 0.0f;
+
+		// whether the static casters have a layer of their own
+		bool cached = false;
+		// whether the static casters must be drawn again, and the moving ones
+		bool static_dirty = true;
+		bool dynamic_dirty = true;
+	};
+
+	int resolution;
+	unsigned int cascade_count;
+	GLuint texture = 0;
+	GLuint framebuffer = 0;
+	GLuint copy_framebuffer = 0;
+
+	Cascade cascades[max_cascades];
+	glm::vec3 light_direction = glm::vec3(0.0f);
+	glm::mat4 light_view = glm::mat4(1.0f);
+	float scene_min_z = 0.0f;
+	float scene_max_z = 0.0f;
+	unsigned int static_renders = 0;
+	unsigned int dynamic_renders = 0;
+	unsigned int current = 0;
+	bool current_static = false;
+
+	// binds a layer of the texture as the depth target of the casters
+	void
+	bind_layer(unsigned int layer)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0, layer);
+		glViewport(0, 0, resolution, resolution);
+		glEnable(GL_DEPTH_TEST);
+		// casters in front of the near plane still cast, at depth 0
+		glEnable(GL_DEPTH_CLAMP);
+		// slope scaled bias against acne, the receivers add a normal offset
+		glEnable(GL_POLYGON_OFFSET_FILL);
+		glPolygonOffset(2.0f, 4.0f);
+	}
+
+	// fits the cascade to the slice of the view between two distances. tan2 is the squared tangent of the half
+	// diagonal field of view
+	void
+	fit(Cascade& cascade, const Camera& camera, float tan2, float slice_near, float slice_far, bool cached)
+	{
+		// the smallest sphere through the corners of the slice has its center on the view axis, where the near and
+		// the far corners are at the same distance; for wide slices that is beyond the far plane, then the far
+		// corners alone bound it
+		float center_distance = 0.5f * (slice_near + slice_far) * (1.0f + tan2);
+		center_distance = std::min(center_distance, slice_far);
+		float radius = std::sqrt(
+			slice_far * slice_far * tan2 + (slice_far - center_distance) * (slice_far - center_distance));
+		// rounded up, so float noise does not change the size of the texels
+		radius = std::ceil(radius * 16.0f) / 16.0f;
+
+		const glm::vec3 world_center = camera.Position + camera.Front * center_distance;
+		const glm::vec3 center = glm::vec3(light_view * glm::vec4(world_center, 1.0f));
+		const float min_z = std::min(scene_min_z, center.z - radius);
+		const float max_z = std::max(scene_max_z, center.z + radius);
+
+		// a cached cascade is kept while the slice and the scene stay inside it
+		if (cached && cascade.cached && !cascade.static_dirty && radius == cascade.radius &&
+			min_z >= cascade.min_z && max_z <= cascade.max_z &&
+			std::abs(center.x - cascade.center.x) + radius <= cascade.half_size &&
+			std::abs(center.y - cascade.center.y) + radius <= cascade.half_size)
+			return;
+
+		cascade.cached = cached;
+		cascade.radius = radius;
+		cascade.half_size = cached ? radius * (1.0f + cache_margin) : radius;
+		cascade.texel_size = 2.0f * cascade.half_size / float(resolution);
+		// the box moves in whole texels, its texels cover the same world positions from frame to frame
+		cascade.center = glm::floor(glm::vec2(center.x, center.y) / cascade.texel_size) * cascade.texel_size;
+		cascade.min_z = min_z;
+		cascade.max_z = max_z;
+		cascade.static_dirty = true;
+
+		const float h = cascade.half_size;
+		const glm::mat4 projection = glm::ortho(
+			cascade.center.x - h,
+			cascade.center.x + h,
+			cascade.center.y - h,
+			cascade.center.y + h,
+			-max_z,
+			-min_z);
+		cascade.light_matrix = projection * light_view;
+
+		// the same box in world space, its planes facing inward
+		const glm::vec3 right = glm::vec3(glm::row(light_view, 0));
+		const glm::vec3 up = glm::vec3(glm::row(light_view, 1));
+		const glm::vec3 back = glm::vec3(glm::row(light_view, 2));
+		const glm::vec3 origin = right * cascade.center.x + up * cascade.center.y;
+		cascade.casters.left_face = {origin - right * h, right};
+		cascade.casters.right_face = {origin + right * h, -right};
+		cascade.casters.bottom_face = {origin - up * h, up};
+		cascade.casters.top_face = {origin + up * h, -up};
+		cascade.casters.near_face = {origin + back * max_z, -back};
+		cascade.casters.far_face = {origin + back * min_z, back};
+	}
+};
@@ -4,6 +4,8 @@
 #include <GLFW/glfw3.h>
 #include <iostream>
 
+#include <learnopengl/headless.h>
+
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 
@@ -35,8 +37,10 @@ void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
   glViewport(0, 0, width, height);
 }
 
-// glfw: create,initialization and configue GLFW window
-GLFWwindow *create_glfw_window(const char *title, int width, int height) {
+// glfw: create,initialization and configue GLFW window, invisible when the
+// demo runs headless
+GLFWwindow *create_glfw_window(const char *title, int width, int height,
+                               const HeadlessRun &headless = HeadlessRun(HeadlessOptions())) {
   // glfw:initialization and configuration
   //-------------------------------------------------------
   glfwInit();
@@ -47,6 +51,7 @@ GLFWwindow *create_glfw_window(const char *title, int width, int height) {
 #ifdef __APPLE__
   glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+  headless.apply_window_hints();
 
   // glfw: window creation
   //-------------------------------------------------------
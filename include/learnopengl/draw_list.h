@@ -0,0 +1,297 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <unordered_set>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <learnopengl/entity.h>
+#include <learnopengl/job_system.h>
+#include <learnopengl/ring_buffer.h>
+#include <learnopengl/spatial_index.h>
+
+// Everything the render thread needs to issue one draw call
+struct DrawPacket
+{
+	Model* model;
+	glm::mat4 model_matrix;
+	glm::vec4 tint;
+
+	// distance to the viewer, used to sort front to back
+	float depth;
+};
+
+// Per-draw data as the vertex shader reads it with DRAW_RECORDS: instanced attributes fetched from a
+// PersistentRingBuffer, the base instance of the draw call selecting its record
+struct DrawRecord
+{
+	glm::mat4 model_matrix;
+	glm::vec4 tint;
+};
+
+// first attribute location of a DrawRecord, after those of Vertex; the matrix takes four
+constexpr GLuint draw_record_location = 7;
+
+// Draw packets produced by a single thread. Only the owning thread writes to it while building.
+struct DrawList
+{
+	std::vector<DrawPacket> packets;
+
+	// number of entities visited while building this list
+	unsigned int total = 0;
+};
+
+inline bool
+draw_packet_less(const DrawPacket& a, const DrawPacket& b)
+{
+	// group by model to keep state changes low, then front to back for early depth rejection
+	if (a.model != b.model)
+		return a.model < b.model;
+	return a.depth < b.depth;
+}
+
+// Splits scene traversal, frustum culling, LOD selection and draw packet generation over the threads of a
+// JobSystem, each writing to its own DrawList. The GL thread then merges and executes the lists in submit().
+class DrawListBuilder
+{
+public:
+	// view distances at which entities switch to the next level of detail
+	std::vector<float> lod_distances;
+
+	explicit DrawListBuilder(JobSystem& job_system) : job_system(job_system), lists(job_system.get_thread_count()){};
+
+	// fill the draw lists for the entities of the tree visible from the frustum. The transforms of the tree must be
+	// up to date and must not change until this returns.
+	void
+	build(const Entity& root, const Frustum& frustum, const glm::vec3& view_pos)
+	{
+		current_frustum = &frustum;
+		current_view_pos = view_pos;
+		collect_work_items(root);
+		clear_lists();
+
+		job_system.parallel_for(0, items.size(), 1, [this](size_t first, size_t last) {
+			DrawList& list = lists[job_system.get_thread_index()];
+			for (size_t i = first; i < last; ++i)
+			{
+				if (items[i].recurse)
+					visit(*items[i].entity, list);
+				else
+					emit(*items[i].entity, list);
+			}
+		});
+		sort_lists();
+	}
+
+	// same as above with the candidates found by the spatial index instead of a walk over the whole tree, total is
+	// then the number of candidates tested
+	void
+	build(const EntitySpatialIndex& index, const Frustum& frustum, const glm::vec3& view_pos)
+	{
+		current_frustum = &frustum;
+		current_view_pos = view_pos;
+		candidates.clear();
+		index.query(frustum, [this](Entity& entity) {
+			candidates.push_back(&entity);
+			return true;
+		});
+		clear_lists();
+
+		job_system.parallel_for(0, candidates.size(), 0, [this](size_t first, size_t last) {
+			DrawList& list = lists[job_system.get_thread_index()];
+			for (size_t i = first; i < last; ++i)
+				emit(*candidates[i], list);
+		});
+		sort_lists();
+	}
+
+	// merge the per thread lists and draw them, setting the per-draw uniforms. Must be called from the thread owning
+	// the GL context.
+	void
+	submit(Shader& shader)
+	{
+		merge_lists();
+		for (auto&& packet : merged)
+		{
+			shader.setMat4("model", packet.model_matrix);
+			shader.setVec4("tint", packet.tint);
+			packet.model->Draw(shader);
+		}
+	}
+
+	// same as above, the per-draw data written into this frame's region of the ring instead, for a shader compiled
+	// with DRAW_RECORDS. Nothing is drawn if the region is too small for the records of all the packets.
+	void
+	submit(Shader& shader, PersistentRingBuffer& ring)
+	{
+		merge_lists();
+		DrawRecord* records =
+			static_cast<DrawRecord*>(ring.allocate(merged.size() * sizeof(DrawRecord), sizeof(DrawRecord)));
+		if (!records)
+		{
+			std::cout << "ERROR::DRAW_LIST::RING_BUFFER_FULL: " << merged.size() << " draws" << std::endl;
+			return;
+		}
+
+		const unsigned int first_record = static_cast<unsigned int>(ring.get_offset() / sizeof(DrawRecord));
+		for (size_t i = 0; i < merged.size(); ++i)
+			records[i] = {merged[i].model_matrix, merged[i].tint};
+		for (size_t i = 0; i < merged.size(); ++i)
+		{
+			attach_records(*merged[i].model, ring.get_buffer());
+			merged[i].model->Draw(shader, first_record + static_cast<unsigned int>(i));
+		}
+	}
+
+	const std::vector<DrawList>&
+	get_lists() const
+	{
+		return lists;
+	}
+
+	unsigned int
+	get_total() const
+	{
+		unsigned int total = 0;
+		for (auto&& list : lists)
+			total += list.total;
+		return total;
+	}
+
+	unsigned int
+	get_visible() const
+	{
+		size_t visible = 0;
+		for (auto&& list : lists)
+			visible += list.packets.size();
+		return static_cast<unsigned int>(visible);
+	}
+
+private:
+	struct WorkItem
+	{
+		const Entity* entity;
+
+		// false when the children of the entity are queued as separate items
+		bool recurse;
+	};
+
+	JobSystem& job_system;
+	std::vector<DrawList> lists;
+	std::vector<DrawPacket> merged;
+	std::vector<WorkItem> items;
+	std::vector<const Entity*> candidates;
+	// vertex arrays already reading their DrawRecord from the ring
+	std::unordered_set<unsigned int> attached_vaos;
+
+	const Frustum* current_frustum = nullptr;
+	glm::vec3 current_view_pos = glm::vec3(0.0f);
+
+	void
+	merge_lists()
+	{
+		merged.clear();
+		for (auto&& list : lists)
+		{
+			// every list is already sorted by its worker, a k-way merge keeps the whole result sorted
+			const auto middle = merged.insert(merged.end(), list.packets.begin(), list.packets.end());
+			std::inplace_merge(merged.begin(), middle, merged.end(), draw_packet_less);
+		}
+	}
+
+	// points the per-instance attributes of the model's meshes at the records, once per vertex array
+	void
+	attach_records(const Model& model, GLuint buffer)
+	{
+		for (const Mesh& mesh : model.meshes)
+		{
+			if (!attached_vaos.insert(mesh.VAO).second)
+				continue;
+			glBindVertexArray(mesh.VAO);
+			glBindBuffer(GL_ARRAY_BUFFER, buffer);
+			for (GLuint column = 0; column < 5; ++column)
+			{
+				const size_t offset = column < 4 ? offsetof(DrawRecord, model_matrix) + column * sizeof(glm::vec4)
+												 : offsetof(DrawRecord, tint);
+				glEnableVertexAttribArray(draw_record_location + column);
+				glVertexAttribPointer(
+					draw_record_location + column,
+					4,
+					GL_FLOAT,
+					GL_FALSE,
+					sizeof(DrawRecord),
+					reinterpret_cast<void*>(offset));
+				glVertexAttribDivisor(draw_record_location + column, 1);
+			}
+			glBindVertexArray(0);
+		}
+	}
+
+	void
+	clear_lists()
+	{
+		for (auto&& list : lists)
+		{
+			list.packets.clear();
+			list.total = 0;
+		}
+	}
+
+	void
+	sort_lists()
+	{
+		job_system.parallel_for(0, lists.size(), 1, [this](size_t first, size_t last) {
+			for (size_t i = first; i < last; ++i)
+				std::sort(lists[i].packets.begin(), lists[i].packets.end(), draw_packet_less);
+		});
+	}
+
+	// split the top of the tree until there are enough independent subtrees to keep every thread busy
+	void
+	collect_work_items(const Entity& root)
+	{
+		const size_t target = lists.size() * 8;
+		items.clear();
+		items.push_back({&root, true});
+
+		for (size_t i = 0; i < items.size() && items.size() < target; ++i)
+		{
+			if (!items[i].recurse || items[i].entity->children.empty())
+				continue;
+			items[i].recurse = false;
+			for (auto&& child : items[i].entity->children)
+				items.push_back({child.get(), true});
+		}
+	}
+
+	void
+	visit(const Entity& entity, DrawList& list)
+	{
+		emit(entity, list);
+		for (auto&& child : entity.children)
+			visit(*child, list);
+	}
+
+	void
+	emit(const Entity& entity, DrawList& list)
+	{
+		++list.total;
+		const glm::mat4& model_matrix = entity.transform.get_model_matrix();
+		const AABB global_volume = entity.bounding_volume.transformed(model_matrix);
+		if (!global_volume.is_on_frustum(*current_frustum))
+			return;
+
+		const float depth = glm::length(global_volume.center - current_view_pos);
+		list.packets.push_back({entity.get_lod_model(select_lod(depth)), model_matrix, entity.tint, depth});
+	}
+
+	unsigned int
+	select_lod(float depth) const
+	{
+		unsigned int lod = 0;
+		while (lod < lod_distances.size() && depth > lod_distances[lod])
+			++lod;
+		return lod;
+	}
+};
@@ -0,0 +1,161 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+// GL_TIME_ELAPSED queries in a ring, read back a few frames later without waiting for the GPU
+class GpuTimer
+{
+public:
+	static constexpr size_t query_count = 4;
+
+	GpuTimer()
+	{
+		glGenQueries(GLsizei(query_count), queries.data());
+	}
+
+	GpuTimer(const GpuTimer&) = delete;
+	GpuTimer& operator=(const GpuTimer&) = delete;
+
+	~GpuTimer()
+	{
+		glDeleteQueries(GLsizei(query_count), queries.data());
+	}
+
+	// frame numbers the measurement, poll() hands it back with the result
+	void
+	begin(uint64_t frame)
+	{
+		// the ring is full, drop the oldest measurement rather than stall
+		if (pending == query_count)
+		{
+			--pending;
+			++oldest;
+		}
+		const size_t slot = (oldest + pending) % query_count;
+		frames[slot] = frame;
+		glBeginQuery(GL_TIME_ELAPSED, queries[slot]);
+	}
+
+	void
+	end()
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		++pending;
+	}
+
+	// oldest finished measurement, false if the GPU has not reached it yet
+	bool
+	poll(double& milliseconds, uint64_t& frame)
+	{
+		if (pending == 0)
+			return false;
+		const size_t slot = oldest % query_count;
+		GLint available = 0;
+		glGetQueryObjectiv(queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			return false;
+
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &elapsed);
+		milliseconds = elapsed / 1e6;
+		frame = frames[slot];
+		++oldest;
+		--pending;
+		return true;
+	}
+
+private:
+	std::array<GLuint, query_count> queries{};
+	std::array<uint64_t, query_count> frames{};
+	size_t oldest = 0;
+	size_t pending = 0;
+};
+
+// Picks the render scale of the scene from its measured GPU time. The cost is taken as proportional to the pixel
+// count, so the scale that fits the budget is the measured one times sqrt(budget / time). Going over the budget
+// lowers the scale at once, being under it raises the scale by at most max_increase per frame, so a load spike costs
+// a frame or two and the resolution comes back smoothly once it is over. The scale moves in steps of scale_step to
+// keep the number of render target sizes small.
+class DynamicResolution
+{
+public:
+	float target_ms;
+	float min_scale;
+	float max_scale;
+	// fraction of the target aimed for, leaves room for the passes that are not measured and for noise
+	float headroom = 0.9f;
+	float max_increase = 0.02f;
+	static constexpr float scale_step = 0.05f;
+
+	explicit DynamicResolution(float target_ms = 1000.0f / 60.0f, float min_scale = 0.5f, float max_scale = 1.0f)
+		: target_ms(target_ms), min_scale(min_scale), max_scale(max_scale), raw_scale(max_scale), scale(max_scale)
+	{
+	}
+
+	// scale to render the given frame with; remembered so the measurement of that frame can be related to it
+	float
+	begin_frame(uint64_t frame)
+	{
+		history[frame % history.size()] = scale;
+		return scale;
+	}
+
+	// GPU time of an earlier frame, as returned by GpuTimer::poll()
+	void
+	update(double milliseconds, uint64_t frame)
+	{
+		// frames measured at different scales are compared through their cost at full scale
+		const float measured_scale = history[frame % history.size()];
+		const double full_scale_ms = milliseconds / (double(measured_scale) * measured_scale);
+		const double budget = target_ms * headroom;
+
+		if (milliseconds > target_ms || !has_measurement)
+		{
+			// over budget: straight to the scale that would have fit, and forget the cheaper history
+			filtered_ms = full_scale_ms;
+			raw_scale = float(std::sqrt(budget / filtered_ms));
+		}
+		else
+		{
+			filtered_ms += (full_scale_ms - filtered_ms) * 0.2;
+			const float ideal = float(std::sqrt(budget / std::max(filtered_ms, 0.01)));
+			raw_scale = ideal < raw_scale ? ideal : std::min(ideal, raw_scale + max_increase);
+		}
+		has_measurement = true;
+		raw_scale = std::clamp(raw_scale, min_scale, max_scale);
+		scale = std::max(min_scale, std::floor(raw_scale / scale_step + 1e-3f) * scale_step);
+	}
+
+	float
+	get_scale() const
+	{
+		return scale;
+	}
+
+	// size of a target covering size pixels at full scale
+	int
+	scaled(int size) const
+	{
+		return std::max(1, int(std::lround(size * scale)));
+	}
+
+	// smoothed GPU time the scene would take at full scale
+	double
+	get_full_scale_ms() const
+	{
+		return filtered_ms;
+	}
+
+private:
+	// unquantized controller state and the scale actually used
+	float raw_scale;
+	float scale;
+	double filtered_ms = 0.0;
+	bool has_measurement = false;
+	// scale of the recent frames, the GPU times arrive a few frames late
+	std::array<float, 8> history{};
+};
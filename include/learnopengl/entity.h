@@ -1,9 +1,21 @@
 #pragma once
+#include <algorithm>
 #include <list>
 #include <memory>
+#include <vector>
 
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <learnopengl/model.h>
+#include <learnopengl/bounding_volume.h>
+#include <learnopengl/job_system.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define TRANSFORM_USE_SSE 1
+#endif
+
+class Entity;
 
 struct Transform
 {
@@ -13,31 +25,30 @@ struct Transform
 	glm::vec3 m_eular_rot = {0.0f, 0.0f, 0.0f};
 	glm::vec3 m_scale = {1.0f, 1.0, 1.0f};
 
+	// rotation used to build the matrix, kept in sync with the euler angles (in degrees) by set_local_rotation
+	glm::quat m_rot = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+
 	// Global space information concatenate in matrix
 	glm::mat4 model_matrix = glm::mat4(1.0f);
 
 	// Dirty flag
 	bool is_dirty = true;
 
-protected:
+	// entity owning this transform and the list it registers in when it becomes dirty, both optional
+	Entity* owner = nullptr;
+	std::vector<Entity*>* dirty_list = nullptr;
+
 	glm::mat4
-	get_local_model_matrix()
+	get_local_model_matrix() const
 	{
-		// get rotation matrix from euler angles
-		glm::mat4 transform_x = glm::rotate(glm::mat4(1.0), glm::radians(m_eular_rot.x), glm::vec3(1.0f, 0.0f, 0.0f));
-		glm::mat4 transform_y = glm::rotate(glm::mat4(1.0), glm::radians(m_eular_rot.y), glm::vec3(0.0f, 1.0f, 0.0f));
-		glm::mat4 transform_z = glm::rotate(glm::mat4(1.0), glm::radians(m_eular_rot.z), glm::vec3(0.0f, 0.0f, 1.0f));
-
-		// Y * X * Z
-		glm::mat4 rotation_matrix = transform_y * transform_x * transform_z;
-
-		// translation matrix
-		glm::mat4 translate_matrix = glm::translate(glm::mat4(1.0), m_pos);
-
-		glm::mat4 scale_matrix = glm::scale(glm::mat4(1.0), m_scale);
-
-		// translation * rotation * scale (also know as TRS matrix)
-		return (translate_matrix * rotation_matrix * scale_matrix);
+		// translation * rotation * scale (also know as TRS matrix), written out directly instead of multiplying the
+		// three matrices
+		const glm::mat3 rotation_matrix = glm::mat3_cast(m_rot);
+		return glm::mat4(
+			glm::vec4(rotation_matrix[0] * m_scale.x, 0.0f),
+			glm::vec4(rotation_matrix[1] * m_scale.y, 0.0f),
+			glm::vec4(rotation_matrix[2] * m_scale.z, 0.0f),
+			glm::vec4(m_pos, 1.0f));
 	}
 
 public:
@@ -59,20 +70,36 @@ public:
 	set_local_position(const glm::vec3& pos)
 	{
 		m_pos = pos;
-		is_dirty = true;
+		mark_dirty();
 	}
 
 	void
 	set_local_rotation(const glm::vec3& rot)
 	{
 		m_eular_rot = rot;
-		is_dirty = true;
+
+		// Y * X * Z
+		m_rot = glm::angleAxis(glm::radians(rot.y), glm::vec3(0.0f, 1.0f, 0.0f)) *
+				glm::angleAxis(glm::radians(rot.x), glm::vec3(1.0f, 0.0f, 0.0f)) *
+				glm::angleAxis(glm::radians(rot.z), glm::vec3(0.0f, 0.0f, 1.0f));
+		mark_dirty();
 	}
 	void
 	set_local_scale(const glm::vec3& scale)
 	{
 		m_scale = scale;
+		mark_dirty();
+	}
+
+	// a transform is registered once, when it goes from clean to dirty
+	void
+	mark_dirty()
+	{
+		if (is_dirty)
+			return;
 		is_dirty = true;
+		if (dirty_list)
+			dirty_list->push_back(owner);
 	}
 
 	const glm::vec3&
@@ -93,6 +120,12 @@ public:
 		return m_eular_rot;
 	}
 
+	const glm::quat&
+	get_local_rotation_quat() const
+	{
+		return m_rot;
+	}
+
 	const glm::mat4&
 	get_model_matrix() const
 	{
@@ -100,17 +133,88 @@ public:
 	}
 };
 
-struct Plane{
-	glm::vec3 Normal;
+// Computes model_matrix = parent_model_matrix * TRS for count transforms sharing the same parent. With SSE four
+// transforms are composed at once in structure of arrays form; the parent product only uses the affine 3x4 part
+// since every matrix of the hierarchy is affine. The last group is padded so every transform takes the same path.
+inline void
+compute_model_matrices(Transform* const* transforms, size_t count, const glm::mat4& parent_model_matrix)
+{
+	if (count == 0)
+		return;
 
-};
+#ifdef TRANSFORM_USE_SSE
+	// parent[column][row] broadcast to every lane
+	__m128 parent[4][3];
+	for (int c = 0; c < 4; ++c)
+		for (int r = 0; r < 3; ++r)
+			parent[c][r] = _mm_set1_ps(parent_model_matrix[c][r]);
+
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	for (size_t i = 0; i < count; i += 4)
+	{
+		Transform* t[4];
+		for (size_t lane = 0; lane < 4; ++lane)
+			t[lane] = transforms[std::min(i + lane, count - 1)];
+
+		const __m128 qx = _mm_setr_ps(t[0]->m_rot.x, t[1]->m_rot.x, t[2]->m_rot.x, t[3]->m_rot.x);
+		const __m128 qy = _mm_setr_ps(t[0]->m_rot.y, t[1]->m_rot.y, t[2]->m_rot.y, t[3]->m_rot.y);
+		const __m128 qz = _mm_setr_ps(t[0]->m_rot.z, t[1]->m_rot.z, t[2]->m_rot.z, t[3]->m_rot.z);
+		const __m128 qw = _mm_setr_ps(t[0]->m_rot.w, t[1]->m_rot.w, t[2]->m_rot.w, t[3]->m_rot.w);
+		const __m128 sx = _mm_setr_ps(t[0]->m_scale.x, t[1]->m_scale.x, t[2]->m_scale.x, t[3]->m_scale.x);
+		const __m128 sy = _mm_setr_ps(t[0]->m_scale.y, t[1]->m_scale.y, t[2]->m_scale.y, t[3]->m_scale.y);
+		const __m128 sz = _mm_setr_ps(t[0]->m_scale.z, t[1]->m_scale.z, t[2]->m_scale.z, t[3]->m_scale.z);
+
+		// local[column][row], rotation from the quaternion scaled per column, then the translation
+		__m128 local[4][3];
+		const __m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+		const __m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+		const __m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+		local[0][0] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+		local[0][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+		local[0][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+		local[1][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+		local[1][1] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+		local[1][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+		local[2][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+		local[2][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+		local[2][2] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+		local[3][0] = _mm_setr_ps(t[0]->m_pos.x, t[1]->m_pos.x, t[2]->m_pos.x, t[3]->m_pos.x);
+		local[3][1] = _mm_setr_ps(t[0]->m_pos.y, t[1]->m_pos.y, t[2]->m_pos.y, t[3]->m_pos.y);
+		local[3][2] = _mm_setr_ps(t[0]->m_pos.z, t[1]->m_pos.z, t[2]->m_pos.z, t[3]->m_pos.z);
+
+		// parent * local, one column at a time, then transposed back to one matrix per lane
+		for (int c = 0; c < 4; ++c)
+		{
+			__m128 rows[4];
+			for (int r = 0; r < 3; ++r)
+			{
+				rows[r] = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(parent[0][r], local[c][0]), _mm_mul_ps(parent[1][r], local[c][1])),
+					_mm_mul_ps(parent[2][r], local[c][2]));
+				if (c == 3)
+					rows[r] = _mm_add_ps(rows[r], parent[3][r]);
+			}
+			rows[3] = c == 3 ? one : _mm_setzero_ps();
+			_MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+			for (size_t lane = 0; lane < 4 && i + lane < count; ++lane)
+				_mm_storeu_ps(&t[lane]->model_matrix[c][0], rows[lane]);
+		}
+		for (size_t lane = 0; lane < 4 && i + lane < count; ++lane)
+			t[lane]->is_dirty = false;
+	}
+#else
+	for (size_t i = 0; i < count; ++i)
+		transforms[i]->compute_model_matrix(parent_model_matrix);
+#endif
+}
 
 class Entity
 {
 public:
 	// Scene graph
 	std::list<unique_ptr<Entity>> children;
-	Entity* parent;
+	Entity* parent = nullptr;
 
 	// Space Transform
 	Transform transform;
@@ -118,7 +222,36 @@ public:
 	// underlying model
 	Model* pModel;
 
-	Entity(Model& model) : pModel(&model){};
+	// local space bounds of the underlying model
+	AABB bounding_volume;
+
+	// optional coarser versions of the model, lod_models[i] is used for level of detail i + 1
+	std::vector<Model*> lod_models;
+
+	// material parameter of the draw, multiplied with the model's textures by shaders that support it
+	glm::vec4 tint = glm::vec4(1.0f);
+
+	// entities whose transform changed since the last update, only filled on the root. Transform setters are not
+	// thread safe because of it.
+	std::vector<Entity*> dirty_list;
+
+	// proxy of the entity in an EntitySpatialIndex, -1 when not indexed
+	int spatial_proxy = -1;
+
+	Entity(Model& model) : pModel(&model), bounding_volume(generate_aabb(model))
+	{
+		transform.owner = this;
+		transform.dirty_list = &dirty_list;
+		dirty_list.push_back(this);
+	}
+
+	Model*
+	get_lod_model(unsigned int lod) const
+	{
+		if (lod == 0 || lod_models.empty())
+			return pModel;
+		return lod_models[std::min<size_t>(lod, lod_models.size()) - 1];
+	}
 
 	// Add child. Argument input is argument of any constructor that you create. By default you can use the default
 	// constructor and don't put argument input.
@@ -127,35 +260,215 @@ public:
 	add_child(Targs&... args)
 	{
 		children.emplace_back(std::make_unique<Entity>(args...));
-		children.back()->parent = this;
+		Entity& child = *children.back();
+		child.parent = this;
+
+		// changes are reported to the root, starting with the child itself
+		child.dirty_list.clear();
+		child.transform.dirty_list = transform.dirty_list;
+		transform.dirty_list->push_back(&child);
 	}
 
 	// update transform if it changed
 	void
 	update_self_and_child()
 	{
-		if (transform.is_dirty)
+		const bool dirty = transform.is_dirty;
+		if (dirty)
+			compute_self();
+
+		update_children(children.begin(), children.end(), dirty, nullptr);
+		if (!parent)
+			dirty_list.clear();
+	}
+
+	// same result as update_self_and_child(), with sibling subtrees updated in parallel on the job system
+	void
+	update_self_and_child(JobSystem& job_system)
+	{
+		const bool dirty = transform.is_dirty;
+		if (dirty)
+			compute_self();
+
+		update_children_parallel(job_system, dirty);
+		if (!parent)
+			dirty_list.clear();
+	}
+
+	void
+	force_update_self_child()
+	{
+		compute_self();
+		update_children(children.begin(), children.end(), true, nullptr);
+	}
+
+	void
+	force_update_self_child(JobSystem& job_system)
+	{
+		compute_self();
+		update_children_parallel(job_system, true);
+	}
+
+	// same result as update_self_and_child() on the root, but only the subtrees below the transforms changed since
+	// the last update are visited. Static parts of the tree cost nothing.
+	void
+	update_dirty()
+	{
+		collect_dirty_roots();
+		for (Entity* entity : dirty_roots)
+			entity->force_update_self_child();
+	}
+
+	void
+	update_dirty(JobSystem& job_system)
+	{
+		collect_dirty_roots();
+		job_system.parallel_for(0, dirty_roots.size(), 1, [this, &job_system](size_t first, size_t last) {
+			for (size_t i = first; i < last; ++i)
+				dirty_roots[i]->force_update_self_child(job_system);
+		});
+	}
+
+	// roots of the subtrees recomputed by the last update_dirty, every entity below them has a new world matrix
+	const std::vector<Entity*>&
+	get_updated_roots() const
+	{
+		return dirty_roots;
+	}
+
+	// bounds of the model in world space, the transform must be up to date
+	AABB
+	get_world_aabb() const
+	{
+		return bounding_volume.transformed(transform.get_model_matrix());
+	}
+
+	// world matrix of the entity even when an update is pending. Only the path from the closest up to date ancestor
+	// is composed, nothing is written back.
+	glm::mat4
+	get_world_matrix() const
+	{
+		const Entity* topmost_dirty = nullptr;
+		for (const Entity* entity = this; entity; entity = entity->parent)
 		{
-			force_update_self_child();
+			if (entity->transform.is_dirty)
+				topmost_dirty = entity;
 		}
+		if (!topmost_dirty)
+			return transform.get_model_matrix();
+		return compose_world_matrix(topmost_dirty);
+	}
+
+private:
+	using ChildIterator = std::list<unique_ptr<Entity>>::iterator;
 
-		for (auto&& child : children)
+	// roots of the disjoint subtrees to recompute, rebuilt by every update_dirty
+	std::vector<Entity*> dirty_roots;
+
+	// keep the dirty entities that have no dirty ancestor, each of them once
+	void
+	collect_dirty_roots()
+	{
+		dirty_roots.clear();
+		for (Entity* entity : dirty_list)
 		{
-			child->update_self_and_child();
+			// already updated by a full update
+			if (!entity->transform.is_dirty)
+				continue;
+
+			bool ancestor_dirty = false;
+			for (const Entity* ancestor = entity->parent; ancestor && !ancestor_dirty; ancestor = ancestor->parent)
+				ancestor_dirty = ancestor->transform.is_dirty;
+			if (!ancestor_dirty)
+				dirty_roots.push_back(entity);
 		}
+		dirty_list.clear();
+
+		std::sort(dirty_roots.begin(), dirty_roots.end());
+		dirty_roots.erase(std::unique(dirty_roots.begin(), dirty_roots.end()), dirty_roots.end());
+	}
+
+	glm::mat4
+	compose_world_matrix(const Entity* topmost_dirty) const
+	{
+		const glm::mat4 local = transform.get_local_model_matrix();
+		if (this != topmost_dirty)
+			return parent->compose_world_matrix(topmost_dirty) * local;
+		return parent ? parent->transform.get_model_matrix() * local : local;
 	}
 
 	void
-	force_update_self_child()
+	compute_self()
 	{
+		// through the batch kernel like every other child, so the result does not depend on which update ran
 		if (parent)
-			transform.compute_model_matrix(parent->transform.get_model_matrix());
+		{
+			Transform* self = &transform;
+			compute_model_matrices(&self, 1, parent->transform.get_model_matrix());
+		}
 		else
 			transform.compute_model_matrix();
+	}
+
+	// a child is recomputed when it or any of its ancestors is dirty. The children of [first, last) that need it are
+	// composed in one batch, then the update continues below each of them, serially or through the job system.
+	void
+	update_children(ChildIterator first, ChildIterator last, bool parent_dirty, JobSystem* job_system)
+	{
+		if (first == last)
+			return;
+
+		// used as a stack, nested calls on the same thread push above and pop back to where they started
+		static thread_local std::vector<Transform*> batch;
+		const size_t batch_begin = batch.size();
+		for (auto child = first; child != last; ++child)
+		{
+			if (parent_dirty || (*child)->transform.is_dirty)
+				batch.push_back(&(*child)->transform);
+		}
+		const size_t batch_end = batch.size();
+		compute_model_matrices(batch.data() + batch_begin, batch_end - batch_begin, transform.get_model_matrix());
+
+		size_t next = batch_begin;
+		for (auto child = first; child != last; ++child)
+		{
+			const bool recomputed = next < batch_end && batch[next] == &(*child)->transform;
+			if (recomputed)
+				++next;
+
+			if (job_system)
+				(*child)->update_children_parallel(*job_system, recomputed);
+			else
+				(*child)->update_children((*child)->children.begin(), (*child)->children.end(), recomputed, nullptr);
+		}
+		batch.resize(batch_begin);
+	}
+
+	// the parent is always finished before its children are scheduled
+	void
+	update_children_parallel(JobSystem& job_system, bool parent_dirty)
+	{
+		if (children.size() < 2)
+		{
+			update_children(children.begin(), children.end(), parent_dirty, &job_system);
+			return;
+		}
 
-		for (auto&& child : children)
+		// hand out runs of siblings, enough of them to balance uneven subtrees
+		const size_t grain = std::max<size_t>(1, children.size() / (job_system.get_thread_count() * 4));
+		JobCounter counter;
+		for (auto first = children.begin(); first != children.end();)
 		{
-			child->force_update_self_child();
+			auto last = first;
+			for (size_t i = 0; i < grain && last != children.end(); ++i)
+				++last;
+			job_system.run(
+				[this, &job_system, first, last, parent_dirty] {
+					update_children(first, last, parent_dirty, &job_system);
+				},
+				&counter);
+			first = last;
 		}
+		job_system.wait(counter);
 	}
 };
\ No newline at end of file
@@ -0,0 +1,469 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <csignal>
+#endif
+
+#include <glad/glad.h>
+
+#include <learnopengl/job_system.h>
+
+enum class CaptureFormat
+{
+	png,
+	qoi,
+};
+
+// RGBA8 pixels of a captured frame, top row first
+struct CapturedFrame
+{
+	uint64_t index = 0;
+	int width = 0;
+	int height = 0;
+	std::vector<uint8_t> pixels;
+};
+
+// QOI ("Quite OK Image") encoding of RGBA8 pixels: a run, an index into the 64 recently seen colors, a small
+// difference to the previous pixel or the full color, whichever is shortest. Several times faster than PNG's deflate
+// at a similar size on rendered images.
+inline std::vector<uint8_t>
+encode_qoi(const uint8_t* rgba, int width, int height)
+{
+	std::vector<uint8_t> out;
+	out.reserve(14 + size_t(width) * height + 8);
+	auto put_u32 = [&out](uint32_t value) {
+		for (int shift = 24; shift >= 0; shift -= 8)
+			out.push_back(uint8_t(value >> shift));
+	};
+	out.insert(out.end(), {'q', 'o', 'i', 'f'});
+	put_u32(uint32_t(width));
+	put_u32(uint32_t(height));
+	out.push_back(4);
+	out.push_back(0);
+
+	uint8_t seen[64][4] = {};
+	uint8_t previous[4] = {0, 0, 0, 255};
+	int run = 0;
+	const size_t pixel_count = size_t(width) * height;
+	for (size_t i = 0; i < pixel_count; ++i)
+	{
+		const uint8_t* pixel = rgba + i * 4;
+		if (std::memcmp(pixel, previous, 4) == 0)
+		{
+			if (++run == 62 || i + 1 == pixel_count)
+			{
+				out.push_back(uint8_t(0xc0 | (run - 1)));
+				run = 0;
+			}
+			continue;
+		}
+		if (run > 0)
+		{
+			out.push_back(uint8_t(0xc0 | (run - 1)));
+			run = 0;
+		}
+
+		const int hash = (pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) % 64;
+		uint8_t* slot = seen[hash];
+		if (std::memcmp(pixel, slot, 4) == 0)
+			out.push_back(uint8_t(hash));
+		else
+		{
+			std::memcpy(slot, pixel, 4);
+			if (pixel[3] == previous[3])
+			{
+				const int dr = int8_t(pixel[0] - previous[0]);
+				const int dg = int8_t(pixel[1] - previous[1]);
+				const int db = int8_t(pixel[2] - previous[2]);
+				const int dr_dg = dr - dg;
+				const int db_dg = db - dg;
+				if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+					out.push_back(uint8_t(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+				else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7)
+				{
+					out.push_back(uint8_t(0x80 | (dg + 32)));
+					out.push_back(uint8_t((dr_dg + 8) << 4 | (db_dg + 8)));
+				}
+				else
+					out.insert(out.end(), {0xfe, pixel[0], pixel[1], pixel[2]});
+			}
+			else
+				out.insert(out.end(), {0xff, pixel[0], pixel[1], pixel[2], pixel[3]});
+		}
+		std::memcpy(previous, pixel, 4);
+	}
+	out.insert(out.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+	return out;
+}
+
+// PNG with stored (uncompressed) deflate blocks: readable everywhere, but about the size of the raw pixels, prefer
+// QOI when capturing long sequences
+inline std::vector<uint8_t>
+encode_png(const uint8_t* rgba, int width, int height)
+{
+	static const std::array<uint32_t, 256> crc_table = [] {
+		std::array<uint32_t, 256> table{};
+		for (uint32_t n = 0; n < 256; ++n)
+		{
+			uint32_t c = n;
+			for (int k = 0; k < 8; ++k)
+				c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+			table[n] = c;
+		}
+		return table;
+	}();
+
+	std::vector<uint8_t> out = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+	auto put_u32 = [](std::vector<uint8_t>& to, uint32_t value) {
+		for (int shift = 24; shift >= 0; shift -= 8)
+			to.push_back(uint8_t(value >> shift));
+	};
+	auto put_chunk = [&](const char* type, const std::vector<uint8_t>& data) {
+		put_u32(out, uint32_t(data.size()));
+		const size_t start = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data.begin(), data.end());
+		uint32_t crc = 0xffffffffu;
+		for (size_t i = start; i < out.size(); ++i)
+			crc = crc_table[(crc ^ out[i]) & 0xff] ^ (crc >> 8);
+		put_u32(out, crc ^ 0xffffffffu);
+	};
+
+	std::vector<uint8_t> header;
+	put_u32(header, uint32_t(width));
+	put_u32(header, uint32_t(height));
+	header.insert(header.end(), {8, 6, 0, 0, 0});
+	put_chunk("IHDR", header);
+
+	// every row starts with filter type 0, the whole image goes in 64k stored blocks of a zlib stream
+	const size_t row_size = size_t(width) * 4;
+	std::vector<uint8_t> raw;
+	raw.reserve((row_size + 1) * height);
+	for (int y = 0; y < height; ++y)
+	{
+		raw.push_back(0);
+		raw.insert(raw.end(), rgba + y * row_size, rgba + (y + 1) * row_size);
+	}
+	std::vector<uint8_t> zlib = {0x78, 0x01};
+	zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+	for (size_t offset = 0; offset < raw.size(); offset += 65535)
+	{
+		const size_t length = std::min<size_t>(65535, raw.size() - offset);
+		zlib.push_back(offset + length == raw.size() ? 1 : 0);
+		zlib.insert(zlib.end(), {uint8_t(length), uint8_t(length >> 8), uint8_t(~length), uint8_t(~length >> 8)});
+		zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+	}
+	uint32_t a = 1, b = 0;
+	for (size_t i = 0; i < raw.size(); ++i)
+	{
+		a = (a + raw[i]) % 65521;
+		b = (b + a) % 65521;
+	}
+	put_u32(zlib, b << 16 | a);
+	put_chunk("IDAT", zlib);
+	put_chunk("IEND", {});
+	return out;
+}
+
+// Gets rendered frames out without stalling the pipeline. capture() starts an asynchronous glReadPixels into one of a
+// ring of pixel buffer objects and fences it; the buffer is mapped a few frames later, once the fence has signaled,
+// and the copy goes to the job system to be encoded to numbered image files or streamed raw to a pipe (e.g. into
+// ffmpeg). The render thread only waits when the GPU is ring_size frames behind, or when more frames than
+// max_frames_in_flight wait for the encoders, in which case it helps encoding.
+class FrameCapture
+{
+public:
+	static constexpr size_t ring_size = 3;
+
+	explicit FrameCapture(JobSystem& job_system, size_t max_frames_in_flight = 0)
+		: job_system(job_system),
+		  max_frames_in_flight(max_frames_in_flight ? max_frames_in_flight
+													: std::max<size_t>(4, job_system.get_thread_count()))
+	{
+	}
+
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture&
+	operator=(const FrameCapture&) = delete;
+
+	~FrameCapture()
+	{
+		stop();
+		for (Slot& slot : slots)
+			glDeleteBuffers(1, &slot.buffer);
+	}
+
+	// prefix followed by the 6 digit frame number and the extension of format, e.g. capture_000042.qoi
+	void
+	start_files(const std::string& prefix, CaptureFormat format)
+	{
+		stop();
+		file_prefix = prefix;
+		file_format = format;
+		write_failed = false;
+		frame_count = skipped_count = 0;
+		capturing = true;
+	}
+
+	// raw RGBA frames written to the standard input of command, e.g.
+	// ffmpeg -f rawvideo -pix_fmt rgba -s 1920x1080 -framerate 60 -i - capture.mp4
+	// The stream keeps the size of its first frame, frames of another size are skipped.
+	bool
+	start_pipe(const std::string& command)
+	{
+		stop();
+#ifdef _WIN32
+		pipe = _popen(command.c_str(), "wb");
+#else
+		// a reader that exits early must not kill the demo, the failed write is reported instead
+		std::signal(SIGPIPE, SIG_IGN);
+		pipe = popen(command.c_str(), "w");
+#endif
+		if (!pipe)
+			return false;
+		write_failed = false;
+		frame_count = skipped_count = 0;
+		stream_width = stream_height = 0;
+		capturing = true;
+		return true;
+	}
+
+	// finishes the frames already read back or encoding
+	void
+	stop()
+	{
+		if (!capturing)
+			return;
+		while (pending > 0)
+			read_back(true);
+		while (!jobs.empty())
+		{
+			job_system.wait(*jobs.front());
+			jobs.pop_front();
+		}
+		if (pipe)
+		{
+#ifdef _WIN32
+			_pclose(pipe);
+#else
+			pclose(pipe);
+#endif
+			pipe = nullptr;
+		}
+		capturing = false;
+	}
+
+	bool
+	is_capturing() const
+	{
+		return capturing;
+	}
+
+	// false once a write failed, e.g. the disk is full or the program at the other end of the pipe exited
+	bool
+	is_healthy() const
+	{
+		return !write_failed;
+	}
+
+	// call once per frame after rendering it, before swapping: reads the framebuffer bound to GL_READ_FRAMEBUFFER
+	void
+	capture(int width, int height)
+	{
+		if (!capturing)
+			return;
+		if (pipe)
+		{
+			if (stream_width == 0)
+			{
+				stream_width = width;
+				stream_height = height;
+			}
+			else if (width != stream_width || height != stream_height)
+			{
+				++skipped_count;
+				return;
+			}
+		}
+		if (width != buffer_width || height != buffer_height)
+			allocate(width, height);
+
+		// hand over the readbacks the GPU finished, oldest first to keep the frame order
+		while (pending > 0 && read_back(false))
+			;
+		// the GPU is a whole ring behind, wait for the oldest readback rather than overwrite it
+		if (pending == ring_size)
+			read_back(true);
+
+		Slot& slot = slots[(oldest + pending) % ring_size];
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		slot.index = frame_count++;
+		++pending;
+	}
+
+	// frames read back so far, including the ones still encoding
+	uint64_t
+	get_captured_count() const
+	{
+		return frame_count - pending;
+	}
+
+	uint64_t
+	get_skipped_count() const
+	{
+		return skipped_count;
+	}
+
+private:
+	struct Slot
+	{
+		GLuint buffer = 0;
+		GLsync fence = nullptr;
+		uint64_t index = 0;
+	};
+
+	JobSystem& job_system;
+	const size_t max_frames_in_flight;
+
+	std::array<Slot, ring_size> slots{};
+	size_t oldest = 0;
+	size_t pending = 0;
+	int buffer_width = 0;
+	int buffer_height = 0;
+
+	bool capturing = false;
+	std::string file_prefix;
+	CaptureFormat file_format = CaptureFormat::qoi;
+	FILE* pipe = nullptr;
+	std::atomic<bool> write_failed{false};
+	int stream_width = 0;
+	int stream_height = 0;
+
+	uint64_t frame_count = 0;
+	uint64_t skipped_count = 0;
+
+	// encoding jobs not known to be finished yet, in frame order
+	std::deque<std::unique_ptr<JobCounter>> jobs;
+
+	void
+	allocate(int width, int height)
+	{
+		while (pending > 0)
+			read_back(true);
+		for (Slot& slot : slots)
+		{
+			if (!slot.buffer)
+				glGenBuffers(1, &slot.buffer);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+			glBufferData(GL_PIXEL_PACK_BUFFER, GLsizeiptr(width) * height * 4, nullptr, GL_STREAM_READ);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		buffer_width = width;
+		buffer_height = height;
+	}
+
+	// maps the oldest pending readback and submits it, false if its fence has not signaled and wait is not set
+	bool
+	read_back(bool wait)
+	{
+		Slot& slot = slots[oldest];
+		GLenum status = glClientWaitSync(slot.fence, 0, 0);
+		while (wait && status == GL_TIMEOUT_EXPIRED)
+			status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+		if (status == GL_TIMEOUT_EXPIRED)
+			return false;
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+
+		// GL rows start at the bottom, flip them while copying out of the mapped buffer
+		auto frame = std::make_shared<CapturedFrame>();
+		frame->index = slot.index;
+		frame->width = buffer_width;
+		frame->height = buffer_height;
+		const size_t row_size = size_t(buffer_width) * 4;
+		frame->pixels.resize(row_size * buffer_height);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		const uint8_t* mapped = static_cast<const uint8_t*>(
+			glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(frame->pixels.size()), GL_MAP_READ_BIT));
+		if (mapped)
+		{
+			for (int y = 0; y < buffer_height; ++y)
+				std::memcpy(&frame->pixels[y * row_size], mapped + (buffer_height - 1 - y) * row_size, row_size);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		oldest = (oldest + 1) % ring_size;
+		--pending;
+
+		if (mapped)
+			submit(std::move(frame));
+		else
+			++skipped_count;
+		return true;
+	}
+
+	void
+	submit(std::shared_ptr<CapturedFrame> frame)
+	{
+		// too many frames waiting for the encoders, the render thread helps with the oldest
+		while (jobs.size() >= max_frames_in_flight)
+		{
+			job_system.wait(*jobs.front());
+			jobs.pop_front();
+		}
+
+		auto counter = std::make_unique<JobCounter>();
+		if (pipe)
+		{
+			// the stream needs the frames in order, every write waits for the previous one
+			Job job = [this, frame] {
+				if (!write_failed && std::fwrite(frame->pixels.data(), 1, frame->pixels.size(), pipe) !=
+										frame->pixels.size())
+					write_failed = true;
+			};
+			if (!jobs.empty())
+				job_system.run_after(*jobs.back(), std::move(job), counter.get());
+			else
+				job_system.run(std::move(job), counter.get());
+		}
+		else
+		{
+			job_system.run(
+				[this, frame, prefix = file_prefix, format = file_format] {
+					const std::vector<uint8_t> encoded = format == CaptureFormat::qoi
+															 ? encode_qoi(frame->pixels.data(), frame->width, frame->height)
+															 : encode_png(frame->pixels.data(), frame->width, frame->height);
+					char number[32];
+					std::snprintf(number, sizeof(number), "%06llu", (unsigned long long)frame->index);
+					std::ofstream file(prefix + number + (format == CaptureFormat::qoi ? ".qoi" : ".png"),
+									   std::ios::binary);
+					file.write(reinterpret_cast<const char*>(encoded.data()), std::streamsize(encoded.size()));
+					if (!file)
+						write_failed = true;
+				},
+				counter.get());
+		}
+		jobs.push_back(std::move(counter));
+
+		// forget the finished jobs, wait() only makes sure the thread that finished them let go of the counter
+		while (jobs.size() > 1 && jobs.front()->is_done())
+		{
+			job_system.wait(*jobs.front());
+			jobs.pop_front();
+		}
+	}
+};
@@ -0,0 +1,553 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+
+// size and format of a render target
+struct FrameGraphTextureDesc
+{
+	int width = 0;
+	int height = 0;
+	GLenum internal_format = GL_RGBA8;
+
+	bool
+	operator==(const FrameGraphTextureDesc& other) const
+	{
+		return width == other.width && height == other.height && internal_format == other.internal_format;
+	}
+};
+
+inline bool
+is_depth_format(GLenum internal_format)
+{
+	switch (internal_format)
+	{
+	case GL_DEPTH_COMPONENT16:
+	case GL_DEPTH_COMPONENT24:
+	case GL_DEPTH_COMPONENT32:
+	case GL_DEPTH_COMPONENT32F:
+	case GL_DEPTH24_STENCIL8:
+	case GL_DEPTH32F_STENCIL8:
+		return true;
+	default:
+		return false;
+	}
+}
+
+inline bool
+is_depth_stencil_format(GLenum internal_format)
+{
+	return internal_format == GL_DEPTH24_STENCIL8 || internal_format == GL_DEPTH32F_STENCIL8;
+}
+
+// approximate, drivers pad three component formats to four
+inline size_t
+bytes_per_texel(GLenum internal_format)
+{
+	switch (internal_format)
+	{
+	case GL_R8:
+		return 1;
+	case GL_RG8:
+	case GL_R16F:
+	case GL_DEPTH_COMPONENT16:
+		return 2;
+	case GL_RGBA16F:
+	case GL_RGB16F:
+	case GL_RG32F:
+	case GL_DEPTH32F_STENCIL8:
+		return 8;
+	case GL_RGBA32F:
+	case GL_RGB32F:
+		return 16;
+	default:
+		return 4;
+	}
+}
+
+// Render targets shared by the frame graphs of all frames. A texture released by a pass goes back to the free list and
+// is handed to the next pass asking for the same size and format, in the same frame or a later one, so passes whose
+// lifetimes do not overlap alias the same memory. Textures left unused for a few frames, for example the old size
+// after a resize, are deleted in end_frame(). Framebuffer objects are cached per set of attachments.
+class TransientResourcePool
+{
+public:
+	// a texture survives this many frames without being acquired
+	static constexpr uint64_t max_unused_frames = 2;
+
+	TransientResourcePool() = default;
+	TransientResourcePool(const TransientResourcePool&) = delete;
+	TransientResourcePool& operator=(const TransientResourcePool&) = delete;
+
+	~TransientResourcePool()
+	{
+		clear();
+	}
+
+	GLuint
+	acquire(const FrameGraphTextureDesc& desc)
+	{
+		for (auto&& entry : entries)
+		{
+			if (!entry.in_use && entry.desc == desc)
+			{
+				entry.in_use = true;
+				entry.last_used_frame = frame;
+				return entry.texture;
+			}
+		}
+
+		Entry entry;
+		entry.desc = desc;
+		entry.texture = create_texture(desc);
+		entry.last_used_frame = frame;
+		entry.in_use = true;
+		entries.push_back(entry);
+		++created_count;
+		return entry.texture;
+	}
+
+	void
+	release(GLuint texture)
+	{
+		for (auto&& entry : entries)
+		{
+			if (entry.texture == texture)
+			{
+				entry.in_use = false;
+				return;
+			}
+		}
+	}
+
+	// framebuffer with the given color attachments in order, plus an optional depth or depth stencil texture
+	GLuint
+	get_framebuffer(const std::vector<GLuint>& colors, GLuint depth, GLenum depth_format)
+	{
+		std::vector<GLuint> key = colors;
+		key.push_back(depth);
+		auto found = framebuffers.find(key);
+		if (found != framebuffers.end())
+			return found->second;
+
+		GLuint framebuffer;
+		glGenFramebuffers(1, &framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		std::vector<GLenum> draw_buffers;
+		for (size_t i = 0; i < colors.size(); ++i)
+		{
+			glFramebufferTexture2D(
+				GL_FRAMEBUFFER,
+				GLenum(GL_COLOR_ATTACHMENT0 + i),
+				GL_TEXTURE_2D,
+				colors[i],
+				0);
+			draw_buffers.push_back(GLenum(GL_COLOR_ATTACHMENT0 + i));
+		}
+		if (depth)
+		{
+			const GLenum attachment =
+				is_depth_stencil_format(depth_format) ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+			glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, depth, 0);
+		}
+		if (draw_buffers.empty())
+		{
+			glDrawBuffer(GL_NONE);
+			glReadBuffer(GL_NONE);
+		}
+		else
+			glDrawBuffers(GLsizei(draw_buffers.size()), draw_buffers.data());
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			std::cout << "ERROR::FRAMEBUFFER:: Frame graph framebuffer is not complete!" << std::endl;
+
+		framebuffers.emplace(std::move(key), framebuffer);
+		return framebuffer;
+	}
+
+	// deletes the textures, and the framebuffers using them, that have not been acquired for max_unused_frames
+	void
+	end_frame()
+	{
+		// keeps the order of the survivors, so the same passes keep getting the same textures and framebuffers
+		auto stale = [this](const Entry& entry) {
+			if (entry.in_use || frame - entry.last_used_frame < max_unused_frames)
+				return false;
+			destroy_texture(entry.texture);
+			return true;
+		};
+		entries.erase(std::remove_if(entries.begin(), entries.end(), stale), entries.end());
+		++frame;
+	}
+
+	void
+	clear()
+	{
+		for (auto&& framebuffer : framebuffers)
+			glDeleteFramebuffers(1, &framebuffer.second);
+		framebuffers.clear();
+		for (auto&& entry : entries)
+			glDeleteTextures(1, &entry.texture);
+		entries.clear();
+	}
+
+	size_t
+	get_texture_count() const
+	{
+		return entries.size();
+	}
+
+	size_t
+	get_allocated_bytes() const
+	{
+		size_t bytes = 0;
+		for (auto&& entry : entries)
+			bytes += size_t(entry.desc.width) * entry.desc.height * bytes_per_texel(entry.desc.internal_format);
+		return bytes;
+	}
+
+	// total number of textures created since construction, constant once the frames are steady
+	size_t
+	get_created_count() const
+	{
+		return created_count;
+	}
+
+private:
+	struct Entry
+	{
+		FrameGraphTextureDesc desc;
+		GLuint texture = 0;
+		uint64_t last_used_frame = 0;
+		bool in_use = false;
+	};
+
+	std::vector<Entry> entries;
+	// color attachments followed by the depth attachment, 0 if there is none
+	std::map<std::vector<GLuint>, GLuint> framebuffers;
+	uint64_t frame = 0;
+	size_t created_count = 0;
+
+	static GLuint
+	create_texture(const FrameGraphTextureDesc& desc)
+	{
+		// the format and type only describe the missing pixel data, they must still match the kind of internal format
+		GLenum format = GL_RGBA;
+		GLenum type = GL_FLOAT;
+		if (is_depth_stencil_format(desc.internal_format))
+		{
+			format = GL_DEPTH_STENCIL;
+			type = desc.internal_format == GL_DEPTH24_STENCIL8 ? GL_UNSIGNED_INT_24_8 : GL_FLOAT_32_UNSIGNED_INT_24_8_REV;
+		}
+		else if (is_depth_format(desc.internal_format))
+			format = GL_DEPTH_COMPONENT;
+
+		GLuint texture;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, desc.internal_format, desc.width, desc.height, 0, format, type, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return texture;
+	}
+
+	void
+	destroy_texture(GLuint texture)
+	{
+		for (auto it = framebuffers.begin(); it != framebuffers.end();)
+		{
+			if (std::find(it->first.begin(), it->first.end(), texture) != it->first.end())
+			{
+				glDeleteFramebuffers(1, &it->second);
+				it = framebuffers.erase(it);
+			}
+			else
+				++it;
+		}
+		glDeleteTextures(1, &texture);
+	}
+};
+
+using FrameGraphResource = int;
+
+// Declarative description of one frame, rebuilt every frame. Passes declare the render targets they create, read and
+// write; compile() culls the passes whose results are never read, then computes when every transient target is first
+// and last used. execute() takes the targets from the pool just before their first use, binds a framebuffer with the
+// pass's writes as attachments, and gives the targets back after their last use.
+class FrameGraph
+{
+public:
+	class Builder
+	{
+	public:
+		// new transient target written by this pass
+		FrameGraphResource
+		create(const std::string& name, const FrameGraphTextureDesc& desc)
+		{
+			Resource resource;
+			resource.name = name;
+			resource.desc = desc;
+			graph.resources.push_back(resource);
+			return write(FrameGraphResource(graph.resources.size() - 1));
+		}
+
+		FrameGraphResource
+		read(FrameGraphResource resource)
+		{
+			graph.passes[pass].reads.push_back(resource);
+			return resource;
+		}
+
+		FrameGraphResource
+		write(FrameGraphResource resource)
+		{
+			graph.passes[pass].writes.push_back(resource);
+			graph.resources[resource].writers.push_back(pass);
+			return resource;
+		}
+
+		// the pass is kept even if nothing reads what it writes
+		void
+		side_effect()
+		{
+			graph.passes[pass].side_effect = true;
+		}
+
+	private:
+		friend class FrameGraph;
+
+		Builder(FrameGraph& graph, size_t pass) : graph(graph), pass(pass)
+		{
+		}
+
+		FrameGraph& graph;
+		size_t pass;
+	};
+
+	using Execute = std::function<void(const FrameGraph&)>;
+
+	explicit FrameGraph(TransientResourcePool& pool) : pool(pool)
+	{
+	}
+
+	// the default framebuffer; passes writing it are never culled
+	FrameGraphResource
+	import_backbuffer(int width, int height)
+	{
+		Resource resource;
+		resource.name = "backbuffer";
+		resource.desc.width = width;
+		resource.desc.height = height;
+		resource.imported = true;
+		resources.push_back(resource);
+		return FrameGraphResource(resources.size() - 1);
+	}
+
+	// a texture owned by the caller, it outlives the frame
+	FrameGraphResource
+	import_texture(const std::string& name, const FrameGraphTextureDesc& desc, GLuint texture)
+	{
+		Resource resource;
+		resource.name = name;
+		resource.desc = desc;
+		resource.texture = texture;
+		resource.imported = true;
+		resources.push_back(resource);
+		return FrameGraphResource(resources.size() - 1);
+	}
+
+	// setup(Builder&) declares the pass's resources right away, execute runs in execute() if the pass is not culled
+	template<typename Setup>
+	void
+	add_pass(const std::string& name, Setup&& setup, Execute execute)
+	{
+		Pass pass;
+		pass.name = name;
+		pass.execute = std::move(execute);
+		passes.push_back(std::move(pass));
+		Builder builder(*this, passes.size() - 1);
+		setup(builder);
+	}
+
+	void
+	compile()
+	{
+		for (auto&& pass : passes)
+		{
+			pass.ref_count = int(pass.writes.size());
+			for (FrameGraphResource resource : pass.writes)
+			{
+				if (resources[resource].imported)
+					pass.side_effect = true;
+			}
+			for (FrameGraphResource resource : pass.reads)
+				++resources[resource].ref_count;
+		}
+
+		// a transient target nobody reads makes its writers lose a reference, writers left without any are culled and
+		// release what they read in turn
+		std::vector<FrameGraphResource> unreferenced;
+		for (size_t i = 0; i < resources.size(); ++i)
+		{
+			if (resources[i].ref_count == 0 && !resources[i].imported)
+				unreferenced.push_back(FrameGraphResource(i));
+		}
+		while (!unreferenced.empty())
+		{
+			const FrameGraphResource resource = unreferenced.back();
+			unreferenced.pop_back();
+			for (size_t writer : resources[resource].writers)
+			{
+				Pass& pass = passes[writer];
+				if (--pass.ref_count > 0 || pass.side_effect || pass.culled)
+					continue;
+				pass.culled = true;
+				for (FrameGraphResource read : pass.reads)
+				{
+					if (--resources[read].ref_count == 0 && !resources[read].imported)
+						unreferenced.push_back(read);
+				}
+			}
+		}
+
+		// lifetimes over the passes that remain
+		for (size_t i = 0; i < passes.size(); ++i)
+		{
+			if (passes[i].culled)
+				continue;
+			for (auto* list : {&passes[i].reads, &passes[i].writes})
+			{
+				for (FrameGraphResource resource : *list)
+				{
+					Resource& r = resources[resource];
+					if (r.first_use < 0)
+						r.first_use = int(i);
+					r.last_use = int(i);
+				}
+			}
+		}
+		for (size_t i = 0; i < resources.size(); ++i)
+		{
+			const Resource& resource = resources[i];
+			if (resource.imported || resource.first_use < 0)
+				continue;
+			passes[resource.first_use].acquires.push_back(FrameGraphResource(i));
+			passes[resource.last_use].releases.push_back(FrameGraphResource(i));
+		}
+		compiled = true;
+	}
+
+	void
+	execute()
+	{
+		if (!compiled)
+			compile();
+
+		for (auto&& pass : passes)
+		{
+			if (pass.culled)
+				continue;
+			for (FrameGraphResource resource : pass.acquires)
+				resources[resource].texture = pool.acquire(resources[resource].desc);
+			bind_render_targets(pass);
+			pass.execute(*this);
+			for (FrameGraphResource resource : pass.releases)
+			{
+				pool.release(resources[resource].texture);
+				resources[resource].texture = 0;
+			}
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		pool.end_frame();
+	}
+
+	// valid while the executing pass reads or writes the resource
+	GLuint
+	get_texture(FrameGraphResource resource) const
+	{
+		return resources[resource].texture;
+	}
+
+	const FrameGraphTextureDesc&
+	get_desc(FrameGraphResource resource) const
+	{
+		return resources[resource].desc;
+	}
+
+	size_t
+	get_culled_pass_count() const
+	{
+		return size_t(std::count_if(passes.begin(), passes.end(), [](const Pass& pass) { return pass.culled; }));
+	}
+
+private:
+	struct Resource
+	{
+		std::string name;
+		FrameGraphTextureDesc desc;
+		GLuint texture = 0;
+		bool imported = false;
+		std::vector<size_t> writers;
+		int ref_count = 0;
+		int first_use = -1;
+		int last_use = -1;
+	};
+
+	struct Pass
+	{
+		std::string name;
+		std::vector<FrameGraphResource> reads;
+		std::vector<FrameGraphResource> writes;
+		// transient targets taken from the pool before the pass and given back after it
+		std::vector<FrameGraphResource> acquires;
+		std::vector<FrameGraphResource> releases;
+		Execute execute;
+		int ref_count = 0;
+		bool side_effect = false;
+		bool culled = false;
+	};
+
+	TransientResourcePool& pool;
+	std::vector<Resource> resources;
+	std::vector<Pass> passes;
+	bool compiled = false;
+
+	// the backbuffer, or a cached framebuffer with the written textures attached; the viewport covers the targets
+	void
+	bind_render_targets(const Pass& pass)
+	{
+		if (pass.writes.empty())
+			return;
+
+		std::vector<GLuint> colors;
+		GLuint depth = 0;
+		GLenum depth_format = GL_NONE;
+		bool backbuffer = false;
+		for (FrameGraphResource write : pass.writes)
+		{
+			const Resource& resource = resources[write];
+			if (resource.imported && resource.texture == 0)
+				backbuffer = true;
+			else if (is_depth_format(resource.desc.internal_format))
+			{
+				depth = resource.texture;
+				depth_format = resource.desc.internal_format;
+			}
+			else
+				colors.push_back(resource.texture);
+		}
+
+		const FrameGraphTextureDesc& desc = resources[pass.writes.front()].desc;
+		glBindFramebuffer(GL_FRAMEBUFFER, backbuffer ? 0 : pool.get_framebuffer(colors, depth, depth_format));
+		glViewport(0, 0, desc.width, desc.height);
+	}
+};
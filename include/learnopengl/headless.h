@@ -0,0 +1,352 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <stb_image.h>
+
+#include <learnopengl/camera.h>
+#include <learnopengl/frame_capture.h>
+#include <learnopengl/input_replay.h>
+
+// Options of a demo run for a fixed number of frames without a visible window, e.g.
+// 4.advanced_opengl__5.1.framebuffers --frames 120 --golden framebuffers.png --stats framebuffers.json
+// Without --frames the demo stays interactive. The input options work in both modes, e.g. record a session
+// interactively with --record session.input, then compare two builds with --frames 600 --replay session.input.
+struct HeadlessOptions
+{
+	int frames = 0;
+	// PNG the last frame is written to
+	std::string output;
+	// PNG the last frame is compared with
+	std::string golden;
+	// perceptual difference above which a pixel counts as different, 0 to 1
+	float tolerance = 0.1f;
+	// fraction of the pixels allowed to differ, rasterization differs slightly between drivers
+	float max_different = 0.001f;
+	// JSON file the frame times and the comparison are written to
+	std::string stats;
+	// input log to write or to play back, see InputReplay
+	std::string record;
+	std::string replay;
+	// frame time of the replay instead of the recorded one
+	float time_step = 0.0f;
+	// authored camera path the camera follows, see CameraPath
+	std::string camera_path;
+
+	bool
+	is_enabled() const
+	{
+		return frames > 0;
+	}
+};
+
+// reads --frames, --output, --golden, --tolerance, --max-different, --stats, --record, --replay, --time-step and
+// --camera-path, prints the usage on anything else
+inline HeadlessOptions
+parse_headless_options(int argc, char** argv)
+{
+	HeadlessOptions options;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (!value)
+		{
+			std::cout << "missing value for " << arg << std::endl;
+			std::exit(EXIT_FAILURE);
+		}
+		if (arg == "--frames")
+			options.frames = std::atoi(value);
+		else if (arg == "--output")
+			options.output = value;
+		else if (arg == "--golden")
+			options.golden = value;
+		else if (arg == "--tolerance")
+			options.tolerance = float(std::atof(value));
+		else if (arg == "--max-different")
+			options.max_different = float(std::atof(value));
+		else if (arg == "--stats")
+			options.stats = value;
+		else if (arg == "--record")
+			options.record = value;
+		else if (arg == "--replay")
+			options.replay = value;
+		else if (arg == "--time-step")
+			options.time_step = float(std::atof(value));
+		else if (arg == "--camera-path")
+			options.camera_path = value;
+		else
+		{
+			std::cout << "usage: " << argv[0]
+					  << " [--frames count] [--output last_frame.png] [--golden expected.png] [--tolerance 0.1]"
+						 " [--max-different 0.001] [--stats stats.json] [--record session.input | --replay session.input]"
+						 " [--time-step 0.016667] [--camera-path path.txt]"
+					  << std::endl;
+			std::exit(EXIT_FAILURE);
+		}
+		++i;
+	}
+	return options;
+}
+
+// Perceptual difference of two RGBA8 pixels, 0 to 1: the distance in YIQ space weighted like pixelmatch does, which
+// follows the sensitivity of the eye to luma over chroma better than an RGB distance.
+inline float
+pixel_difference(const uint8_t* a, const uint8_t* b)
+{
+	const float dr = float(a[0]) - b[0], dg = float(a[1]) - b[1], db = float(a[2]) - b[2];
+	const float y = dr * 0.29889531f + dg * 0.58662247f + db * 0.11448223f;
+	const float i = dr * 0.59597799f - dg * 0.27417610f - db * 0.32180189f;
+	const float q = dr * 0.21147017f - dg * 0.52261711f + db * 0.31114694f;
+	return std::sqrt((0.5053f * y * y + 0.299f * i * i + 0.1957f * q * q) / 35215.0f);
+}
+
+// Runs a demo for a fixed number of frames of a fixed time step, with a scripted camera, then checks the last frame
+// against a golden image and writes the frame times as JSON. Usage in a demo:
+//   HeadlessRun headless(parse_headless_options(argc, argv));
+//   headless.apply_window_hints();                   // before glfwCreateWindow
+//   input.install(window, mouse_callback, scroll_callback);
+//   headless.configure_input(input);
+//   deltaTime = input.begin_frame(window, headless.frame_delta(deltaTime));
+//   process_input(window);                           // polling keys with input.get_key()
+//   headless.move_camera(camera, deltaTime);         // scripted, unless the input is replayed
+//   input.update_camera(camera);                     // camera path, if any
+//   headless.end_frame(window);                      // before glfwSwapBuffers, closes the window after the last frame
+//   return headless.exit_code();
+// The frame times include a glFinish, so every frame is measured from start to end on the GPU rather than pipelined.
+class HeadlessRun
+{
+public:
+	// the scripted camera and the time step only depend on the frame number
+	static constexpr float time_step = 1.0f / 60.0f;
+
+	explicit HeadlessRun(HeadlessOptions options) : options(std::move(options))
+	{
+	}
+
+	bool
+	is_enabled() const
+	{
+		return options.is_enabled();
+	}
+
+	void
+	apply_window_hints() const
+	{
+		if (is_enabled())
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	}
+
+	float
+	frame_delta(float measured) const
+	{
+		return is_enabled() ? time_step : measured;
+	}
+
+	// time since the start for demos animated by it rather than by the frame delta, so the last frame does not
+	// depend on how fast the machine is
+	float
+	frame_time(float measured) const
+	{
+		return is_enabled() ? frame * time_step : measured;
+	}
+
+	// starts recording or replaying the input and loads the camera path, as asked by the options
+	bool
+	configure_input(InputReplay& input) const
+	{
+		input.time_step = options.time_step;
+		if (!options.record.empty() && !input.start_recording(options.record))
+		{
+			std::cout << "failed to create the input log " << options.record << std::endl;
+			return false;
+		}
+		if (!options.replay.empty() && !input.start_replay(options.replay))
+		{
+			std::cout << "failed to read the input log " << options.replay << std::endl;
+			return false;
+		}
+		if (!options.camera_path.empty() && !input.load_camera_path(options.camera_path))
+		{
+			std::cout << "failed to read the camera path " << options.camera_path << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	// moves forward for the first third of the run, strafes right for the second, turns left for the last; only
+	// when neither a replay nor a camera path moves the camera
+	void
+	move_camera(Camera& camera, float delta_time) const
+	{
+		if (!is_enabled() || !options.replay.empty() || !options.camera_path.empty())
+			return;
+		const int third = std::max(1, options.frames / 3);
+		if (frame < third)
+			camera.ProcessKeyboard(FORWARD, delta_time);
+		else if (frame < 2 * third)
+			camera.ProcessKeyboard(RIGHT, delta_time);
+		else
+			camera.ProcessMouseMovement(-2.0f, 0.0f);
+	}
+
+	void
+	end_frame(GLFWwindow* window)
+	{
+		if (!is_enabled())
+			return;
+
+		glFinish();
+		const auto now = std::chrono::steady_clock::now();
+		if (frame > 0)
+			frame_ms.push_back(std::chrono::duration<double, std::milli>(now - last_end).count());
+		last_end = now;
+
+		// a replay or camera path that ends early closes the window, the run ends with it
+		if (++frame < options.frames && !glfwWindowShouldClose(window))
+			return;
+		finish(window);
+		glfwSetWindowShouldClose(window, true);
+	}
+
+	// 0 when the run matched the golden image, or had none to match
+	int
+	exit_code() const
+	{
+		return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+private:
+	HeadlessOptions options;
+	int frame = 0;
+	std::chrono::steady_clock::time_point last_end;
+	std::vector<double> frame_ms;
+	bool failed = false;
+
+	void
+	finish(GLFWwindow* window)
+	{
+		int width, height;
+		glfwGetFramebufferSize(window, &width, &height);
+		std::vector<uint8_t> pixels(size_t(width) * height * 4);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		// top row first like the image files
+		const size_t row_size = size_t(width) * 4;
+		for (int y = 0; y < height / 2; ++y)
+			std::swap_ranges(&pixels[y * row_size], &pixels[(y + 1) * row_size], &pixels[(height - 1 - y) * row_size]);
+		// the backbuffer alpha is whatever the last pass wrote, the images are opaque
+		for (size_t i = 3; i < pixels.size(); i += 4)
+			pixels[i] = 255;
+
+		if (!options.output.empty())
+		{
+			const std::vector<uint8_t> png = encode_png(pixels.data(), width, height);
+			std::ofstream file(options.output, std::ios::binary);
+			file.write(reinterpret_cast<const char*>(png.data()), std::streamsize(png.size()));
+			if (!file)
+			{
+				std::cout << "failed to write " << options.output << std::endl;
+				failed = true;
+			}
+		}
+
+		bool compared = false;
+		double different_fraction = 0.0;
+		float max_difference = 0.0f;
+		if (!options.golden.empty())
+		{
+			// demos flip their textures on load, the golden image is top row first
+			stbi_set_flip_vertically_on_load(false);
+			int golden_width, golden_height, channels;
+			uint8_t* golden = stbi_load(options.golden.c_str(), &golden_width, &golden_height, &channels, 4);
+			if (!golden)
+			{
+				std::cout << "failed to load the golden image " << options.golden << std::endl;
+				failed = true;
+			}
+			else if (golden_width != width || golden_height != height)
+			{
+				std::cout << "golden image is " << golden_width << "x" << golden_height << ", the frame " << width
+						  << "x" << height << std::endl;
+				failed = true;
+			}
+			else
+			{
+				size_t different = 0;
+				for (size_t i = 0; i < pixels.size(); i += 4)
+				{
+					const float difference = pixel_difference(&pixels[i], &golden[i]);
+					max_difference = std::max(max_difference, difference);
+					if (difference > options.tolerance)
+						++different;
+				}
+				compared = true;
+				different_fraction = double(different) / (size_t(width) * height);
+				if (different_fraction > options.max_different)
+				{
+					std::cout << "last frame differs from " << options.golden << " in " << different_fraction * 100.0
+							  << "% of the pixels" << std::endl;
+					failed = true;
+				}
+			}
+			stbi_image_free(golden);
+		}
+
+		if (!options.stats.empty())
+			write_stats(compared, different_fraction, max_difference);
+	}
+
+	void
+	write_stats(bool compared, double different_fraction, float max_difference)
+	{
+		std::vector<double> sorted = frame_ms;
+		std::sort(sorted.begin(), sorted.end());
+		auto percentile = [&sorted](double p) {
+			return sorted.empty() ? 0.0 : sorted[std::min(sorted.size() - 1, size_t(p * sorted.size()))];
+		};
+		double total = 0.0;
+		for (double ms : sorted)
+			total += ms;
+
+		FILE* file = std::fopen(options.stats.c_str(), "w");
+		if (!file)
+		{
+			std::cout << "failed to write " << options.stats << std::endl;
+			failed = true;
+			return;
+		}
+		std::fprintf(file, "{\n");
+		std::fprintf(file, "  \"frames\": %d,\n", options.frames);
+		std::fprintf(file, "  \"frame_ms\": {\n");
+		std::fprintf(file, "    \"mean\": %.4f,\n", sorted.empty() ? 0.0 : total / sorted.size());
+		std::fprintf(file, "    \"min\": %.4f,\n", sorted.empty() ? 0.0 : sorted.front());
+		std::fprintf(file, "    \"median\": %.4f,\n", percentile(0.5));
+		std::fprintf(file, "    \"p95\": %.4f,\n", percentile(0.95));
+		std::fprintf(file, "    \"p99\": %.4f,\n", percentile(0.99));
+		std::fprintf(file, "    \"max\": %.4f\n", sorted.empty() ? 0.0 : sorted.back());
+		std::fprintf(file, "  },\n");
+		if (compared)
+		{
+			std::fprintf(file, "  \"golden\": {\n");
+			std::fprintf(file, "    \"different_fraction\": %.6f,\n", different_fraction);
+			std::fprintf(file, "    \"max_difference\": %.4f\n", max_difference);
+			std::fprintf(file, "  },\n");
+		}
+		std::fprintf(file, "  \"passed\": %s\n", failed ? "false" : "true");
+		std::fprintf(file, "}\n");
+		std::fclose(file);
+	}
+};
@@ -0,0 +1,349 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/camera.h>
+
+// Camera keyframes of a text file, one per line: time in seconds, position, yaw and pitch in degrees, e.g.
+//   # t    x     y    z    yaw    pitch
+//   0.0    0.0   0.0  3.0  -90.0  0.0
+//   2.5    2.0   0.5  2.0  -110.0 -5.0
+// The camera follows a Catmull-Rom spline through them, so it passes every keyframe with a continuous velocity.
+class CameraPath
+{
+public:
+	struct Keyframe
+	{
+		float time;
+		glm::vec3 position;
+		float yaw;
+		float pitch;
+	};
+
+	bool
+	load(const std::string& path)
+	{
+		std::ifstream file(path);
+		if (!file)
+			return false;
+		keyframes.clear();
+		std::string line;
+		while (std::getline(file, line))
+		{
+			if (line.empty() || line[0] == '#')
+				continue;
+			std::istringstream stream(line);
+			Keyframe keyframe;
+			if (stream >> keyframe.time >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z >>
+				keyframe.yaw >> keyframe.pitch)
+				keyframes.push_back(keyframe);
+		}
+		std::sort(keyframes.begin(), keyframes.end(), [](const Keyframe& a, const Keyframe& b) {
+			return a.time < b.time;
+		});
+		return !keyframes.empty();
+	}
+
+	float
+	get_duration() const
+	{
+		return keyframes.empty() ? 0.0f : keyframes.back().time;
+	}
+
+	// pose at time, held at the first and last keyframes outside the path
+	Keyframe
+	evaluate(float time) const
+	{
+		if (keyframes.size() < 2 || time <= keyframes.front().time)
+			return keyframes.empty() ? Keyframe{0.0f, glm::vec3(0.0f), -90.0f, 0.0f} : keyframes.front();
+		if (time >= keyframes.back().time)
+			return keyframes.back();
+
+		size_t i = 1;
+		while (keyframes[i].time < time)
+			++i;
+		// the ends are repeated to get the tangents of the first and last segments
+		const Keyframe& p0 = keyframes[i > 1 ? i - 2 : 0];
+		const Keyframe& p1 = keyframes[i - 1];
+		const Keyframe& p2 = keyframes[i];
+		const Keyframe& p3 = keyframes[std::min(i + 1, keyframes.size() - 1)];
+		const float t = (time - p1.time) / (p2.time - p1.time);
+
+		Keyframe result;
+		result.time = time;
+		result.position = catmull_rom(p0.position, p1.position, p2.position, p3.position, t);
+		result.yaw = catmull_rom(glm::vec3(p0.yaw), glm::vec3(p1.yaw), glm::vec3(p2.yaw), glm::vec3(p3.yaw), t).x;
+		result.pitch =
+			catmull_rom(glm::vec3(p0.pitch), glm::vec3(p1.pitch), glm::vec3(p2.pitch), glm::vec3(p3.pitch), t).x;
+		return result;
+	}
+
+private:
+	std::vector<Keyframe> keyframes;
+
+	static glm::vec3
+	catmull_rom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t)
+	{
+		const float t2 = t * t, t3 = t2 * t;
+		return 0.5f * (2.0f * p1 + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+					   (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+	}
+};
+
+// Records the input of a demo and plays it back, so two runs render exactly the same frames. The log holds, per frame,
+// the frame time and the input events of that frame:
+// - the cursor positions and scroll offsets the GLFW callbacks received since the previous frame,
+// - the state of every key the demo polled, when it changed.
+// While replaying, live input is ignored: get_key() answers from the log and the recorded cursor and scroll events are
+// sent to the demo's callbacks. The window closes at the end of the log, or of the camera path.
+// The log is written in the byte order of the machine recording it.
+class InputReplay
+{
+public:
+	enum class Mode
+	{
+		live,
+		record,
+		replay,
+	};
+
+	// frame time used while replaying instead of the recorded one, 0 to keep the recording's
+	float time_step = 0.0f;
+
+	~InputReplay()
+	{
+		if (mode == Mode::record)
+			output.write(output_frame.data(), std::streamsize(output_frame.size()));
+	}
+
+	// the GLFW cursor and scroll callbacks go through the replay, which calls these
+	void
+	install(GLFWwindow* window, GLFWcursorposfun cursor_callback, GLFWscrollfun scroll_callback)
+	{
+		demo_cursor_callback = cursor_callback;
+		demo_scroll_callback = scroll_callback;
+		glfwSetWindowUserPointer(window, this);
+		glfwSetCursorPosCallback(window, [](GLFWwindow* window, double x, double y) {
+			static_cast<InputReplay*>(glfwGetWindowUserPointer(window))->on_cursor(window, x, y);
+		});
+		glfwSetScrollCallback(window, [](GLFWwindow* window, double x, double y) {
+			static_cast<InputReplay*>(glfwGetWindowUserPointer(window))->on_scroll(window, x, y);
+		});
+	}
+
+	bool
+	start_recording(const std::string& path)
+	{
+		output.open(path, std::ios::binary);
+		if (!output)
+			return false;
+		output.write(magic, sizeof(magic));
+		mode = Mode::record;
+		return true;
+	}
+
+	bool
+	start_replay(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		char header[sizeof(magic)] = {};
+		if (!file.read(header, sizeof(header)) || std::memcmp(header, magic, sizeof(magic)) != 0)
+			return false;
+		log.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		position = 0;
+		mode = Mode::replay;
+		return true;
+	}
+
+	// the camera follows the path from the first frame on, instead of the input
+	bool
+	load_camera_path(const std::string& path)
+	{
+		has_camera_path = camera_path.load(path);
+		return has_camera_path;
+	}
+
+	Mode
+	get_mode() const
+	{
+		return mode;
+	}
+
+	// start of every frame, before the input is processed: returns the frame time to use
+	float
+	begin_frame(GLFWwindow* window, float measured_delta_time)
+	{
+		float delta_time = measured_delta_time;
+		if (mode == Mode::record)
+		{
+			write(output_frame, Event::frame);
+			write(output_frame, measured_delta_time);
+			// the callbacks ran while polling the events at the end of the previous frame
+			output_frame.insert(output_frame.end(), callback_events.begin(), callback_events.end());
+			callback_events.clear();
+			output.write(output_frame.data(), std::streamsize(output_frame.size()));
+			output_frame.clear();
+		}
+		else if (mode == Mode::replay)
+		{
+			if (position >= log.size() || log[position] != char(Event::frame))
+			{
+				glfwSetWindowShouldClose(window, true);
+				mode = Mode::live;
+				return measured_delta_time;
+			}
+			++position;
+			float recorded = read<float>();
+			delta_time = time_step > 0.0f ? time_step : recorded;
+
+			// the events of this frame, up to the next frame
+			while (position < log.size() && log[position] != char(Event::frame))
+			{
+				const Event event = Event(log[position++]);
+				if (event == Event::key)
+				{
+					const int16_t key = read<int16_t>();
+					const uint8_t state = read<uint8_t>();
+					if (key >= 0 && size_t(key) < key_states.size())
+						key_states[size_t(key)] = state;
+				}
+				else
+				{
+					const double x = read<double>();
+					const double y = read<double>();
+					if (event == Event::cursor && demo_cursor_callback)
+						demo_cursor_callback(window, x, y);
+					else if (event == Event::scroll && demo_scroll_callback)
+						demo_scroll_callback(window, x, y);
+				}
+			}
+		}
+
+		// the path starts at 0 on the first frame
+		path_time = elapsed_time;
+		elapsed_time += delta_time;
+		if (has_camera_path && path_time > camera_path.get_duration())
+			glfwSetWindowShouldClose(window, true);
+		return delta_time;
+	}
+
+	// glfwGetKey, recorded or replayed
+	int
+	get_key(GLFWwindow* window, int key)
+	{
+		if (key < 0 || size_t(key) >= key_states.size())
+			return glfwGetKey(window, key);
+		if (mode == Mode::replay)
+			return key_states[size_t(key)];
+
+		const int state = glfwGetKey(window, key);
+		if (mode == Mode::record && state != key_states[size_t(key)])
+		{
+			write(output_frame, Event::key);
+			write(output_frame, int16_t(key));
+			write(output_frame, uint8_t(state));
+		}
+		key_states[size_t(key)] = uint8_t(state);
+		return state;
+	}
+
+	// after the input was processed: overrides the camera with the path, if one was loaded
+	void
+	update_camera(Camera& camera) const
+	{
+		if (!has_camera_path)
+			return;
+		const CameraPath::Keyframe pose = camera_path.evaluate(path_time);
+		camera.SetPose(pose.position, pose.yaw, pose.pitch);
+	}
+
+private:
+	enum class Event : char
+	{
+		frame,
+		key,
+		cursor,
+		scroll,
+	};
+
+	static constexpr char magic[8] = {'L', 'O', 'G', 'L', 'I', 'N', '0', '1'};
+
+	Mode mode = Mode::live;
+	std::ofstream output;
+	// events of the frame being recorded, written out when the next one begins, after the callback events that
+	// arrived in between
+	std::vector<char> output_frame;
+	std::vector<char> callback_events;
+	std::vector<char> log;
+	size_t position = 0;
+
+	// GLFW_KEY_LAST is 348
+	std::array<uint8_t, 349> key_states{};
+	GLFWcursorposfun demo_cursor_callback = nullptr;
+	GLFWscrollfun demo_scroll_callback = nullptr;
+
+	CameraPath camera_path;
+	bool has_camera_path = false;
+	float path_time = 0.0f;
+	float elapsed_time = 0.0f;
+
+	template<typename T>
+	static void
+	write(std::vector<char>& to, T value)
+	{
+		const char* bytes = reinterpret_cast<const char*>(&value);
+		to.insert(to.end(), bytes, bytes + sizeof(T));
+	}
+
+	template<typename T>
+	T
+	read()
+	{
+		T value{};
+		if (position + sizeof(T) <= log.size())
+			std::memcpy(&value, &log[position], sizeof(T));
+		position += sizeof(T);
+		return value;
+	}
+
+	void
+	on_cursor(GLFWwindow* window, double x, double y)
+	{
+		if (mode == Mode::replay)
+			return;
+		if (mode == Mode::record)
+		{
+			write(callback_events, Event::cursor);
+			write(callback_events, x);
+			write(callback_events, y);
+		}
+		if (demo_cursor_callback)
+			demo_cursor_callback(window, x, y);
+	}
+
+	void
+	on_scroll(GLFWwindow* window, double x, double y)
+	{
+		if (mode == Mode::replay)
+			return;
+		if (mode == Mode::record)
+		{
+			write(callback_events, Event::scroll);
+			write(callback_events, x);
+			write(callback_events, y);
+		}
+		if (demo_scroll_callback)
+			demo_scroll_callback(window, x, y);
+	}
+};
@@ -0,0 +1,269 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using Job = std::function<void()>;
+
+// Counts the unfinished jobs attached to it. Jobs scheduled with run_after start once it drops to zero.
+class JobCounter
+{
+public:
+	JobCounter() = default;
+	JobCounter(const JobCounter&) = delete;
+	JobCounter&
+	operator=(const JobCounter&) = delete;
+
+	bool
+	is_done() const
+	{
+		return pending.load(std::memory_order_acquire) == 0;
+	}
+
+private:
+	friend class JobSystem;
+
+	std::atomic<int> pending{0};
+
+	// guards the continuations and the last decrement of pending
+	std::mutex mutex;
+	std::vector<std::pair<Job, JobCounter*>> continuations;
+};
+
+// Fixed size work stealing thread pool. Every thread owns a queue: it pushes and pops its own jobs at the back and
+// steals from the front of the others when it runs dry. Threads that don't belong to the pool share queue 0.
+class JobSystem
+{
+public:
+	// the thread calling wait() helps executing jobs, so by default one worker less than the hardware threads
+	explicit JobSystem(unsigned int worker_count = std::max(1u, std::thread::hardware_concurrency()) - 1)
+	{
+		for (unsigned int i = 0; i < worker_count + 1; ++i)
+			queues.push_back(std::make_unique<Queue>());
+		for (unsigned int i = 0; i < worker_count; ++i)
+			workers.emplace_back(&JobSystem::worker_loop, this, i + 1);
+	}
+
+	~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleep_mutex);
+			quit = true;
+		}
+		sleep_cv.notify_all();
+		for (auto&& worker : workers)
+			worker.join();
+	}
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem&
+	operator=(const JobSystem&) = delete;
+
+	// number of threads executing jobs, including the one waiting
+	unsigned int
+	get_thread_count() const
+	{
+		return static_cast<unsigned int>(queues.size());
+	}
+
+	// index of the calling thread in [0, get_thread_count()), 0 for threads outside the pool. Handy to give every
+	// thread its own output buffer.
+	unsigned int
+	get_thread_index() const
+	{
+		return tls_owner == this ? tls_index : 0;
+	}
+
+	void
+	run(Job job, JobCounter* counter = nullptr)
+	{
+		if (counter)
+			counter->pending.fetch_add(1, std::memory_order_relaxed);
+		push({std::move(job), counter});
+	}
+
+	// schedule job once every job attached to dependency finished
+	void
+	run_after(JobCounter& dependency, Job job, JobCounter* counter = nullptr)
+	{
+		if (counter)
+			counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+		{
+			std::lock_guard<std::mutex> lock(dependency.mutex);
+			if (dependency.pending.load(std::memory_order_acquire) != 0)
+			{
+				dependency.continuations.emplace_back(std::move(job), counter);
+				return;
+			}
+		}
+		push({std::move(job), counter});
+	}
+
+	// execute pending jobs on the calling thread until every job attached to counter finished
+	void
+	wait(JobCounter& counter)
+	{
+		const unsigned int index = get_thread_index();
+		while (!counter.is_done())
+		{
+			Task task;
+			if (try_pop(index, task))
+				execute(task);
+			else
+				std::this_thread::yield();
+		}
+		// the thread finishing the last job may still hold the lock, don't let the caller destroy it before
+		std::lock_guard<std::mutex> lock(counter.mutex);
+	}
+
+	// calls fn(first, last) over sub ranges of [begin, end) of at most grain elements and waits for all of them.
+	// A grain of 0 picks a size giving every thread a few ranges.
+	template<typename Function>
+	void
+	parallel_for(size_t begin, size_t end, size_t grain, Function&& fn)
+	{
+		if (begin >= end)
+			return;
+		if (grain == 0)
+			grain = std::max<size_t>(1, (end - begin) / (get_thread_count() * 4));
+
+		JobCounter counter;
+		for (size_t first = begin; first < end; first += grain)
+		{
+			const size_t last = std::min(end, first + grain);
+			run([&fn, first, last] { fn(first, last); }, &counter);
+		}
+		wait(counter);
+	}
+
+private:
+	struct Task
+	{
+		Job job;
+		JobCounter* counter = nullptr;
+	};
+
+	struct alignas(64) Queue
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> workers;
+
+	std::atomic<int> queued{0};
+	std::atomic<int> sleeping{0};
+	std::mutex sleep_mutex;
+	std::condition_variable sleep_cv;
+	bool quit = false;
+
+	static inline thread_local const JobSystem* tls_owner = nullptr;
+	static inline thread_local unsigned int tls_index = 0;
+
+	void
+	push(Task task)
+	{
+		Queue& queue = *queues[get_thread_index()];
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.tasks.push_back(std::move(task));
+		}
+		queued.fetch_add(1);
+
+		// pairs with the check in worker_loop: either the worker sees the job or we see the worker asleep
+		if (sleeping.load() > 0)
+		{
+			std::lock_guard<std::mutex> lock(sleep_mutex);
+			sleep_cv.notify_one();
+		}
+	}
+
+	bool
+	try_pop(unsigned int index, Task& task)
+	{
+		if (queued.load(std::memory_order_relaxed) == 0)
+			return false;
+
+		// own queue first, newest job for cache locality
+		{
+			Queue& queue = *queues[index];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.tasks.empty())
+			{
+				task = std::move(queue.tasks.back());
+				queue.tasks.pop_back();
+				queued.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+
+		// then steal the oldest job of the others
+		for (size_t i = 1; i < queues.size(); ++i)
+		{
+			Queue& queue = *queues[(index + i) % queues.size()];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.tasks.empty())
+			{
+				task = std::move(queue.tasks.front());
+				queue.tasks.pop_front();
+				queued.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void
+	execute(Task& task)
+	{
+		task.job();
+		if (task.counter)
+			finish(*task.counter);
+	}
+
+	void
+	finish(JobCounter& counter)
+	{
+		std::vector<std::pair<Job, JobCounter*>> ready;
+		{
+			std::lock_guard<std::mutex> lock(counter.mutex);
+			if (counter.pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				ready.swap(counter.continuations);
+		}
+		for (auto&& continuation : ready)
+			push({std::move(continuation.first), continuation.second});
+	}
+
+	void
+	worker_loop(unsigned int index)
+	{
+		tls_owner = this;
+		tls_index = index;
+
+		while (true)
+		{
+			Task task;
+			if (try_pop(index, task))
+			{
+				execute(task);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(sleep_mutex);
+			sleeping.fetch_add(1);
+			sleep_cv.wait(lock, [this] { return quit || queued.load() > 0; });
+			sleeping.fetch_sub(1);
+			if (quit)
+				return;
+		}
+	}
+};
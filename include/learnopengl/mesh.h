@@ -7,6 +7,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <learnopengl/shader.h>
+#include <learnopengl/triangle_bvh.h>
 
 #include <string>
 #include <vector>
@@ -47,6 +48,11 @@ public:
 	vector<unsigned int> indices;
 	vector<Texture> textures;
 	unsigned int VAO;
+	// local space bounds of the vertices
+	glm::vec3 aabbMin = glm::vec3(0.0f);
+	glm::vec3 aabbMax = glm::vec3(0.0f);
+	// triangle hierarchy for ray queries, empty until buildBVH() is called
+	TriangleBVH bvh;
 
 	// constructor
 	Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
@@ -57,11 +63,13 @@ public:
 
 		// now that we have all the required data, set the vertex buffers and its attribute pointers.
 		setupMesh();
+		computeBounds();
 	}
 
-	// render the mesh
+	// render the mesh. A base instance other than 0 offsets the per-instance attributes, e.g. to pick the record of
+	// this draw in a buffer of per-draw data, and needs OpenGL 4.2
 	void
-	Draw(Shader& shader)
+	Draw(Shader& shader, unsigned int baseInstance = 0)
 	{
 		// bind appropriate textures
 		unsigned int diffuseNr = 1;
@@ -91,17 +99,47 @@ public:
 
 		// draw mesh
 		glBindVertexArray(VAO);
-		glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
+		if (baseInstance == 0)
+			glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
+		else
+			glDrawElementsInstancedBaseInstance(
+				GL_TRIANGLES,
+				static_cast<unsigned int>(indices.size()),
+				GL_UNSIGNED_INT,
+				0,
+				1,
+				baseInstance);
 		glBindVertexArray(0);
 
 		// always good practice to set everything back to defaults once configured.
 		glActiveTexture(GL_TEXTURE0);
 	}
 
+	// builds the triangle hierarchy from the CPU copy of the vertices, in parallel when a job system is given
+	void
+	buildBVH(JobSystem* jobSystem = nullptr)
+	{
+		bvh.build(vertices, indices, jobSystem);
+	}
+
 private:
 	// render data
 	unsigned int VBO, EBO;
 
+	// computes the local space bounding box used for culling
+	void
+	computeBounds()
+	{
+		if (vertices.empty())
+			return;
+		aabbMin = aabbMax = vertices[0].Position;
+		for (const Vertex& vertex : vertices)
+		{
+			aabbMin = glm::min(aabbMin, vertex.Position);
+			aabbMax = glm::max(aabbMax, vertex.Position);
+		}
+	}
+
 	// initializes all the buffer objects/arrays
 	void
 	setupMesh()
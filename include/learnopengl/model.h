@@ -32,17 +32,57 @@ public:
     string directory;
     bool gammaCorrection;
 
+    // constructor for a model without meshes, e.g. for entities that are only used as transform nodes.
+    Model() : gammaCorrection(false)
+    {
+    }
+
     // constructor, expects a filepath to a 3D model.
     Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
     {
         loadModel(path);
     }
 
-    // draws the model, and thus all its meshes
-    void Draw(Shader &shader)
+    // draws the model, and thus all its meshes, see Mesh::Draw for the base instance
+    void Draw(Shader &shader, unsigned int baseInstance = 0)
     {
         for(unsigned int i = 0; i < meshes.size(); i++)
-            meshes[i].Draw(shader);
+            meshes[i].Draw(shader, baseInstance);
+    }
+
+    // builds the triangle BVH of every mesh for raycast(), meshes and their subtrees in parallel when a job system is given.
+    // Best called right after loading.
+    void buildBVH(JobSystem* jobSystem = nullptr)
+    {
+        if(!jobSystem)
+        {
+            for(unsigned int i = 0; i < meshes.size(); i++)
+                meshes[i].buildBVH();
+            return;
+        }
+        jobSystem->parallel_for(0, meshes.size(), 1, [this, jobSystem](size_t first, size_t last) {
+            for(size_t i = first; i < last; i++)
+                meshes[i].buildBVH(jobSystem);
+        });
+    }
+
+    // closest hit of a model space ray with the triangles of the model, closer than maxDistance. Meshes without a BVH
+    // get one built first, so call buildBVH() beforehand when raycasting from several threads.
+    bool raycast(const glm::vec3 &origin, const glm::vec3 &direction, RayHit &hit, float maxDistance = std::numeric_limits<float>::max())
+    {
+        bool found = false;
+        for(unsigned int i = 0; i < meshes.size(); i++)
+        {
+            if(meshes[i].bvh.empty() && !meshes[i].indices.empty())
+                meshes[i].buildBVH();
+            if(meshes[i].bvh.intersect(origin, direction, maxDistance, hit))
+            {
+                found = true;
+                maxDistance = hit.distance;
+                hit.mesh = i;
+            }
+        }
+        return found;
     }
     
 private:
@@ -0,0 +1,507 @@
+#pragma once
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/frame_graph.h>
+#include <learnopengl/shader.h>
+
+// Kernel effects read the 3x3 neighborhood of a pixel, the others only the pixel itself. upscale_sharpen is meant for
+// an input smaller than the output: the bilinear upscale of the first pass, sharpened with contrast adaptive
+// sharpening.
+enum class PostEffect
+{
+	upscale_sharpen,
+	sharpen,
+	blur,
+	edge_detect,
+	invert,
+	grayscale,
+	color_grading,
+	tonemap,
+	vignette,
+	fxaa,
+};
+
+inline bool
+is_kernel_effect(PostEffect effect)
+{
+	return effect == PostEffect::upscale_sharpen || effect == PostEffect::sharpen || effect == PostEffect::blur ||
+		   effect == PostEffect::edge_detect || effect == PostEffect::fxaa;
+}
+
+inline const char*
+get_post_effect_name(PostEffect effect)
+{
+	switch (effect)
+	{
+	case PostEffect::upscale_sharpen:
+		return "upscale_sharpen";
+	case PostEffect::sharpen:
+		return "sharpen";
+	case PostEffect::blur:
+		return "blur";
+	case PostEffect::edge_detect:
+		return "edge_detect";
+	case PostEffect::invert:
+		return "invert";
+	case PostEffect::grayscale:
+		return "grayscale";
+	case PostEffect::color_grading:
+		return "color_grading";
+	case PostEffect::tonemap:
+		return "tonemap";
+	case PostEffect::vignette:
+		return "vignette";
+	case PostEffect::fxaa:
+		return "fxaa";
+	}
+	return "";
+}
+
+struct PostProcessSettings
+{
+	// upscale sharpening, 0 to 1
+	float sharpness = 0.5f;
+	// tonemap
+	float exposure = 1.0f;
+	// color grading
+	glm::vec3 tint = glm::vec3(1.0f);
+	float saturation = 1.0f;
+	float contrast = 1.0f;
+	// vignette, the darkening starts at radius from the center and reaches strength at the corners
+	float vignette_strength = 0.5f;
+	float vignette_radius = 0.5f;
+	// FXAA 3.11 quality preset: 10 to 15, 20 to 29 or 39, more search steps for higher values; see fxaa_search_steps()
+	int fxaa_quality_preset = 12;
+	// amount of sub-pixel aliasing removal, 0 to 1
+	float fxaa_subpix = 0.75f;
+	// local contrast needed to process a pixel, relative to the brightest neighbor, and its absolute minimum
+	float fxaa_edge_threshold = 0.166f;
+	float fxaa_edge_threshold_min = 0.0833f;
+};
+
+// distances in texels between the edge end searches of an FXAA 3.11 quality preset; unknown presets use 12
+inline std::vector<float>
+fxaa_search_steps(int preset)
+{
+	switch (preset)
+	{
+	case 10:
+		return {1.5f, 3.0f, 12.0f};
+	case 11:
+		return {1.0f, 1.5f, 3.0f, 12.0f};
+	case 13:
+		return {1.0f, 1.5f, 2.0f, 2.0f, 4.0f, 12.0f};
+	case 14:
+		return {1.0f, 1.5f, 2.0f, 2.0f, 2.0f, 4.0f, 12.0f};
+	case 15:
+		return {1.0f, 1.5f, 2.0f, 2.0f, 2.0f, 2.0f, 4.0f, 12.0f};
+	case 20:
+		return {1.5f, 2.0f, 8.0f};
+	case 21:
+		return {1.0f, 1.5f, 2.0f, 8.0f};
+	case 22:
+		return {1.0f, 1.5f, 2.0f, 2.0f, 8.0f};
+	case 23:
+		return {1.0f, 1.5f, 2.0f, 2.0f, 2.0f, 8.0f};
+	case 24:
+		return {1.0f, 1.5f, 2.0f, 2.0f, 2.0f, 3.0f, 8.0f};
+	case 25:
+		return {1.0f, 1.5f, 2.0f, 2.0f, 2.0f, 2.0f, 4.0f, 8.0f};
+	case 26:
+		return {1.0f, 1.5f, 2.0f, 2.0f, 2.0f, 2.0f, 2.0f, 4.0f, 8.0f};
+	case 27:
+		return {1.0f, 1.5f, 2.0f, 2.0f, 2.0f, 2.0f, 2.0f, 2.0f, 4.0f, 8.0f};
+	case 28:
+		return {1.0f, 1.5f, 2.0f, 2.0f, 2.0f, 2.0f, 2.0f, 2.0f, 2.0f, 4.0f, 8.0f};
+	case 29:
+		return {1.0f, 1.5f, 2.0f, 2.0f, 2.0f, 2.0f, 2.0f, 2.0f, 2.0f, 2.0f, 4.0f, 8.0f};
+	case 39:
+		return {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.5f, 2.0f, 2.0f, 2.0f, 2.0f, 4.0f, 8.0f};
+	default:
+		return {1.0f, 1.5f, 2.0f, 4.0f, 12.0f};
+	}
+}
+
+// Runs a chain of screen effects with as few full screen passes as possible. Consecutive per pixel effects are fused
+// into one generated fragment shader, so they cost one read and one write of the frame however many there are. Only a
+// kernel effect needs its input fully written, since it samples the neighbors, so it starts a new pass and the per
+// pixel effects after it are fused behind it. The generated programs are compiled once per pass configuration and
+// cached.
+class PostProcessor
+{
+public:
+	PostProcessSettings settings;
+
+	PostProcessor()
+	{
+		// vertex attributes for a quad that fills the entire screen in Normalized Device Coordinates.
+		const float quad_vertices[] = {
+			// positions   // texCoords
+			-1.0f, 1.0f, 0.0f, 1.0f, -1.0f, -1.0f, 0.0f, 0.0f, 1.0f, -1.0f, 1.0f, 0.0f,
+			-1.0f, 1.0f, 0.0f, 1.0f, 1.0f,  -1.0f, 1.0f, 0.0f, 1.0f, 1.0f,  1.0f, 1.0f};
+		glGenVertexArrays(1, &quad_vao);
+		glGenBuffers(1, &quad_vbo);
+		glBindVertexArray(quad_vao);
+		glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(quad_vertices), quad_vertices, GL_STATIC_DRAW);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+		glBindVertexArray(0);
+	}
+
+	PostProcessor(const PostProcessor&) = delete;
+	PostProcessor& operator=(const PostProcessor&) = delete;
+
+	~PostProcessor()
+	{
+		for (auto&& shader : shaders)
+			glDeleteProgram(shader.second.ID);
+		glDeleteVertexArrays(1, &quad_vao);
+		glDeleteBuffers(1, &quad_vbo);
+	}
+
+	// Adds one frame graph pass per fused pass, reading input and writing output. The intermediate targets have the
+	// format of input and the size of output, so a smaller input is upscaled by the first pass. An empty chain copies
+	// input to output.
+	void
+	add_passes(FrameGraph& graph, const std::vector<PostEffect>& chain, FrameGraphResource input, FrameGraphResource output)
+	{
+		std::vector<std::vector<PostEffect>> passes = split_passes(chain);
+		if (passes.empty())
+			passes.emplace_back();
+
+		FrameGraphTextureDesc intermediate_desc = graph.get_desc(output);
+		intermediate_desc.internal_format = graph.get_desc(input).internal_format;
+		FrameGraphResource source = input;
+		for (size_t i = 0; i < passes.size(); ++i)
+		{
+			const bool last = i + 1 == passes.size();
+			Shader* shader = &get_shader(passes[i]);
+			FrameGraphResource target = output;
+			graph.add_pass(
+				get_key(passes[i], settings.fxaa_quality_preset),
+				[&](FrameGraph::Builder& builder) {
+					builder.read(source);
+					target = last ? builder.write(output)
+								  : builder.create("post process " + std::to_string(i), intermediate_desc);
+				},
+				[this, shader, source](const FrameGraph& graph) {
+					glDisable(GL_DEPTH_TEST);
+					const FrameGraphTextureDesc& desc = graph.get_desc(source);
+					shader->use();
+					shader->setInt("screenTexture", 0);
+					shader->setVec2("texelSize", 1.0f / desc.width, 1.0f / desc.height);
+					set_uniforms(*shader);
+					glActiveTexture(GL_TEXTURE0);
+					glBindTexture(GL_TEXTURE_2D, graph.get_texture(source));
+					glBindVertexArray(quad_vao);
+					glDrawArrays(GL_TRIANGLES, 0, 6);
+					glBindVertexArray(0);
+				});
+			source = target;
+		}
+	}
+
+	// fused passes of the chain: a kernel effect only as the first effect of a pass
+	static std::vector<std::vector<PostEffect>>
+	split_passes(const std::vector<PostEffect>& chain)
+	{
+		std::vector<std::vector<PostEffect>> passes;
+		for (PostEffect effect : chain)
+		{
+			if (passes.empty() || is_kernel_effect(effect))
+				passes.emplace_back();
+			passes.back().push_back(effect);
+		}
+		return passes;
+	}
+
+	static std::string
+	generate_fragment_shader(const std::vector<PostEffect>& pass, int fxaa_quality_preset = 12)
+	{
+		std::string code = "#version 330 core\n"
+						   "out vec4 FragColor;\n"
+						   "\n"
+						   "in vec2 TexCoords;\n"
+						   "\n"
+						   "uniform sampler2D screenTexture;\n"
+						   "uniform vec2 texelSize;\n"
+						   "uniform float sharpness;\n"
+						   "uniform float exposure;\n"
+						   "uniform vec3 tint;\n"
+						   "uniform float saturation;\n"
+						   "uniform float contrast;\n"
+						   "uniform float vignetteStrength;\n"
+						   "uniform float vignetteRadius;\n"
+						   "uniform float fxaaSubpix;\n"
+						   "uniform float fxaaEdgeThreshold;\n"
+						   "uniform float fxaaEdgeThresholdMin;\n"
+						   "\n"
+						   "const vec3 luma = vec3(0.2126, 0.7152, 0.0722);\n"
+						   "\n"
+						   "void main() {\n";
+
+		size_t first = 0;
+		if (!pass.empty() && is_kernel_effect(pass.front()))
+		{
+			code += "    // " + std::string(get_post_effect_name(pass.front())) + "\n" + kernel_code(pass.front(), fxaa_quality_preset);
+			first = 1;
+		}
+		else
+			code += "    vec3 color = texture(screenTexture, TexCoords).rgb;\n";
+
+		for (size_t i = first; i < pass.size(); ++i)
+			code += "    // " + std::string(get_post_effect_name(pass[i])) + "\n" + pixel_code(pass[i]);
+
+		code += "    FragColor = vec4(color, 1.0);\n"
+				"}\n";
+		return code;
+	}
+
+	size_t
+	get_cached_shader_count() const
+	{
+		return shaders.size();
+	}
+
+private:
+	std::map<std::string, Shader> shaders;
+	unsigned int quad_vao = 0;
+	unsigned int quad_vbo = 0;
+
+	static constexpr const char* vertex_code = "#version 330 core\n"
+											   "layout (location = 0) in vec2 aPos;\n"
+											   "layout (location = 1) in vec2 aTexCoords;\n"
+											   "\n"
+											   "out vec2 TexCoords;\n"
+											   "\n"
+											   "void main()\n"
+											   "{\n"
+											   "    TexCoords = aTexCoords;\n"
+											   "    gl_Position = vec4(aPos.x, aPos.y, 0.0, 1.0);\n"
+											   "}\n";
+
+	// the FXAA preset changes the generated code, so it is part of the key of passes using it
+	static std::string
+	get_key(const std::vector<PostEffect>& pass, int fxaa_quality_preset)
+	{
+		std::string key = "copy";
+		for (size_t i = 0; i < pass.size(); ++i)
+			key = i == 0 ? get_post_effect_name(pass[i]) : key + "+" + get_post_effect_name(pass[i]);
+		if (std::find(pass.begin(), pass.end(), PostEffect::fxaa) != pass.end())
+			key += std::to_string(fxaa_quality_preset);
+		return key;
+	}
+
+	Shader&
+	get_shader(const std::vector<PostEffect>& pass)
+	{
+		const std::string key = get_key(pass, settings.fxaa_quality_preset);
+		auto found = shaders.find(key);
+		if (found == shaders.end())
+		{
+			const std::string fragment_code = generate_fragment_shader(pass, settings.fxaa_quality_preset);
+			found = shaders.emplace(key, Shader::fromSource(vertex_code, fragment_code)).first;
+		}
+		return found->second;
+	}
+
+	void
+	set_uniforms(Shader& shader) const
+	{
+		shader.setFloat("sharpness", settings.sharpness);
+		shader.setFloat("exposure", settings.exposure);
+		shader.setVec3("tint", settings.tint);
+		shader.setFloat("saturation", settings.saturation);
+		shader.setFloat("contrast", settings.contrast);
+		shader.setFloat("vignetteStrength", settings.vignette_strength);
+		shader.setFloat("vignetteRadius", settings.vignette_radius);
+		shader.setFloat("fxaaSubpix", settings.fxaa_subpix);
+		shader.setFloat("fxaaEdgeThreshold", settings.fxaa_edge_threshold);
+		shader.setFloat("fxaaEdgeThresholdMin", settings.fxaa_edge_threshold_min);
+	}
+
+	// 3x3 convolution of the input, the weights of the kernels of the framebuffers chapter
+	static std::string
+	kernel_code(PostEffect effect, int fxaa_quality_preset)
+	{
+		if (effect == PostEffect::fxaa)
+			return fxaa_code(fxaa_quality_preset);
+
+		if (effect == PostEffect::upscale_sharpen)
+		{
+			// AMD FidelityFX CAS reduced to the cross of neighbors: the sharpening fades where the local contrast is
+			// already high, which avoids ringing. The taps are one input texel apart and filtered bilinearly.
+			return "    vec3 center = texture(screenTexture, TexCoords).rgb;\n"
+				   "    vec3 north = texture(screenTexture, TexCoords + vec2(0.0, texelSize.y)).rgb;\n"
+				   "    vec3 south = texture(screenTexture, TexCoords - vec2(0.0, texelSize.y)).rgb;\n"
+				   "    vec3 east = texture(screenTexture, TexCoords + vec2(texelSize.x, 0.0)).rgb;\n"
+				   "    vec3 west = texture(screenTexture, TexCoords - vec2(texelSize.x, 0.0)).rgb;\n"
+				   "    vec3 low = min(center, min(min(north, south), min(east, west)));\n"
+				   "    vec3 high = max(center, max(max(north, south), max(east, west)));\n"
+				   "    vec3 amount = sqrt(clamp(min(low, 2.0 - high) / max(high, 1e-4), 0.0, 1.0));\n"
+				   "    vec3 weight = -amount / mix(8.0, 5.0, sharpness);\n"
+				   "    vec3 color = max((center + weight * (north + south + east + west)) / (1.0 + 4.0 * weight), 0.0);\n";
+		}
+
+		std::string weights;
+		switch (effect)
+		{
+		case PostEffect::sharpen:
+			weights = "-1.0, -1.0, -1.0, -1.0, 9.0, -1.0, -1.0, -1.0, -1.0";
+			break;
+		case PostEffect::blur:
+			weights = "1.0 / 16, 2.0 / 16, 1.0 / 16, 2.0 / 16, 4.0 / 16, 2.0 / 16, 1.0 / 16, 2.0 / 16, 1.0 / 16";
+			break;
+		default:
+			weights = "1.0, 1.0, 1.0, 1.0, -8.0, 1.0, 1.0, 1.0, 1.0";
+			break;
+		}
+		return "    float kernel[9] = float[](" + weights +
+			   ");\n"
+			   "    vec3 color = vec3(0.0);\n"
+			   "    for (int i = 0; i < 9; i++)\n"
+			   "        color += kernel[i] * texture(screenTexture, TexCoords + vec2(i % 3 - 1, i / 3 - 1) * texelSize).rgb;\n";
+	}
+
+	// The quality path of Timothy Lottes' FXAA 3.11, on the luma of the input: pixels whose neighborhood has enough
+	// contrast find the direction of their edge, search along it for both of its ends with the steps of the preset, and
+	// take a bilinear sample shifted across the edge by their distance to the nearer end. Best run on the tonemapped
+	// image, as the last pass.
+	static std::string
+	fxaa_code(int preset)
+	{
+		const std::vector<float> steps = fxaa_search_steps(preset);
+		std::string step_list;
+		for (size_t i = 0; i < steps.size(); ++i)
+			step_list += (i == 0 ? "" : ", ") + std::to_string(steps[i]);
+
+		return "#define FXAA_STEP_COUNT " + std::to_string(steps.size()) +
+			   "\n"
+			   "    const float fxaaSteps[FXAA_STEP_COUNT] = float[](" +
+			   step_list + ");\n" + R"(#define FXAA_LUMA(p) dot(textureLod(screenTexture, p, 0.0).rgb, luma)
+    vec2 posM = TexCoords;
+    vec3 colorM = textureLod(screenTexture, posM, 0.0).rgb;
+    float lumaM = dot(colorM, luma);
+    float lumaS = FXAA_LUMA(posM + vec2(0.0, texelSize.y));
+    float lumaE = FXAA_LUMA(posM + vec2(texelSize.x, 0.0));
+    float lumaN = FXAA_LUMA(posM - vec2(0.0, texelSize.y));
+    float lumaW = FXAA_LUMA(posM - vec2(texelSize.x, 0.0));
+
+    // local contrast test, flat areas keep their color
+    float rangeMax = max(max(max(lumaN, lumaW), max(lumaS, lumaE)), lumaM);
+    float rangeMin = min(min(min(lumaN, lumaW), min(lumaS, lumaE)), lumaM);
+    float range = rangeMax - rangeMin;
+    vec3 color = colorM;
+    if (range >= max(fxaaEdgeThresholdMin, rangeMax * fxaaEdgeThreshold)) {
+        float lumaNW = FXAA_LUMA(posM - texelSize);
+        float lumaSE = FXAA_LUMA(posM + texelSize);
+        float lumaNE = FXAA_LUMA(posM + vec2(texelSize.x, -texelSize.y));
+        float lumaSW = FXAA_LUMA(posM + vec2(-texelSize.x, texelSize.y));
+
+        // horizontal or vertical edge, from the second derivatives of the 3x3 neighborhood
+        float lumaNS = lumaN + lumaS;
+        float lumaWE = lumaW + lumaE;
+        float lumaNESE = lumaNE + lumaSE;
+        float lumaNWNE = lumaNW + lumaNE;
+        float lumaNWSW = lumaNW + lumaSW;
+        float lumaSWSE = lumaSW + lumaSE;
+        float edgeHorz = abs(-2.0 * lumaW + lumaNWSW) + abs(-2.0 * lumaM + lumaNS) * 2.0 + abs(-2.0 * lumaE + lumaNESE);
+        float edgeVert = abs(-2.0 * lumaS + lumaSWSE) + abs(-2.0 * lumaM + lumaWE) * 2.0 + abs(-2.0 * lumaN + lumaNWNE);
+        bool horzSpan = edgeHorz >= edgeVert;
+
+        // sub-pixel aliasing amount, from the difference to the average of the neighbors
+        float subpixA = (lumaNS + lumaWE) * 2.0 + lumaNWSW + lumaNESE;
+        float subpixC = clamp(abs(subpixA * (1.0 / 12.0) - lumaM) / range, 0.0, 1.0);
+        float subpixF = (-2.0 * subpixC + 3.0) * subpixC * subpixC;
+
+        // the side of the edge with the larger gradient
+        if (!horzSpan) {
+            lumaN = lumaW;
+            lumaS = lumaE;
+        }
+        float lengthSign = horzSpan ? texelSize.y : texelSize.x;
+        float gradientN = lumaN - lumaM;
+        float gradientS = lumaS - lumaM;
+        bool pairN = abs(gradientN) >= abs(gradientS);
+        float gradientScaled = max(abs(gradientN), abs(gradientS)) * 0.25;
+        float lumaNN = (pairN ? lumaN : lumaS) + lumaM;
+        if (pairN)
+            lengthSign = -lengthSign;
+        bool lumaMLTZero = lumaM - lumaNN * 0.5 < 0.0;
+
+        // walk along the edge, halfway between the two rows, until the luma leaves the edge on both sides
+        vec2 posB = posM;
+        vec2 offNP = horzSpan ? vec2(texelSize.x, 0.0) : vec2(0.0, texelSize.y);
+        if (horzSpan)
+            posB.y += lengthSign * 0.5;
+        else
+            posB.x += lengthSign * 0.5;
+        vec2 posN = posB - offNP * fxaaSteps[0];
+        vec2 posP = posB + offNP * fxaaSteps[0];
+        float lumaEndN = FXAA_LUMA(posN) - lumaNN * 0.5;
+        float lumaEndP = FXAA_LUMA(posP) - lumaNN * 0.5;
+        bool doneN = abs(lumaEndN) >= gradientScaled;
+        bool doneP = abs(lumaEndP) >= gradientScaled;
+        for (int i = 1; i < FXAA_STEP_COUNT && !(doneN && doneP); i++) {
+            if (!doneN)
+                posN -= offNP * fxaaSteps[i];
+            if (!doneP)
+                posP += offNP * fxaaSteps[i];
+            if (!doneN) {
+                lumaEndN = FXAA_LUMA(posN) - lumaNN * 0.5;
+                doneN = abs(lumaEndN) >= gradientScaled;
+            }
+            if (!doneP) {
+                lumaEndP = FXAA_LUMA(posP) - lumaNN * 0.5;
+                doneP = abs(lumaEndP) >= gradientScaled;
+            }
+        }
+
+        // shift toward the nearer end of the edge, if the luma there confirms the edge
+        float dstN = horzSpan ? posM.x - posN.x : posM.y - posN.y;
+        float dstP = horzSpan ? posP.x - posM.x : posP.y - posM.y;
+        bool directionN = dstN < dstP;
+        bool goodSpan = directionN ? (lumaEndN < 0.0) != lumaMLTZero : (lumaEndP < 0.0) != lumaMLTZero;
+        float pixelOffset = goodSpan ? min(dstN, dstP) * (-1.0 / (dstN + dstP)) + 0.5 : 0.0;
+        float pixelOffsetSubpix = max(pixelOffset, subpixF * subpixF * fxaaSubpix);
+        if (horzSpan)
+            posM.y += pixelOffsetSubpix * lengthSign;
+        else
+            posM.x += pixelOffsetSubpix * lengthSign;
+        color = textureLod(screenTexture, posM, 0.0).rgb;
+    }
+)";
+	}
+
+	static std::string
+	pixel_code(PostEffect effect)
+	{
+		switch (effect)
+		{
+		case PostEffect::invert:
+			return "    color = 1.0 - color;\n";
+		case PostEffect::grayscale:
+			return "    color = vec3(dot(color, luma));\n";
+		case PostEffect::color_grading:
+			return "    color = mix(vec3(dot(color, luma)), color, saturation) * tint;\n"
+				   "    color = max((color - 0.5) * contrast + 0.5, 0.0);\n";
+		case PostEffect::tonemap:
+			// ACES filmic curve fitted by Krzysztof Narkowicz
+			return "    color *= exposure;\n"
+				   "    color = clamp((color * (2.51 * color + 0.03)) / (color * (2.43 * color + 0.59) + 0.14), 0.0, 1.0);\n";
+		case PostEffect::vignette:
+			return "    color *= 1.0 - vignetteStrength * smoothstep(vignetteRadius, 0.7071, length(TexCoords - 0.5));\n";
+		default:
+			return "";
+		}
+	}
+};
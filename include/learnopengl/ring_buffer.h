@@ -0,0 +1,131 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+// A buffer mapped once for its whole lifetime and split in frame_count regions, one per frame in flight. Every frame
+// suballocates linearly from its region and writes straight into the mapping, with no map, unmap or upload call per
+// allocation. The mapping is coherent, so data written before a draw call is issued is what that draw reads.
+// A fence placed at the end of a frame guards its region: when the ring comes back to it three frames later,
+// begin_frame() waits for the GPU to be done with it before handing it out again, which it normally already is.
+// Needs glBufferStorage, OpenGL 4.4; see is_supported().
+class PersistentRingBuffer
+{
+public:
+	static constexpr unsigned int frame_count = 3;
+
+	static bool
+	is_supported()
+	{
+		return GLAD_GL_VERSION_4_4 != 0;
+	}
+
+	// frame_size bytes per frame, the buffer holds frame_count times as much
+	explicit PersistentRingBuffer(size_t frame_size) : frame_size(frame_size)
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glBufferStorage(GL_ARRAY_BUFFER, GLsizeiptr(frame_size * frame_count), nullptr, flags);
+		mapping = static_cast<uint8_t*>(
+			glMapBufferRange(GL_ARRAY_BUFFER, 0, GLsizeiptr(frame_size * frame_count), flags));
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	PersistentRingBuffer(const PersistentRingBuffer&) = delete;
+	PersistentRingBuffer&
+	operator=(const PersistentRingBuffer&) = delete;
+
+	~PersistentRingBuffer()
+	{
+		for (GLsync& fence : fences)
+		{
+			if (fence)
+				glDeleteSync(fence);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glDeleteBuffers(1, &buffer);
+	}
+
+	// moves on to the next region, waiting for the GPU to release it if needed
+	void
+	begin_frame()
+	{
+		region = (region + 1) % frame_count;
+		offset = 0;
+		GLsync& fence = fences[region];
+		if (!fence)
+			return;
+		if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+		{
+			++stall_count;
+			// the GPU is three frames behind, flush so the fence is sure to be signaled eventually
+			GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+			while (glClientWaitSync(fence, flags, 1000000) == GL_TIMEOUT_EXPIRED)
+				flags = 0;
+		}
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	// after the last draw call reading this frame's region
+	void
+	end_frame()
+	{
+		fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	// size bytes of this frame's region at an offset from the start of the buffer that is a multiple of alignment,
+	// see get_offset(). nullptr when the region is full
+	void*
+	allocate(size_t size, size_t alignment = 16)
+	{
+		const size_t region_start = region * frame_size;
+		const size_t aligned = (region_start + offset + alignment - 1) / alignment * alignment;
+		if (!mapping || aligned + size > region_start + frame_size)
+			return nullptr;
+		offset = aligned + size - region_start;
+		last_offset = aligned;
+		return mapping + aligned;
+	}
+
+	// offset of the last allocation from the start of the buffer, for attribute pointers, base instances or ranges
+	size_t
+	get_offset() const
+	{
+		return last_offset;
+	}
+
+	GLuint
+	get_buffer() const
+	{
+		return buffer;
+	}
+
+	// bytes allocated from this frame's region so far
+	size_t
+	get_used() const
+	{
+		return offset;
+	}
+
+	// frames that had to wait for the GPU
+	unsigned int
+	get_stall_count() const
+	{
+		return stall_count;
+	}
+
+private:
+	GLuint buffer = 0;
+	uint8_t* mapping = nullptr;
+	size_t frame_size;
+	GLsync fences[frame_count] = {};
+	unsigned int region = frame_count - 1;
+	size_t offset = 0;
+	size_t last_offset = 0;
+	unsigned int stall_count = 0;
+};
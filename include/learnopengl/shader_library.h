@@ -0,0 +1,347 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include <learnopengl/shader.h>
+#include <learnopengl/shader_manager.h>
+
+// Features a variant of a shader is compiled with, injected as #define NAME VALUE right after the #version line. An
+// empty value gives a plain #define NAME. Kept sorted, so the same set always gives the same permutation key.
+using ShaderDefines = std::map<std::string, std::string>;
+
+// Resolves #include "file" (or <file>) in GLSL sources and injects a set of defines. A file is searched next to the
+// file including it first, then in the include directories in the order they were added. Every file is included once
+// per stage, like with #pragma once, which also ends include cycles.
+// Each file of a stage is a GLSL source string number of its own, set with #line, so the compiler reports errors as
+// source(line) of the original files; Source::files maps the numbers back to the paths.
+class ShaderPreprocessor
+{
+public:
+	struct Source
+	{
+		std::string code;
+		// the path of source string number i
+		std::vector<std::string> files;
+	};
+
+	void
+	add_include_directory(const std::string& directory)
+	{
+		include_directories.push_back(directory);
+	}
+
+	Source
+	process(const std::string& path, const ShaderDefines& defines = {})
+	{
+		Source source;
+		std::string text;
+		if (!read(path, text))
+		{
+			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path << std::endl;
+			return source;
+		}
+		source.files.push_back(path);
+
+		// the defines go right after #version, which has to come first
+		std::istringstream lines(text);
+		std::string line;
+		int line_number = 0;
+		std::ostringstream out;
+		bool injected = false;
+		while (!injected && std::getline(lines, line))
+		{
+			++line_number;
+			out << line << '\n';
+			injected = directive(line) == "version";
+		}
+		if (!injected)
+		{
+			out.str("");
+			lines.clear();
+			lines.str(text);
+			line_number = 0;
+		}
+		for (const auto& define : defines)
+			out << "#define " << define.first << (define.second.empty() ? "" : " ") << define.second << '\n';
+		out << "#line " << line_number + 1 << " 0\n";
+
+		expand(lines, path, 0, line_number, out, source);
+		source.code = out.str();
+		return source;
+	}
+
+	// files are read once, call after editing them on disk
+	void
+	clear_file_cache()
+	{
+		file_cache.clear();
+	}
+
+private:
+	std::vector<std::string> include_directories;
+	std::unordered_map<std::string, std::string> file_cache;
+
+	bool
+	read(const std::string& path, std::string& text)
+	{
+		const auto cached = file_cache.find(path);
+		if (cached != file_cache.end())
+		{
+			text = cached->second;
+			return true;
+		}
+		std::ifstream file(path);
+		if (!file)
+			return false;
+		std::stringstream stream;
+		stream << file.rdbuf();
+		text = stream.str();
+		file_cache.emplace(path, text);
+		return true;
+	}
+
+	// name of the preprocessor directive of a line, empty if there is none
+	static std::string
+	directive(const std::string& line)
+	{
+		size_t begin = line.find_first_not_of(" \t");
+		if (begin == std::string::npos || line[begin] != '#')
+			return "";
+		begin = line.find_first_not_of(" \t", begin + 1);
+		if (begin == std::string::npos)
+			return "";
+		size_t end = begin;
+		while (end < line.size() && (std::isalnum(static_cast<unsigned char>(line[end])) || line[end] == '_'))
+			++end;
+		return line.substr(begin, end - begin);
+	}
+
+	static std::string
+	directory_of(const std::string& path)
+	{
+		const size_t slash = path.find_last_of("/\\");
+		return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+	}
+
+	// copies the remaining lines of a file to out, with its includes expanded in place
+	void
+	expand(
+		std::istream& lines,
+		const std::string& path,
+		int source_number,
+		int line_number,
+		std::ostringstream& out,
+		Source& source)
+	{
+		std::string line;
+		while (std::getline(lines, line))
+		{
+			++line_number;
+			if (directive(line) != "include")
+			{
+				out << line << '\n';
+				continue;
+			}
+
+			const size_t open = line.find_first_of("\"<");
+			const size_t close = open == std::string::npos ? open : line.find_first_of("\">", open + 1);
+			if (close == std::string::npos)
+			{
+				std::cout << "ERROR::SHADER::MALFORMED_INCLUDE: " << path << "(" << line_number << ")" << std::endl;
+				out << '\n';
+				continue;
+			}
+			const std::string name = line.substr(open + 1, close - open - 1);
+
+			std::string include_path, text;
+			bool found = false;
+			for (size_t i = 0; i <= include_directories.size() && !found; ++i)
+			{
+				include_path = (i == 0 ? directory_of(path) : include_directories[i - 1] + "/") + name;
+				found = std::find(source.files.begin(), source.files.end(), include_path) != source.files.end() ||
+						read(include_path, text);
+			}
+			if (!found)
+			{
+				std::cout << "ERROR::SHADER::INCLUDE_NOT_FOUND: " << name << " in " << path << "(" << line_number
+						  << ")" << std::endl;
+				out << '\n';
+				continue;
+			}
+			// already part of this stage
+			if (std::find(source.files.begin(), source.files.end(), include_path) != source.files.end())
+			{
+				out << '\n';
+				continue;
+			}
+
+			const int include_number = int(source.files.size());
+			source.files.push_back(include_path);
+			out << "#line 1 " << include_number << '\n';
+			std::istringstream include_lines(text);
+			expand(include_lines, include_path, include_number, 0, out, source);
+			out << "#line " << line_number + 1 << ' ' << source_number << '\n';
+		}
+	}
+};
+
+// Compiles every permutation of a shader once. A permutation is the shader files plus a set of defines; asking for the
+// same one again returns the program already built, and so does asking for one whose preprocessed sources turn out
+// identical to an existing one, e.g. because a define is not used by these files. A material thus only pays for the
+// features it uses, without runtime branches in the shader or a copy of the file per feature set.
+// Programs are built by a ShaderManager: precompile() submits the variants a demo will need up front so the driver
+// can build them in parallel, get() returns them checked and ready on first use.
+class ShaderLibrary
+{
+public:
+	using Handle = ShaderManager::Handle;
+
+	explicit ShaderLibrary(GLADloadproc get_proc_address) : manager(get_proc_address)
+	{
+	}
+
+	void
+	add_include_directory(const std::string& directory)
+	{
+		preprocessor.add_include_directory(directory);
+	}
+
+	// identifies a permutation: its files and its sorted defines
+	static std::string
+	permutation_key(
+		const std::string& vertex_path,
+		const std::string& fragment_path,
+		const ShaderDefines& defines,
+		const std::string& geometry_path = "")
+	{
+		std::string key = vertex_path + "|" + fragment_path + "|" + geometry_path + "|";
+		for (const auto& define : defines)
+			key += define.first + "=" + define.second + ";";
+		return key;
+	}
+
+	// submits the permutation without waiting for it, unless it was already
+	Handle
+	precompile(
+		const std::string& vertex_path,
+		const std::string& fragment_path,
+		const ShaderDefines& defines = {},
+		const std::string& geometry_path = "")
+	{
+		const std::string key = permutation_key(vertex_path, fragment_path, defines, geometry_path);
+		const auto variant = variants.find(key);
+		if (variant != variants.end())
+			return variant->second;
+
+		const ShaderPreprocessor::Source vertex = preprocessor.process(vertex_path, defines);
+		const ShaderPreprocessor::Source fragment = preprocessor.process(fragment_path, defines);
+		const ShaderPreprocessor::Source geometry =
+			geometry_path.empty() ? ShaderPreprocessor::Source{} : preprocessor.process(geometry_path, defines);
+
+		// the stages are separated by a character that cannot appear in GLSL
+		const std::string code = vertex.code + '\0' + fragment.code + '\0' + geometry.code;
+		const auto same_code = programs.find(code);
+		Handle handle;
+		if (same_code != programs.end())
+			handle = same_code->second;
+		else
+		{
+			handle = manager.submit_source(describe(key, vertex, fragment, geometry), vertex.code, fragment.code,
+										   geometry.code);
+			programs.emplace(code, handle);
+		}
+		variants.emplace(key, handle);
+		return handle;
+	}
+
+	// submits every set of defines of the list, e.g. all the materials of a scene
+	void
+	precompile_all(
+		const std::string& vertex_path,
+		const std::string& fragment_path,
+		const std::vector<ShaderDefines>& permutations,
+		const std::string& geometry_path = "")
+	{
+		for (const ShaderDefines& defines : permutations)
+			precompile(vertex_path, fragment_path, defines, geometry_path);
+	}
+
+	Shader&
+	get(const std::string& vertex_path,
+		const std::string& fragment_path,
+		const ShaderDefines& defines = {},
+		const std::string& geometry_path = "")
+	{
+		return manager.get(precompile(vertex_path, fragment_path, defines, geometry_path));
+	}
+
+	Shader&
+	get(Handle handle)
+	{
+		return manager.get(handle);
+	}
+
+	// permutations asked for, and programs actually built for them
+	size_t
+	get_permutation_count() const
+	{
+		return variants.size();
+	}
+
+	size_t
+	get_program_count() const
+	{
+		return programs.size();
+	}
+
+	ShaderManager&
+	get_manager()
+	{
+		return manager;
+	}
+
+	// files are read once, call after editing them on disk; programs already built are kept
+	void
+	clear_file_cache()
+	{
+		preprocessor.clear_file_cache();
+	}
+
+private:
+	ShaderManager manager;
+	ShaderPreprocessor preprocessor;
+	// permutation key to program, and preprocessed sources to program
+	std::unordered_map<std::string, Handle> variants;
+	std::unordered_map<std::string, Handle> programs;
+
+	// name of the program in the error messages, with the files behind the source string numbers of the log
+	static std::string
+	describe(
+		const std::string& key,
+		const ShaderPreprocessor::Source& vertex,
+		const ShaderPreprocessor::Source& fragment,
+		const ShaderPreprocessor::Source& geometry)
+	{
+		std::string name = key;
+		const std::pair<const char*, const ShaderPreprocessor::Source*> stages[] = {
+			{"vertex", &vertex}, {"fragment", &fragment}, {"geometry", &geometry}};
+		for (const auto& stage : stages)
+		{
+			if (stage.second->files.size() < 2)
+				continue;
+			name += std::string("\n  ") + stage.first + " sources:";
+			for (size_t i = 0; i < stage.second->files.size(); ++i)
+				name += " " + std::to_string(i) + " " + stage.second->files[i];
+		}
+		return name;
+	}
+};
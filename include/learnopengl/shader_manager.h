@@ -0,0 +1,219 @@
+#pragma once
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include <learnopengl/shader.h>
+
+// GL_KHR_parallel_shader_compile (and its ARB twin, same tokens) is not part of the generated loader of this tree
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+typedef void(APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+// Builds many programs without waiting for each one. submit() hands the sources of a program to the driver and
+// returns at once: nothing asks for a compile or link status, the query that would make the driver finish the program
+// before returning. With GL_KHR_parallel_shader_compile the driver compiles on its own threads, is_ready() polls a
+// program without blocking and get_pending_count() lets a loading screen wait for all of them. The status and the
+// logs are checked when get() first hands a program out, so a program that is never used never costs a stall.
+class ShaderManager
+{
+public:
+	using Handle = size_t;
+
+	// needs a current context; get_proc_address loads the extension's entry point, e.g. glfwGetProcAddress
+	explicit ShaderManager(GLADloadproc get_proc_address)
+	{
+		GLint extension_count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+		for (GLint i = 0; i < extension_count; ++i)
+		{
+			const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, GLuint(i)));
+			if (std::strcmp(name, "GL_KHR_parallel_shader_compile") == 0)
+				max_compiler_threads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(
+					get_proc_address("glMaxShaderCompilerThreadsKHR"));
+			else if (std::strcmp(name, "GL_ARB_parallel_shader_compile") == 0 && !max_compiler_threads)
+				max_compiler_threads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(
+					get_proc_address("glMaxShaderCompilerThreadsARB"));
+		}
+		// as many threads as the driver sees fit
+		if (max_compiler_threads)
+			max_compiler_threads(0xFFFFFFFFu);
+	}
+
+	ShaderManager(const ShaderManager&) = delete;
+	ShaderManager&
+	operator=(const ShaderManager&) = delete;
+
+	~ShaderManager()
+	{
+		for (Program& program : programs)
+		{
+			delete_stages(program);
+			glDeleteProgram(program.shader.ID);
+		}
+	}
+
+	// true if the driver compiles in the background; without it the first status query of a program blocks
+	bool
+	is_parallel() const
+	{
+		return max_compiler_threads != nullptr;
+	}
+
+	Handle
+	submit(const char* vertex_path, const char* fragment_path, const char* geometry_path = nullptr)
+	{
+		const std::string name = std::string(vertex_path) + " + " + fragment_path;
+		return submit_source(
+			name, read_file(vertex_path), read_file(fragment_path), geometry_path ? read_file(geometry_path) : "");
+	}
+
+	// name identifies the program in the error messages
+	Handle
+	submit_source(
+		const std::string& name,
+		const std::string& vertex_code,
+		const std::string& fragment_code,
+		const std::string& geometry_code = "")
+	{
+		Program program{Shader::fromProgram(glCreateProgram()), name};
+		program.stages.push_back(compile_stage(GL_VERTEX_SHADER, vertex_code));
+		program.stages.push_back(compile_stage(GL_FRAGMENT_SHADER, fragment_code));
+		if (!geometry_code.empty())
+			program.stages.push_back(compile_stage(GL_GEOMETRY_SHADER, geometry_code));
+		// linking right after compiling is fine, the driver waits for the stages itself
+		for (GLuint stage : program.stages)
+			glAttachShader(program.shader.ID, stage);
+		glLinkProgram(program.shader.ID);
+		programs.push_back(std::move(program));
+		return programs.size() - 1;
+	}
+
+	// false while the driver is still compiling or linking; never blocks
+	bool
+	is_ready(Handle handle) const
+	{
+		const Program& program = programs[handle];
+		if (program.checked || !max_compiler_threads)
+			return true;
+		GLint complete = GL_FALSE;
+		glGetProgramiv(program.shader.ID, GL_COMPLETION_STATUS_KHR, &complete);
+		return complete == GL_TRUE;
+	}
+
+	// programs the driver has not finished, always 0 without the extension as it cannot be asked without blocking
+	size_t
+	get_pending_count() const
+	{
+		size_t pending = 0;
+		for (Handle handle = 0; handle < programs.size(); ++handle)
+			pending += is_ready(handle) ? 0 : 1;
+		return pending;
+	}
+
+	// the program, checked and ready to use; the first call waits for the driver if it has not finished yet
+	Shader&
+	get(Handle handle)
+	{
+		Program& program = programs[handle];
+		if (!program.checked)
+			check(program);
+		return program.shader;
+	}
+
+	// false if the program failed to compile or link, checks it like get()
+	bool
+	is_valid(Handle handle)
+	{
+		get(handle);
+		return programs[handle].valid;
+	}
+
+private:
+	struct Program
+	{
+		Shader shader;
+		std::string name;
+		std::vector<GLuint> stages;
+		bool checked = false;
+		bool valid = false;
+	};
+
+	// a deque, so the Shader references handed out stay valid while more programs are submitted
+	std::deque<Program> programs;
+	PFNGLMAXSHADERCOMPILERTHREADSKHRPROC max_compiler_threads = nullptr;
+
+	static std::string
+	read_file(const char* path)
+	{
+		std::ifstream file(path);
+		if (!file)
+		{
+			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path << std::endl;
+			return "";
+		}
+		std::stringstream stream;
+		stream << file.rdbuf();
+		return stream.str();
+	}
+
+	static GLuint
+	compile_stage(GLenum type, const std::string& code)
+	{
+		const GLuint stage = glCreateShader(type);
+		const char* source = code.c_str();
+		glShaderSource(stage, 1, &source, NULL);
+		glCompileShader(stage);
+		return stage;
+	}
+
+	// the stages are kept until the program is checked, their logs explain a failed link
+	void
+	check(Program& program)
+	{
+		GLchar info_log[1024];
+		program.valid = true;
+		for (GLuint stage : program.stages)
+		{
+			GLint success = GL_FALSE;
+			glGetShaderiv(stage, GL_COMPILE_STATUS, &success);
+			if (!success)
+			{
+				glGetShaderInfoLog(stage, sizeof(info_log), NULL, info_log);
+				std::cout << "ERROR::SHADER_COMPILATION_ERROR in " << program.name << "\n"
+						  << info_log << "\n -- --------------------------------------------------- -- " << std::endl;
+				program.valid = false;
+			}
+		}
+		GLint success = GL_FALSE;
+		glGetProgramiv(program.shader.ID, GL_LINK_STATUS, &success);
+		if (!success)
+		{
+			glGetProgramInfoLog(program.shader.ID, sizeof(info_log), NULL, info_log);
+			std::cout << "ERROR::PROGRAM_LINKING_ERROR in " << program.name << "\n"
+					  << info_log << "\n -- --------------------------------------------------- -- " << std::endl;
+			program.valid = false;
+		}
+		delete_stages(program);
+		program.checked = true;
+	}
+
+	static void
+	delete_stages(Program& program)
+	{
+		for (GLuint stage : program.stages)
+		{
+			glDetachShader(program.shader.ID, stage);
+			glDeleteShader(stage);
+		}
+		program.stages.clear();
+	}
+};
@@ -0,0 +1,594 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <learnopengl/bounding_volume.h>
+#include <learnopengl/entity.h>
+
+// Dynamic bounding volume hierarchy in the style of Box2D's b2DynamicTree. Leaves store enlarged ("fat") boxes so
+// objects moving a little do not touch the tree, inserts pick the sibling with the lowest surface area cost and
+// rotations keep the tree balanced. Queries visit O(log n + k) nodes.
+template<typename T>
+class DynamicAABBTree
+{
+public:
+	static constexpr int null_node = -1;
+
+	// enlargement of leaf boxes on every side
+	float margin = 0.1f;
+
+	// returns the proxy id of the new leaf
+	int
+	create_proxy(const AABB& box, T* user_data)
+	{
+		const int proxy = allocate_node();
+		nodes[proxy].box.center = box.center;
+		nodes[proxy].box.extents = box.extents + glm::vec3(margin);
+		nodes[proxy].user_data = user_data;
+		nodes[proxy].height = 0;
+		insert_leaf(proxy);
+		++proxy_count;
+		return proxy;
+	}
+
+	void
+	destroy_proxy(int proxy)
+	{
+		assert(nodes[proxy].is_leaf());
+		remove_leaf(proxy);
+		free_node(proxy);
+		--proxy_count;
+	}
+
+	// returns true when the box left the fat box of the proxy and the leaf was reinserted
+	bool
+	move_proxy(int proxy, const AABB& box)
+	{
+		assert(nodes[proxy].is_leaf());
+		if (contains(nodes[proxy].box, box))
+			return false;
+
+		remove_leaf(proxy);
+		nodes[proxy].box.center = box.center;
+		nodes[proxy].box.extents = box.extents + glm::vec3(margin);
+		insert_leaf(proxy);
+		return true;
+	}
+
+	T*
+	get_user_data(int proxy) const
+	{
+		return nodes[proxy].user_data;
+	}
+
+	const AABB&
+	get_fat_aabb(int proxy) const
+	{
+		return nodes[proxy].box;
+	}
+
+	size_t
+	get_proxy_count() const
+	{
+		return proxy_count;
+	}
+
+	int
+	get_height() const
+	{
+		return root == null_node ? 0 : nodes[root].height;
+	}
+
+	// callback(T*) is called for every proxy whose fat box overlaps the box, returning false stops the query
+	template<typename Callback>
+	void
+	query(const AABB& box, Callback&& callback) const
+	{
+		traverse([&box](const AABB& node_box) { return overlaps(node_box, box); }, callback);
+	}
+
+	// proxies whose fat box overlaps the sphere
+	template<typename Callback>
+	void
+	query(const glm::vec3& center, float radius, Callback&& callback) const
+	{
+		traverse(
+			[&center, radius](const AABB& node_box) {
+				// distance from the center to the closest point of the box
+				const glm::vec3 d = glm::max(glm::abs(center - node_box.center) - node_box.extents, glm::vec3(0.0f));
+				return glm::dot(d, d) <= radius * radius;
+			},
+			callback);
+	}
+
+	// proxies whose fat box is on or inside the frustum
+	template<typename Callback>
+	void
+	query(const Frustum& frustum, Callback&& callback) const
+	{
+		traverse([&frustum](const AABB& node_box) { return node_box.is_on_frustum(frustum); }, callback);
+	}
+
+	// callback(T*, float distance) is called for the proxies whose fat box the ray enters before max_distance, with
+	// the distance at which it does, roughly front to back. The callback returns the new max distance: the distance
+	// of an exact hit to clip the ray, max_distance to continue unchanged, 0 to stop.
+	template<typename Callback>
+	void
+	ray_cast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, Callback&& callback) const
+	{
+		const glm::vec3 inv_direction = 1.0f / direction;
+		Stack stack;
+		if (root != null_node)
+			stack.push(root);
+
+		while (!stack.empty())
+		{
+			const Node& node = nodes[stack.pop()];
+			float distance;
+			if (!node.box.intersects_ray(origin, inv_direction, max_distance, distance))
+				continue;
+
+			if (node.is_leaf())
+			{
+				max_distance = callback(node.user_data, distance);
+				if (max_distance <= 0.0f)
+					return;
+				continue;
+			}
+
+			// nearest child on top, its hits clip the ray before the other child is tested
+			float distance1, distance2;
+			const bool hit1 = nodes[node.child1].box.intersects_ray(origin, inv_direction, max_distance, distance1);
+			const bool hit2 = nodes[node.child2].box.intersects_ray(origin, inv_direction, max_distance, distance2);
+			if (hit1 && hit2)
+			{
+				stack.push(distance1 < distance2 ? node.child2 : node.child1);
+				stack.push(distance1 < distance2 ? node.child1 : node.child2);
+			}
+			else if (hit1)
+				stack.push(node.child1);
+			else if (hit2)
+				stack.push(node.child2);
+		}
+	}
+
+private:
+	struct Node
+	{
+		AABB box;
+		T* user_data = nullptr;
+
+		// parent in the tree, next free node in the free list
+		int parent_or_next = null_node;
+		int child1 = null_node;
+		int child2 = null_node;
+
+		// leaf = 0, free node = -1
+		int height = -1;
+
+		bool
+		is_leaf() const
+		{
+			return child1 == null_node;
+		}
+	};
+
+	// traversal stack living on the program stack as long as the tree is not degenerate
+	class Stack
+	{
+	public:
+		void
+		push(int node)
+		{
+			if (count == fixed_capacity)
+			{
+				overflow.push_back(node);
+				return;
+			}
+			fixed[count++] = node;
+		}
+
+		int
+		pop()
+		{
+			if (!overflow.empty())
+			{
+				const int node = overflow.back();
+				overflow.pop_back();
+				return node;
+			}
+			return fixed[--count];
+		}
+
+		bool
+		empty() const
+		{
+			return count == 0 && overflow.empty();
+		}
+
+	private:
+		static constexpr int fixed_capacity = 256;
+		int fixed[fixed_capacity];
+		int count = 0;
+		std::vector<int> overflow;
+	};
+
+	std::vector<Node> nodes;
+	int root = null_node;
+	int free_list = null_node;
+	size_t proxy_count = 0;
+
+	static AABB
+	combine(const AABB& a, const AABB& b)
+	{
+		return AABB(glm::min(a.get_min(), b.get_min()), glm::max(a.get_max(), b.get_max()));
+	}
+
+	static float
+	surface_area(const AABB& box)
+	{
+		const glm::vec3& e = box.extents;
+		return 8.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+	}
+
+	static bool
+	contains(const AABB& outer, const AABB& inner)
+	{
+		const glm::vec3 d = glm::abs(inner.center - outer.center) + inner.extents;
+		return d.x <= outer.extents.x && d.y <= outer.extents.y && d.z <= outer.extents.z;
+	}
+
+	static bool
+	overlaps(const AABB& a, const AABB& b)
+	{
+		const glm::vec3 d = glm::abs(a.center - b.center);
+		const glm::vec3 e = a.extents + b.extents;
+		return d.x <= e.x && d.y <= e.y && d.z <= e.z;
+	}
+
+	template<typename Test, typename Callback>
+	void
+	traverse(Test&& test, Callback&& callback) const
+	{
+		Stack stack;
+		if (root != null_node)
+			stack.push(root);
+
+		while (!stack.empty())
+		{
+			const Node& node = nodes[stack.pop()];
+			if (!test(node.box))
+				continue;
+
+			if (node.is_leaf())
+			{
+				if (!callback(node.user_data))
+					return;
+			}
+			else
+			{
+				stack.push(node.child1);
+				stack.push(node.child2);
+			}
+		}
+	}
+
+	int
+	allocate_node()
+	{
+		if (free_list == null_node)
+		{
+			nodes.emplace_back();
+			return static_cast<int>(nodes.size()) - 1;
+		}
+		const int node = free_list;
+		free_list = nodes[node].parent_or_next;
+		nodes[node] = Node();
+		return node;
+	}
+
+	void
+	free_node(int node)
+	{
+		nodes[node].parent_or_next = free_list;
+		nodes[node].height = -1;
+		free_list = node;
+	}
+
+	void
+	insert_leaf(int leaf)
+	{
+		if (root == null_node)
+		{
+			root = leaf;
+			nodes[root].parent_or_next = null_node;
+			return;
+		}
+
+		// walk down to the sibling with the lowest cost, surface area heuristic
+		const AABB leaf_box = nodes[leaf].box;
+		int index = root;
+		while (!nodes[index].is_leaf())
+		{
+			const int child1 = nodes[index].child1;
+			const int child2 = nodes[index].child2;
+
+			const float area = surface_area(nodes[index].box);
+			const float combined_area = surface_area(combine(nodes[index].box, leaf_box));
+
+			// cost of creating a new parent for this node and the new leaf
+			const float cost = 2.0f * combined_area;
+
+			// minimum cost of pushing the leaf further down the tree
+			const float inheritance_cost = 2.0f * (combined_area - area);
+
+			const float cost1 = descend_cost(child1, leaf_box) + inheritance_cost;
+			const float cost2 = descend_cost(child2, leaf_box) + inheritance_cost;
+
+			if (cost < cost1 && cost < cost2)
+				break;
+			index = cost1 < cost2 ? child1 : child2;
+		}
+
+		const int sibling = index;
+		const int old_parent = nodes[sibling].parent_or_next;
+		const int new_parent = allocate_node();
+		nodes[new_parent].parent_or_next = old_parent;
+		nodes[new_parent].box = combine(leaf_box, nodes[sibling].box);
+		nodes[new_parent].height = nodes[sibling].height + 1;
+		nodes[new_parent].child1 = sibling;
+		nodes[new_parent].child2 = leaf;
+		nodes[sibling].parent_or_next = new_parent;
+		nodes[leaf].parent_or_next = new_parent;
+
+		if (old_parent == null_node)
+			root = new_parent;
+		else if (nodes[old_parent].child1 == sibling)
+			nodes[old_parent].child1 = new_parent;
+		else
+			nodes[old_parent].child2 = new_parent;
+
+		refit_ancestors(new_parent);
+	}
+
+	float
+	descend_cost(int child, const AABB& leaf_box) const
+	{
+		const float combined_area = surface_area(combine(leaf_box, nodes[child].box));
+		if (nodes[child].is_leaf())
+			return combined_area;
+		return combined_area - surface_area(nodes[child].box);
+	}
+
+	void
+	remove_leaf(int leaf)
+	{
+		if (leaf == root)
+		{
+			root = null_node;
+			return;
+		}
+
+		const int parent = nodes[leaf].parent_or_next;
+		const int grand_parent = nodes[parent].parent_or_next;
+		const int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+		// the sibling takes the place of the parent
+		free_node(parent);
+		if (grand_parent == null_node)
+		{
+			root = sibling;
+			nodes[sibling].parent_or_next = null_node;
+			return;
+		}
+
+		if (nodes[grand_parent].child1 == parent)
+			nodes[grand_parent].child1 = sibling;
+		else
+			nodes[grand_parent].child2 = sibling;
+		nodes[sibling].parent_or_next = grand_parent;
+		refit_ancestors(grand_parent);
+	}
+
+	// rebalance and recompute boxes and heights from index up to the root
+	void
+	refit_ancestors(int index)
+	{
+		while (index != null_node)
+		{
+			index = balance(index);
+
+			Node& node = nodes[index];
+			node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+			node.box = combine(nodes[node.child1].box, nodes[node.child2].box);
+			index = node.parent_or_next;
+		}
+	}
+
+	// rotates a child of a up when a is imbalanced, returns the index of the new subtree root
+	int
+	balance(int a)
+	{
+		if (nodes[a].is_leaf() || nodes[a].height < 2)
+			return a;
+
+		const int b = nodes[a].child1;
+		const int c = nodes[a].child2;
+		const int difference = nodes[c].height - nodes[b].height;
+
+		if (difference > 1)
+			return rotate_up(a, c, b);
+		if (difference < -1)
+			return rotate_up(a, b, c);
+		return a;
+	}
+
+	// the taller child of a takes the place of a, a keeps the other child and the shorter grand child
+	int
+	rotate_up(int a, int tall, int short_child)
+	{
+		const int f = nodes[tall].child1;
+		const int g = nodes[tall].child2;
+
+		// swap a and tall
+		const int a_parent = nodes[a].parent_or_next;
+		nodes[tall].child1 = a;
+		nodes[tall].parent_or_next = a_parent;
+		nodes[a].parent_or_next = tall;
+
+		if (a_parent == null_node)
+			root = tall;
+		else if (nodes[a_parent].child1 == a)
+			nodes[a_parent].child1 = tall;
+		else
+			nodes[a_parent].child2 = tall;
+
+		// the taller grand child stays below tall, the other one goes below a
+		const bool f_taller = nodes[f].height > nodes[g].height;
+		const int keep = f_taller ? f : g;
+		const int move = f_taller ? g : f;
+
+		nodes[tall].child2 = keep;
+		nodes[a].child1 = short_child;
+		nodes[a].child2 = move;
+		nodes[move].parent_or_next = a;
+
+		nodes[a].box = combine(nodes[short_child].box, nodes[move].box);
+		nodes[a].height = 1 + std::max(nodes[short_child].height, nodes[move].height);
+		nodes[tall].box = combine(nodes[a].box, nodes[keep].box);
+		nodes[tall].height = 1 + std::max(nodes[a].height, nodes[keep].height);
+		return tall;
+	}
+};
+
+// World space bounds of the entities of a scene graph. Entities are inserted once, then refitted after the transform
+// updates: cheap for entities staying inside their fat box, a reinsertion otherwise.
+class EntitySpatialIndex
+{
+public:
+	// inserts the entity and its subtree, their transforms must be up to date
+	void
+	insert(Entity& entity)
+	{
+		if (entity.spatial_proxy == -1)
+			entity.spatial_proxy = tree.create_proxy(entity.get_world_aabb(), &entity);
+		for (auto&& child : entity.children)
+			insert(*child);
+	}
+
+	void
+	remove(Entity& entity)
+	{
+		if (entity.spatial_proxy != -1)
+		{
+			tree.destroy_proxy(entity.spatial_proxy);
+			entity.spatial_proxy = -1;
+		}
+		for (auto&& child : entity.children)
+			remove(*child);
+	}
+
+	// refit the entity and its subtree after their world matrices changed
+	void
+	refit(Entity& entity)
+	{
+		if (entity.spatial_proxy != -1)
+			tree.move_proxy(entity.spatial_proxy, entity.get_world_aabb());
+		for (auto&& child : entity.children)
+			refit(*child);
+	}
+
+	// refit what the last update_dirty of the root recomputed, after a full update use refit(root)
+	void
+	update(const Entity& root)
+	{
+		for (Entity* entity : root.get_updated_roots())
+			refit(*entity);
+	}
+
+	// callback(Entity&) is called for every entity whose box may overlap the volume, false stops the query.
+	// Boxes are enlarged by the tree margin, test the exact bounds when it matters.
+	template<typename Volume, typename Callback>
+	void
+	query(const Volume& volume, Callback&& callback) const
+	{
+		tree.query(volume, [&callback](Entity* entity) { return callback(*entity); });
+	}
+
+	template<typename Callback>
+	void
+	query(const glm::vec3& center, float radius, Callback&& callback) const
+	{
+		tree.query(center, radius, [&callback](Entity* entity) { return callback(*entity); });
+	}
+
+	// closest entity whose world bounds the ray hits within max_distance, nullptr if none
+	Entity*
+	ray_cast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, float* hit_distance = nullptr) const
+	{
+		Entity* closest = nullptr;
+		float closest_distance = max_distance;
+		const glm::vec3 inv_direction = 1.0f / direction;
+		tree.ray_cast(origin, direction, max_distance, [&](Entity* entity, float) {
+			// the fat box was hit, test the exact one
+			float distance;
+			if (entity->get_world_aabb().intersects_ray(origin, inv_direction, closest_distance, distance))
+			{
+				closest = entity;
+				closest_distance = distance;
+			}
+			return closest_distance;
+		});
+
+		if (hit_distance && closest)
+			*hit_distance = closest_distance;
+		return closest;
+	}
+
+	// closest entity whose triangles the ray hits within max_distance, nullptr if none. The hit holds the triangle in
+	// the model of the entity and the distance along the world space ray.
+	Entity*
+	pick(const glm::vec3& origin, const glm::vec3& direction, float max_distance, RayHit* hit = nullptr) const
+	{
+		Entity* closest = nullptr;
+		RayHit closest_hit;
+		closest_hit.distance = max_distance;
+		tree.ray_cast(origin, direction, max_distance, [&](Entity* entity, float) {
+			// an affine transform keeps distances along the ray when the direction is not renormalized
+			const glm::mat4 to_local = glm::inverse(entity->transform.get_model_matrix());
+			const glm::vec3 local_origin = glm::vec3(to_local * glm::vec4(origin, 1.0f));
+			const glm::vec3 local_direction = glm::mat3(to_local) * direction;
+
+			RayHit entity_hit;
+			if (entity->pModel->raycast(local_origin, local_direction, entity_hit, closest_hit.distance))
+			{
+				closest = entity;
+				closest_hit = entity_hit;
+			}
+			return closest_hit.distance;
+		});
+
+		if (hit && closest)
+			*hit = closest_hit;
+		return closest;
+	}
+
+	size_t
+	get_entity_count() const
+	{
+		return tree.get_proxy_count();
+	}
+
+	const DynamicAABBTree<Entity>&
+	get_tree() const
+	{
+		return tree;
+	}
+
+private:
+	DynamicAABBTree<Entity> tree;
+};
@@ -0,0 +1,185 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TRANSPARENT_QUEUE_USE_SSE2 1
+#endif
+
+// Back to front ordering of transparent objects. View space depths are computed four at a time and turned into
+// integer keys, then sorted with a least significant digit radix sort. Once the buffers have grown nothing is
+// allocated, and objects at the same depth keep the order they were pushed in.
+class TransparentQueue
+{
+public:
+	void
+	clear()
+	{
+		xs.clear();
+		ys.clear();
+		zs.clear();
+		ids.clear();
+	}
+
+	// id is handed back by get_order(), usually an index into the caller's objects
+	void
+	push(const glm::vec3& position, unsigned int id)
+	{
+		xs.push_back(position.x);
+		ys.push_back(position.y);
+		zs.push_back(position.z);
+		ids.push_back(id);
+	}
+
+	size_t
+	size() const
+	{
+		return ids.size();
+	}
+
+	// sorts the pushed objects from the farthest to the nearest along the view direction
+	void
+	sort(const glm::mat4& view)
+	{
+		compute_keys(view);
+		radix_sort();
+
+		order.resize(items.size());
+		for (size_t i = 0; i < items.size(); ++i)
+			order[i] = static_cast<unsigned int>(items[i]);
+	}
+
+	// ids in back to front order after sort()
+	const std::vector<unsigned int>&
+	get_order() const
+	{
+		return order;
+	}
+
+private:
+	// positions in structure of arrays form for the depth batch
+	std::vector<float> xs, ys, zs;
+	std::vector<unsigned int> ids;
+
+	// sort key in the high 32 bits, id in the low ones
+	std::vector<uint64_t> items;
+	std::vector<uint64_t> scratch;
+	std::vector<unsigned int> order;
+
+	// Flips the float bits so their unsigned order matches the float order. z is negative in front of the camera, so
+	// the farthest object has the smallest z and the smallest key: an ascending sort is back to front.
+	static uint32_t
+	depth_key(float view_z)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &view_z, sizeof(bits));
+		const uint32_t mask = (bits & 0x80000000u) ? 0xffffffffu : 0x80000000u;
+		return bits ^ mask;
+	}
+
+	void
+	compute_keys(const glm::mat4& view)
+	{
+		const size_t count = ids.size();
+		items.resize(count);
+
+		// z row of the view matrix
+		const float m0 = view[0][2], m1 = view[1][2], m2 = view[2][2], m3 = view[3][2];
+		size_t i = 0;
+#ifdef TRANSPARENT_QUEUE_USE_SSE2
+		const __m128 row0 = _mm_set1_ps(m0);
+		const __m128 row1 = _mm_set1_ps(m1);
+		const __m128 row2 = _mm_set1_ps(m2);
+		const __m128 row3 = _mm_set1_ps(m3);
+		const __m128i sign = _mm_set1_epi32(static_cast<int>(0x80000000u));
+		for (; i + 4 <= count; i += 4)
+		{
+			// summed in the same order as the scalar path, equal depths must produce equal keys
+			__m128 z = _mm_add_ps(_mm_mul_ps(row0, _mm_loadu_ps(&xs[i])), _mm_mul_ps(row1, _mm_loadu_ps(&ys[i])));
+			z = _mm_add_ps(_mm_add_ps(z, _mm_mul_ps(row2, _mm_loadu_ps(&zs[i]))), row3);
+
+			// same as depth_key: all bits flipped for negative values, only the sign for positive ones
+			const __m128i bits = _mm_castps_si128(z);
+			const __m128i mask = _mm_or_si128(_mm_srai_epi32(bits, 31), sign);
+			alignas(16) uint32_t keys[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(keys), _mm_xor_si128(bits, mask));
+			for (size_t lane = 0; lane < 4; ++lane)
+				items[i + lane] = (static_cast<uint64_t>(keys[lane]) << 32) | ids[i + lane];
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			const float z = ((m0 * xs[i] + m1 * ys[i]) + m2 * zs[i]) + m3;
+			items[i] = (static_cast<uint64_t>(depth_key(z)) << 32) | ids[i];
+		}
+	}
+
+	// stable, one byte of the key per pass, passes where every key has the same byte are skipped
+	void
+	radix_sort()
+	{
+		const size_t count = items.size();
+		if (count <= insertion_sort_threshold)
+		{
+			insertion_sort();
+			return;
+		}
+		scratch.resize(count);
+
+		uint32_t histograms[4][256] = {};
+		for (const uint64_t item : items)
+		{
+			const uint32_t key = static_cast<uint32_t>(item >> 32);
+			++histograms[0][key & 0xff];
+			++histograms[1][(key >> 8) & 0xff];
+			++histograms[2][(key >> 16) & 0xff];
+			++histograms[3][key >> 24];
+		}
+
+		uint64_t* source = items.data();
+		uint64_t* destination = scratch.data();
+		for (int pass = 0; pass < 4; ++pass)
+		{
+			uint32_t* histogram = histograms[pass];
+			const unsigned int shift = 32 + pass * 8;
+			if (count == 0 || histogram[(source[0] >> shift) & 0xff] == count)
+				continue;
+
+			// exclusive prefix sum gives the first slot of every digit
+			uint32_t offset = 0;
+			for (int digit = 0; digit < 256; ++digit)
+			{
+				const uint32_t digit_count = histogram[digit];
+				histogram[digit] = offset;
+				offset += digit_count;
+			}
+			for (size_t i = 0; i < count; ++i)
+				destination[histogram[(source[i] >> shift) & 0xff]++] = source[i];
+			std::swap(source, destination);
+		}
+
+		if (source != items.data())
+			items.swap(scratch);
+	}
+
+	// below this the histograms cost more than the sort itself
+	static constexpr size_t insertion_sort_threshold = 64;
+
+	void
+	insertion_sort()
+	{
+		for (size_t i = 1; i < items.size(); ++i)
+		{
+			const uint64_t item = items[i];
+			size_t j = i;
+			for (; j > 0 && (items[j - 1] >> 32) > (item >> 32); --j)
+				items[j] = items[j - 1];
+			items[j] = item;
+		}
+	}
+};
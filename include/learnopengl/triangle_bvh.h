@@ -0,0 +1,492 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <learnopengl/job_system.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define TRIANGLE_BVH_USE_SSE 1
+#endif
+
+// Closest intersection of a ray with the triangles of a model
+struct RayHit
+{
+	// along the ray, in units of the ray direction
+	float distance = std::numeric_limits<float>::max();
+
+	// index of the mesh in the model and of the triangle in the indices of the mesh
+	unsigned int mesh = 0;
+	unsigned int triangle = 0;
+
+	// weights of the second and third vertex of the triangle, the first one is 1 - u - v
+	glm::vec2 barycentrics = glm::vec2(0.0f);
+};
+
+// Bounding volume hierarchy over the triangles of a mesh. Built top down with the binned surface area heuristic, the
+// nodes are flattened in one array with the two children of a node next to each other. Leaves hold up to four
+// triangles in structure of arrays packets so a ray is tested against a whole leaf at once.
+class TriangleBVH
+{
+public:
+	// vertices need a glm::vec3 Position, indices describe a triangle list
+	template<typename VertexType>
+	void
+	build(const std::vector<VertexType>& vertices, const std::vector<unsigned int>& indices,
+		  JobSystem* job_system = nullptr)
+	{
+		const size_t triangle_count = indices.size() / 3;
+		nodes.clear();
+		packets.clear();
+		if (triangle_count == 0)
+			return;
+
+		// bounds and centroid of every triangle
+		BuildState state;
+		state.job_system = job_system;
+		state.triangles.resize(triangle_count);
+		state.positions.resize(triangle_count * 3);
+		const auto prepare = [&](size_t first, size_t last) {
+			for (size_t i = first; i < last; ++i)
+			{
+				const glm::vec3& p0 = vertices[indices[i * 3 + 0]].Position;
+				const glm::vec3& p1 = vertices[indices[i * 3 + 1]].Position;
+				const glm::vec3& p2 = vertices[indices[i * 3 + 2]].Position;
+				BuildTriangle& triangle = state.triangles[i];
+				triangle.bounds_min = glm::min(glm::min(p0, p1), p2);
+				triangle.bounds_max = glm::max(glm::max(p0, p1), p2);
+				triangle.centroid = (triangle.bounds_min + triangle.bounds_max) * 0.5f;
+				triangle.index = static_cast<unsigned int>(i);
+				state.positions[i * 3 + 0] = p0;
+				state.positions[i * 3 + 1] = p1;
+				state.positions[i * 3 + 2] = p2;
+			}
+		};
+		if (job_system)
+			job_system->parallel_for(0, triangle_count, 0, prepare);
+		else
+			prepare(0, triangle_count);
+
+		// a binary tree with leaves of at least one triangle never needs more nodes than this
+		nodes.resize(triangle_count * 2);
+		packets.resize(triangle_count);
+		build_node(state, 0, 0, static_cast<unsigned int>(triangle_count), 0);
+		nodes.resize(state.node_count);
+		packets.resize(state.packet_count);
+	}
+
+	bool
+	empty() const
+	{
+		return nodes.empty();
+	}
+
+	size_t
+	get_node_count() const
+	{
+		return nodes.size();
+	}
+
+	// closest hit of the ray closer than max_distance, fills distance, triangle and barycentrics of the hit
+	bool
+	intersect(const glm::vec3& origin, const glm::vec3& direction, float max_distance, RayHit& hit) const
+	{
+		if (nodes.empty())
+			return false;
+
+		const glm::vec3 inv_direction = 1.0f / direction;
+		float closest = max_distance;
+		bool found = false;
+
+		unsigned int stack[max_depth + 1];
+		unsigned int stack_size = 0;
+		float distance;
+		if (!intersect_box(nodes[0], origin, inv_direction, closest, distance))
+			return false;
+		stack[stack_size++] = 0;
+
+		while (stack_size > 0)
+		{
+			const Node& node = nodes[stack[--stack_size]];
+			if (node.count > 0)
+			{
+				const unsigned int packet_end = node.left_first + (node.count + 3) / 4;
+				for (unsigned int p = node.left_first; p < packet_end; ++p)
+					found |= intersect_packet(packets[p], origin, direction, closest, hit);
+				continue;
+			}
+
+			// nearest child on top, its hits clip the ray before the other child is tested
+			float distance1, distance2;
+			const bool hit1 = intersect_box(nodes[node.left_first], origin, inv_direction, closest, distance1);
+			const bool hit2 = intersect_box(nodes[node.left_first + 1], origin, inv_direction, closest, distance2);
+			if (hit1 && hit2)
+			{
+				stack[stack_size++] = distance1 < distance2 ? node.left_first + 1 : node.left_first;
+				stack[stack_size++] = distance1 < distance2 ? node.left_first : node.left_first + 1;
+			}
+			else if (hit1)
+				stack[stack_size++] = node.left_first;
+			else if (hit2)
+				stack[stack_size++] = node.left_first + 1;
+		}
+
+		if (found)
+			hit.distance = closest;
+		return found;
+	}
+
+private:
+	// 32 bytes, two nodes per cache line. count > 0 for leaves, left_first is then the first packet, otherwise the
+	// left child with the right child just after it.
+	struct alignas(16) Node
+	{
+		glm::vec3 bounds_min;
+		unsigned int left_first;
+		glm::vec3 bounds_max;
+		unsigned int count;
+	};
+
+	// four triangles as first vertex and two edges, unused lanes are degenerate and never hit
+	struct alignas(16) Packet
+	{
+		float v0[3][4];
+		float edge1[3][4];
+		float edge2[3][4];
+		unsigned int triangle[4];
+	};
+
+	// what the split decisions need, small enough to be partitioned in place
+	struct BuildTriangle
+	{
+		glm::vec3 bounds_min;
+		glm::vec3 bounds_max;
+		glm::vec3 centroid;
+		unsigned int index;
+	};
+
+	// shared by the jobs of one build, each of them working on its own range of triangles
+	struct BuildState
+	{
+		JobSystem* job_system = nullptr;
+
+		// reordered by the build so every node covers a contiguous range
+		std::vector<BuildTriangle> triangles;
+
+		// corners of every triangle by original index, only read by the leaves
+		std::vector<glm::vec3> positions;
+
+		// the root is allocated up front
+		std::atomic<unsigned int> node_count{1};
+		std::atomic<unsigned int> packet_count{0};
+	};
+
+	struct Bin
+	{
+		glm::vec3 bounds_min = glm::vec3(std::numeric_limits<float>::max());
+		glm::vec3 bounds_max = glm::vec3(std::numeric_limits<float>::lowest());
+		unsigned int count = 0;
+	};
+
+	static constexpr unsigned int bin_count = 16;
+	static constexpr unsigned int max_leaf_size = 4;
+
+	// the traversal stack is sized for it, deeper ranges become leaves
+	static constexpr unsigned int max_depth = 64;
+
+	// ranges larger than this are split on the job system
+	static constexpr unsigned int parallel_threshold = 4096;
+
+	std::vector<Node> nodes;
+	std::vector<Packet> packets;
+
+	static float
+	half_area(const glm::vec3& bounds_min, const glm::vec3& bounds_max)
+	{
+		const glm::vec3 e = bounds_max - bounds_min;
+		return e.x * e.y + e.y * e.z + e.z * e.x;
+	}
+
+	void
+	build_node(BuildState& state, unsigned int node_index, unsigned int first, unsigned int count, unsigned int depth)
+	{
+		glm::vec3 bounds_min(std::numeric_limits<float>::max());
+		glm::vec3 bounds_max(std::numeric_limits<float>::lowest());
+		glm::vec3 centroid_min(std::numeric_limits<float>::max());
+		glm::vec3 centroid_max(std::numeric_limits<float>::lowest());
+		for (unsigned int i = first; i < first + count; ++i)
+		{
+			const BuildTriangle& triangle = state.triangles[i];
+			bounds_min = glm::min(bounds_min, triangle.bounds_min);
+			bounds_max = glm::max(bounds_max, triangle.bounds_max);
+			centroid_min = glm::min(centroid_min, triangle.centroid);
+			centroid_max = glm::max(centroid_max, triangle.centroid);
+		}
+		nodes[node_index].bounds_min = bounds_min;
+		nodes[node_index].bounds_max = bounds_max;
+
+		if (count <= max_leaf_size || depth >= max_depth - 1)
+		{
+			make_leaf(state, node_index, first, count);
+			return;
+		}
+
+		const unsigned int split = find_split(state, first, count, centroid_min, centroid_max);
+		const unsigned int left_count = split - first;
+
+		const unsigned int left = state.node_count.fetch_add(2);
+		nodes[node_index].left_first = left;
+		nodes[node_index].count = 0;
+
+		if (state.job_system && count > parallel_threshold)
+		{
+			JobCounter counter;
+			state.job_system->run(
+				[this, &state, left, first, left_count, depth] {
+					build_node(state, left, first, left_count, depth + 1);
+				},
+				&counter);
+			build_node(state, left + 1, split, count - left_count, depth + 1);
+			state.job_system->wait(counter);
+		}
+		else
+		{
+			build_node(state, left, first, left_count, depth + 1);
+			build_node(state, left + 1, split, count - left_count, depth + 1);
+		}
+	}
+
+	// partitions the range on the cheapest binned split and returns where the right side starts
+	unsigned int
+	find_split(BuildState& state, unsigned int first, unsigned int count, const glm::vec3& centroid_min,
+			   const glm::vec3& centroid_max)
+	{
+		// the three axes are binned in a single pass over the triangles
+		const glm::vec3 extent = centroid_max - centroid_min;
+		glm::vec3 scale;
+		for (int axis = 0; axis < 3; ++axis)
+			scale[axis] = extent[axis] > 0.0f ? bin_count / extent[axis] : 0.0f;
+
+		Bin bins[3][bin_count];
+		for (unsigned int i = first; i < first + count; ++i)
+		{
+			const BuildTriangle& triangle = state.triangles[i];
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				Bin& bin = bins[axis][bin_index(triangle.centroid[axis], centroid_min[axis], scale[axis])];
+				bin.bounds_min = glm::min(bin.bounds_min, triangle.bounds_min);
+				bin.bounds_max = glm::max(bin.bounds_max, triangle.bounds_max);
+				++bin.count;
+			}
+		}
+
+		float best_cost = std::numeric_limits<float>::max();
+		int best_axis = -1;
+		unsigned int best_bin = 0;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (extent[axis] <= 0.0f)
+				continue;
+
+			// sweep from both sides, left_area[i] and left_count[i] cover the bins up to i
+			float left_area[bin_count - 1];
+			unsigned int left_count[bin_count - 1];
+			Bin left;
+			for (unsigned int i = 0; i < bin_count - 1; ++i)
+			{
+				left.bounds_min = glm::min(left.bounds_min, bins[axis][i].bounds_min);
+				left.bounds_max = glm::max(left.bounds_max, bins[axis][i].bounds_max);
+				left.count += bins[axis][i].count;
+				left_area[i] = left.count ? half_area(left.bounds_min, left.bounds_max) : 0.0f;
+				left_count[i] = left.count;
+			}
+			Bin right;
+			for (unsigned int i = bin_count - 1; i > 0; --i)
+			{
+				right.bounds_min = glm::min(right.bounds_min, bins[axis][i].bounds_min);
+				right.bounds_max = glm::max(right.bounds_max, bins[axis][i].bounds_max);
+				right.count += bins[axis][i].count;
+				if (left_count[i - 1] == 0 || right.count == 0)
+					continue;
+
+				const float cost = left_count[i - 1] * left_area[i - 1] +
+								   right.count * half_area(right.bounds_min, right.bounds_max);
+				if (cost < best_cost)
+				{
+					best_cost = cost;
+					best_axis = axis;
+					best_bin = i;
+				}
+			}
+		}
+
+		// all centroids in one point, split in the middle
+		if (best_axis == -1)
+			return first + count / 2;
+
+		const auto begin = state.triangles.begin() + first;
+		const auto split = std::partition(begin, begin + count, [&](const BuildTriangle& triangle) {
+			return bin_index(triangle.centroid[best_axis], centroid_min[best_axis], scale[best_axis]) < best_bin;
+		});
+		return static_cast<unsigned int>(split - state.triangles.begin());
+	}
+
+	static unsigned int
+	bin_index(float centroid, float centroid_min, float scale)
+	{
+		return std::min(bin_count - 1, static_cast<unsigned int>((centroid - centroid_min) * scale));
+	}
+
+	void
+	make_leaf(BuildState& state, unsigned int node_index, unsigned int first, unsigned int count)
+	{
+		const unsigned int packet_total = (count + 3) / 4;
+		const unsigned int first_packet = state.packet_count.fetch_add(packet_total);
+		nodes[node_index].left_first = first_packet;
+		nodes[node_index].count = count;
+
+		for (unsigned int p = 0; p < packet_total; ++p)
+		{
+			Packet& packet = packets[first_packet + p];
+			packet = Packet();
+			for (unsigned int lane = 0; lane < 4; ++lane)
+			{
+				const unsigned int i = p * 4 + lane;
+				if (i >= count)
+				{
+					packet.triangle[lane] = 0;
+					continue;
+				}
+
+				const unsigned int triangle = state.triangles[first + i].index;
+				const glm::vec3& p0 = state.positions[triangle * 3 + 0];
+				const glm::vec3 edge1 = state.positions[triangle * 3 + 1] - p0;
+				const glm::vec3 edge2 = state.positions[triangle * 3 + 2] - p0;
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					packet.v0[axis][lane] = p0[axis];
+					packet.edge1[axis][lane] = edge1[axis];
+					packet.edge2[axis][lane] = edge2[axis];
+				}
+				packet.triangle[lane] = triangle;
+			}
+		}
+	}
+
+	static bool
+	intersect_box(const Node& node, const glm::vec3& origin, const glm::vec3& inv_direction, float max_distance,
+				  float& distance)
+	{
+		const glm::vec3 t0 = (node.bounds_min - origin) * inv_direction;
+		const glm::vec3 t1 = (node.bounds_max - origin) * inv_direction;
+		const glm::vec3 t_near = glm::min(t0, t1);
+		const glm::vec3 t_far = glm::max(t0, t1);
+		const float enter = std::max(std::max(t_near.x, t_near.y), std::max(t_near.z, 0.0f));
+		const float exit = std::min(std::min(t_far.x, t_far.y), std::min(t_far.z, max_distance));
+		distance = enter;
+		return enter <= exit;
+	}
+
+	// Moeller-Trumbore against the four triangles of the packet, double sided. Updates closest and hit on a closer hit.
+	static bool
+	intersect_packet(const Packet& packet, const glm::vec3& origin, const glm::vec3& direction, float& closest,
+					 RayHit& hit)
+	{
+		const float epsilon = 1e-8f;
+		float t[4], u[4], v[4];
+		int mask;
+
+#ifdef TRIANGLE_BVH_USE_SSE
+		const __m128 dir_x = _mm_set1_ps(direction.x);
+		const __m128 dir_y = _mm_set1_ps(direction.y);
+		const __m128 dir_z = _mm_set1_ps(direction.z);
+		const __m128 e1_x = _mm_load_ps(packet.edge1[0]);
+		const __m128 e1_y = _mm_load_ps(packet.edge1[1]);
+		const __m128 e1_z = _mm_load_ps(packet.edge1[2]);
+		const __m128 e2_x = _mm_load_ps(packet.edge2[0]);
+		const __m128 e2_y = _mm_load_ps(packet.edge2[1]);
+		const __m128 e2_z = _mm_load_ps(packet.edge2[2]);
+
+		// p = direction x edge2
+		const __m128 p_x = _mm_sub_ps(_mm_mul_ps(dir_y, e2_z), _mm_mul_ps(dir_z, e2_y));
+		const __m128 p_y = _mm_sub_ps(_mm_mul_ps(dir_z, e2_x), _mm_mul_ps(dir_x, e2_z));
+		const __m128 p_z = _mm_sub_ps(_mm_mul_ps(dir_x, e2_y), _mm_mul_ps(dir_y, e2_x));
+		const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1_x, p_x), _mm_mul_ps(e1_y, p_y)), _mm_mul_ps(e1_z, p_z));
+		const __m128 inv_det = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+		// s = origin - v0
+		const __m128 s_x = _mm_sub_ps(_mm_set1_ps(origin.x), _mm_load_ps(packet.v0[0]));
+		const __m128 s_y = _mm_sub_ps(_mm_set1_ps(origin.y), _mm_load_ps(packet.v0[1]));
+		const __m128 s_z = _mm_sub_ps(_mm_set1_ps(origin.z), _mm_load_ps(packet.v0[2]));
+		const __m128 u_v = _mm_mul_ps(
+			_mm_add_ps(_mm_add_ps(_mm_mul_ps(s_x, p_x), _mm_mul_ps(s_y, p_y)), _mm_mul_ps(s_z, p_z)), inv_det);
+
+		// q = s x edge1
+		const __m128 q_x = _mm_sub_ps(_mm_mul_ps(s_y, e1_z), _mm_mul_ps(s_z, e1_y));
+		const __m128 q_y = _mm_sub_ps(_mm_mul_ps(s_z, e1_x), _mm_mul_ps(s_x, e1_z));
+		const __m128 q_z = _mm_sub_ps(_mm_mul_ps(s_x, e1_y), _mm_mul_ps(s_y, e1_x));
+		const __m128 v_v = _mm_mul_ps(
+			_mm_add_ps(_mm_add_ps(_mm_mul_ps(dir_x, q_x), _mm_mul_ps(dir_y, q_y)), _mm_mul_ps(dir_z, q_z)), inv_det);
+		const __m128 t_v = _mm_mul_ps(
+			_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2_x, q_x), _mm_mul_ps(e2_y, q_y)), _mm_mul_ps(e2_z, q_z)), inv_det);
+
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 abs_det = _mm_max_ps(det, _mm_sub_ps(zero, det));
+		__m128 valid = _mm_cmpgt_ps(abs_det, _mm_set1_ps(epsilon));
+		valid = _mm_and_ps(valid, _mm_cmpge_ps(u_v, zero));
+		valid = _mm_and_ps(valid, _mm_cmpge_ps(v_v, zero));
+		valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(u_v, v_v), _mm_set1_ps(1.0f)));
+		valid = _mm_and_ps(valid, _mm_cmpge_ps(t_v, zero));
+		valid = _mm_and_ps(valid, _mm_cmplt_ps(t_v, _mm_set1_ps(closest)));
+		mask = _mm_movemask_ps(valid);
+		if (mask == 0)
+			return false;
+
+		_mm_storeu_ps(t, t_v);
+		_mm_storeu_ps(u, u_v);
+		_mm_storeu_ps(v, v_v);
+#else
+		mask = 0;
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			const glm::vec3 edge1(packet.edge1[0][lane], packet.edge1[1][lane], packet.edge1[2][lane]);
+			const glm::vec3 edge2(packet.edge2[0][lane], packet.edge2[1][lane], packet.edge2[2][lane]);
+			const glm::vec3 v0(packet.v0[0][lane], packet.v0[1][lane], packet.v0[2][lane]);
+
+			const glm::vec3 p = glm::cross(direction, edge2);
+			const float det = glm::dot(edge1, p);
+			if (std::abs(det) <= epsilon)
+				continue;
+
+			const float inv_det = 1.0f / det;
+			const glm::vec3 s = origin - v0;
+			const glm::vec3 q = glm::cross(s, edge1);
+			u[lane] = glm::dot(s, p) * inv_det;
+			v[lane] = glm::dot(direction, q) * inv_det;
+			t[lane] = glm::dot(edge2, q) * inv_det;
+			if (u[lane] >= 0.0f && v[lane] >= 0.0f && u[lane] + v[lane] <= 1.0f && t[lane] >= 0.0f &&
+				t[lane] < closest)
+				mask |= 1 << lane;
+		}
+		if (mask == 0)
+			return false;
+#endif
+
+		bool found = false;
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			if ((mask & (1 << lane)) && t[lane] < closest)
+			{
+				closest = t[lane];
+				hit.triangle = packet.triangle[lane];
+				hit.barycentrics = glm::vec2(u[lane], v[lane]);
+				found = true;
+			}
+		}
+		return found;
+	}
+};
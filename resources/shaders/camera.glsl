@@ -0,0 +1,17 @@
+// the per-frame camera, one uniform buffer shared by all programs (include/learnopengl/camera_uniforms.h)
+
+layout(std140) uniform Camera
+{
+	mat4 view;
+	mat4 projection;
+	mat4 view_projection;
+	mat4 inverse_view;
+	mat4 inverse_projection;
+	mat4 inverse_view_projection;
+	// xyz world space position
+	vec4 position;
+	// width, height, 1 / width, 1 / height in pixels
+	vec4 viewport;
+	// seconds since the start, frame time, near and far plane
+	vec4 time;
+} camera;
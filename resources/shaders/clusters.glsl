@@ -0,0 +1,57 @@
+// clustered forward lighting, shared by the compute passes and the shading of 2.lighting/7.clustered_forward
+// the view frustum is split in CLUSTER_X * CLUSTER_Y screen tiles and CLUSTER_Z depth slices, the demo injects the
+// counts; cluster x + CLUSTER_X * (y + CLUSTER_Y * z) lists the lights touching it
+
+#include "camera.glsl"
+
+struct PointLight
+{
+	// xyz world space position, w radius
+	vec4 position;
+	// rgb intensity, w unused
+	vec4 color;
+};
+
+// view space bounding box of every cluster, min and max
+layout(std430, binding = 0) buffer ClusterBounds
+{
+	vec4 clusterBounds[];
+};
+
+layout(std430, binding = 1) buffer Lights
+{
+	PointLight lights[];
+};
+
+// xyz view space position, w radius, what the culling tests against
+layout(std430, binding = 2) buffer ViewLights
+{
+	vec4 viewLights[];
+};
+
+// offset and count of the lights of every cluster in lightIndices
+layout(std430, binding = 3) buffer LightGrid
+{
+	uvec2 lightGrid[];
+};
+
+// the lists of all clusters packed one after the other; lightIndexCount is the allocation counter, reset every frame
+layout(std430, binding = 4) buffer LightIndices
+{
+	uint lightIndexCount;
+	uint lightIndices[];
+};
+
+// the slices are spaced logarithmically, so clusters keep about the same proportions near and far
+float slice_depth(uint slice)
+{
+	return camera.time.z * pow(camera.time.w / camera.time.z, float(slice) / float(CLUSTER_Z));
+}
+
+uint cluster_index(vec2 frag_coord, float view_depth)
+{
+	float slice = log(view_depth / camera.time.z) * float(CLUSTER_Z) / log(camera.time.w / camera.time.z);
+	uvec3 cluster = uvec3(frag_coord * camera.viewport.zw * vec2(CLUSTER_X, CLUSTER_Y), max(slice, 0.0));
+	cluster = min(cluster, uvec3(CLUSTER_X - 1, CLUSTER_Y - 1, CLUSTER_Z - 1));
+	return cluster.x + CLUSTER_X * (cluster.y + CLUSTER_Y * cluster.z);
+}
@@ -0,0 +1,36 @@
+// the compact G-buffer of 5.advanced_lighting/8.1.deferred_shading, 8 bytes of color per pixel:
+//   albedo  rgba8     albedo, specular strength
+//   normal  rgb10_a2  octahedral world space normal, shininess / 256
+// positions are not stored, they are rebuilt from the depth buffer
+
+#include "camera.glsl"
+
+// folds the lower hemisphere of the octahedron over the upper one
+vec2 oct_wrap(vec2 v)
+{
+	return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// unit vector to [0, 1]^2
+vec2 encode_normal(vec3 n)
+{
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	vec2 encoded = n.z >= 0.0 ? n.xy : oct_wrap(n.xy);
+	return encoded * 0.5 + 0.5;
+}
+
+vec3 decode_normal(vec2 encoded)
+{
+	encoded = encoded * 2.0 - 1.0;
+	vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float t = clamp(-n.z, 0.0, 1.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
+
+// world space position of the surface seen at uv, in [0, 1], with the depth buffer value depth
+vec3 world_position_from_depth(vec2 uv, float depth)
+{
+	vec4 position = camera.inverse_view_projection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+	return position.xyz / position.w;
+}
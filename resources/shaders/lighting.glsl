@@ -0,0 +1,17 @@
+// lighting terms shared by the demos, included with #include "lighting.glsl"
+
+vec3 ambient_term(float strength, vec3 light_color)
+{
+	return strength * light_color;
+}
+
+vec3 diffuse_term(vec3 normal, vec3 light_dir, vec3 light_color)
+{
+	return max(dot(normal, light_dir), 0.0) * light_color;
+}
+
+vec3 specular_term(vec3 normal, vec3 light_dir, vec3 view_dir, float strength, float shininess, vec3 light_color)
+{
+	vec3 reflect_dir = reflect(-light_dir, normal);
+	return strength * pow(max(dot(view_dir, reflect_dir), 0.0), shininess) * light_color;
+}
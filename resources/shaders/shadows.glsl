@@ -0,0 +1,47 @@
+// cascaded shadow maps of a directional light, set by CascadedShadowMap::bind (include/learnopengl/cascaded_shadows.h)
+
+#define MAX_CASCADES 4
+
+uniform sampler2DArrayShadow shadowMap;
+uniform int cascadeCount;
+// direction the light travels in, world space
+uniform vec3 lightDirection;
+uniform mat4 lightSpaceMatrices[MAX_CASCADES];
+// view distance at which each cascade ends
+uniform float cascadeSplits[MAX_CASCADES];
+// world space size of a texel of each cascade
+uniform float cascadeTexelSizes[MAX_CASCADES];
+
+// the cascade covering a view distance, the last one beyond
+int shadow_cascade(float view_depth)
+{
+	for (int i = 0; i < cascadeCount - 1; ++i)
+	{
+		if (view_depth < cascadeSplits[i])
+			return i;
+	}
+	return cascadeCount - 1;
+}
+
+// 1 lit, 0 shadowed. 3x3 taps of the hardware 2x2 comparison, beyond the last cascade nothing is shadowed
+float shadow_factor(vec3 world_pos, vec3 normal, float view_depth)
+{
+	if (view_depth >= cascadeSplits[cascadeCount - 1])
+		return 1.0;
+	int cascade = shadow_cascade(view_depth);
+
+	// moved off the surface by about a texel, more on surfaces the light grazes, against acne
+	float grazing = 1.0 - abs(dot(normal, lightDirection));
+	vec3 offset_pos = world_pos + normal * cascadeTexelSizes[cascade] * (0.5 + 1.5 * grazing);
+	vec4 light_pos = lightSpaceMatrices[cascade] * vec4(offset_pos, 1.0);
+	vec3 coords = light_pos.xyz / light_pos.w * 0.5 + 0.5;
+
+	vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+	float lit = 0.0;
+	for (int x = -1; x <= 1; ++x)
+	{
+		for (int y = -1; y <= 1; ++y)
+			lit += texture(shadowMap, vec4(coords.xy + vec2(x, y) * texel, float(cascade), coords.z));
+	}
+	return lit / 9.0;
+}
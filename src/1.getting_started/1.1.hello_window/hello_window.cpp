@@ -1,10 +1,15 @@
 #include <learnopengl/common.h>
 const char *TITLE = "learn_opengl -- glfw_window";
 
-int main() {
+int main(int argc, char **argv) {
+  // --frames runs a fixed number of frames in an invisible window, see
+  // headless.h
+  HeadlessRun headless(parse_headless_options(argc, argv));
+
   // glfw:initialization and configuration
   //-------------------------------------------------------
-  GLFWwindow *window = create_glfw_window(TITLE, SCR_WIDTH, SCR_HEIGHT);
+  GLFWwindow *window =
+      create_glfw_window(TITLE, SCR_WIDTH, SCR_HEIGHT, headless);
 
   // we want to initialize GLAD before we call any OpenGL function:
   //-------------------------------------------------------
@@ -38,6 +43,7 @@ int main() {
     // uses the current state to retrieve the clearing color from.
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
+    headless.end_frame(window);
 
     // check and call events and swap buffers
     glfwSwapBuffers(window);
@@ -49,5 +55,5 @@ int main() {
   //  were allocated. We can do this via the glfwTerminate function that we call
   //  at the end of the main function.
   glfwTerminate();
-  return 0;
+  return headless.exit_code();
 }
\ No newline at end of file
@@ -40,12 +40,15 @@ GLuint process_shader_program();
 void processInput(GLFWwindow *window);
 
 // continuous drawing  loop until glfw window got terminate event
-void render_loop(GLFWwindow *window, GLuint shader_program, GLuint VAO);
+void render_loop(GLFWwindow *window, GLuint shader_program, GLuint VAO, HeadlessRun &headless);
 
-int main()
+int main(int argc, char **argv)
 {
+	// --frames runs a fixed number of frames in an invisible window, see headless.h
+	HeadlessRun headless(parse_headless_options(argc, argv));
+
 	// create GLFW window
-	GLFWwindow *window = create_glfw_window(TITLE, SCR_WIDTH, SCR_HEIGHT);
+	GLFWwindow *window = create_glfw_window(TITLE, SCR_WIDTH, SCR_HEIGHT, headless);
 
 	// check for success
 	if (window == NULL)
@@ -73,7 +76,7 @@ int main()
 	GLuint shader_program = process_shader_program();
 
 	// render loop
-	render_loop(window, shader_program, VAO);
+	render_loop(window, shader_program, VAO, headless);
 
 	// optional: de-allocate all resources once they've outlived their purpose:
 	// ------------------------------------------------------------------------
@@ -85,7 +88,7 @@ int main()
 	// ------------------------------------------------------------------
 	glfwTerminate();
 	delete vertices;
-	return 0;
+	return headless.exit_code();
 }
 
 float *generate_triangle_data()
@@ -192,7 +195,7 @@ GLuint process_shader_program()
 	return shaderProgram;
 }
 
-void render_loop(GLFWwindow *window, GLuint shader_program, GLuint VAO)
+void render_loop(GLFWwindow *window, GLuint shader_program, GLuint VAO, HeadlessRun &headless)
 {
 	// render loop
 	while (!glfwWindowShouldClose(window))
@@ -210,6 +213,7 @@ void render_loop(GLFWwindow *window, GLuint shader_program, GLuint VAO)
 		glUseProgram(shader_program);
 		glBindVertexArray(VAO);
 		glDrawArrays(GL_TRIANGLES, 0, 3);
+		headless.end_frame(window);
 
 		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
 		// ------------------------------------------------------------------
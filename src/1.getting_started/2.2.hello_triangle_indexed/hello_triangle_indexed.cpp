@@ -10,10 +10,16 @@ void copy_vertices_to_gpu(float **vertices, int n_verts, int **indices,
 
 GLuint process_shader_program();
 
-void render_loop(GLFWwindow *window, GLuint shader_program, GLuint VAO);
+void render_loop(GLFWwindow *window, GLuint shader_program, GLuint VAO,
+                 HeadlessRun &headless);
 
-int main() {
-  GLFWwindow *window = create_glfw_window(TITLE, SCR_WIDTH, SCR_HEIGHT);
+int main(int argc, char **argv) {
+  // --frames runs a fixed number of frames in an invisible window, see
+  // headless.h
+  HeadlessRun headless(parse_headless_options(argc, argv));
+
+  GLFWwindow *window =
+      create_glfw_window(TITLE, SCR_WIDTH, SCR_HEIGHT, headless);
 
   // check for success
   if (window == NULL) {
@@ -41,7 +47,7 @@ int main() {
   copy_vertices_to_gpu(&vertices, n_verts, &indices, n_indices, VBO, VAO, EBO);
 
   // Render
-  render_loop(window, shader_program, VAO);
+  render_loop(window, shader_program, VAO, headless);
 
   // optional: de-allocate all resources once they've outlived their purpose:
   // ------------------------------------------------------------------------
@@ -58,7 +64,7 @@ int main() {
   // ------------------------------------------------------------------
   delete[] vertices;
   delete[] indices;
-  return 0;
+  return headless.exit_code();
 }
 
 void generate_indexed_triangles(float **vertices, int *n_verts, int **indices,
@@ -174,7 +180,8 @@ GLuint process_shader_program() {
   return shaderProgram;
 }
 
-void render_loop(GLFWwindow *window, GLuint shader_program, GLuint VAO) {
+void render_loop(GLFWwindow *window, GLuint shader_program, GLuint VAO,
+                 HeadlessRun &headless) {
   // uncomment this call to draw in wireframe polygons.
   // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
@@ -198,6 +205,7 @@ void render_loop(GLFWwindow *window, GLuint shader_program, GLuint VAO) {
     // glDrawArrays(GL_TRIANGLES, 0, 6);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
     // glBindVertexArray(0); // no need to unbind it every time
+    headless.end_frame(window);
 
     // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved
     // etc.)
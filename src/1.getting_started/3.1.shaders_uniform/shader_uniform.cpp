@@ -24,12 +24,18 @@ const char *fragmentShaderSource2 = "#version 330 core\n"
 float *generate_single_triangle();
 GLuint process_shader_program();
 void copy_vertices_to_gpu(float *vertices, GLuint &VBO, GLuint &VAO);
-void render_loop(GLFWwindow *window, GLuint shader_program, GLuint VAO);
+void render_loop(GLFWwindow *window, GLuint shader_program, GLuint VAO,
+                 HeadlessRun &headless);
+
+int main(int argc, char **argv) {
+  // --frames runs a fixed number of frames in an invisible window, see
+  // headless.h
+  HeadlessRun headless(parse_headless_options(argc, argv));
 
-int main() {
   // glfw:window creation, initialization and configuration
   //-------------------------------------------------------
-  GLFWwindow *window = create_glfw_window(TITLE, SCR_WIDTH, SCR_HEIGHT);
+  GLFWwindow *window =
+      create_glfw_window(TITLE, SCR_WIDTH, SCR_HEIGHT, headless);
   if (window == NULL) {
     std::cout << "Failed to create GlFW Window! " << std::endl;
     glfwTerminate();
@@ -55,7 +61,7 @@ int main() {
   unsigned int VBO, VAO;
   copy_vertices_to_gpu(vertices, VBO, VAO);
 
-  render_loop(window, shader_program, VAO);
+  render_loop(window, shader_program, VAO, headless);
 
   // optional: de-allocate all resources once they've outlived their purpose:
   // ------------------------------------------------------------------------
@@ -66,7 +72,7 @@ int main() {
   // glfw: terminate, clearing all previously allocated GLFW resources.
   // ------------------------------------------------------------------
   glfwTerminate();
-  return 0;
+  return headless.exit_code();
 }
 
 float *generate_single_triangle() {
@@ -176,7 +182,8 @@ void copy_vertices_to_gpu(float *vertices, GLuint &VBO, GLuint &VAO) {
   glBindVertexArray(0);
 }
 
-void render_loop(GLFWwindow *window, GLuint shader_program, GLuint VAO) {
+void render_loop(GLFWwindow *window, GLuint shader_program, GLuint VAO,
+                 HeadlessRun &headless) {
   // render loop
   while (!glfwWindowShouldClose(window)) {
     // input
@@ -195,7 +202,7 @@ void render_loop(GLFWwindow *window, GLuint shader_program, GLuint VAO) {
     glBindVertexArray(VAO);
 
     // update shader uniform
-    double timeValue = glfwGetTime();
+    double timeValue = headless.frame_time(static_cast<float>(glfwGetTime()));
     float greenValue = static_cast<float>(sin(timeValue) / 2.0 + 0.5);
     int vertexColorLocation = glGetUniformLocation(shader_program, "ourColor");
     // updating a uniform does require you to first use the program (by calling
@@ -204,6 +211,7 @@ void render_loop(GLFWwindow *window, GLuint shader_program, GLuint VAO) {
     glUniform4f(vertexColorLocation, 0.0f, greenValue, 0.0f, 1.0f);
 
     glDrawArrays(GL_TRIANGLES, 0, 3);
+    headless.end_frame(window);
 
     // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved
     // etc.)
@@ -30,13 +30,16 @@ void copy_vertices_to_gpu(float *vertices, GLuint &VBO, GLuint &VAO);
 // build and compile our shader program
 GLuint process_shader_program();
 
-void render_loop(GLFWwindow *window, GLuint shader, GLuint VAO);
+void render_loop(GLFWwindow *window, GLuint shader, GLuint VAO, HeadlessRun &headless);
 
-int main()
+int main(int argc, char **argv)
 {
+    // --frames runs a fixed number of frames in an invisible window, see headless.h
+    HeadlessRun headless(parse_headless_options(argc, argv));
+
     // glfw:initialization, configuration and window creation
     //-------------------------------------------------------
-    GLFWwindow *window = create_glfw_window(TITLE, SCR_WIDTH, SCR_HEIGHT);
+    GLFWwindow *window = create_glfw_window(TITLE, SCR_WIDTH, SCR_HEIGHT, headless);
     if (window == NULL)
     {
         std::cout << "Failed to create GlFW Window! " << std::endl;
@@ -64,7 +67,7 @@ int main()
     unsigned int VBO, VAO;
     copy_vertices_to_gpu(vertices, VBO, VAO);
 
-    render_loop(window, shader_program, VAO);
+    render_loop(window, shader_program, VAO, headless);
 
     // optional: de-allocate all resources once they've outlived their purpose:
     // ------------------------------------------------------------------------
@@ -75,7 +78,7 @@ int main()
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
     glfwTerminate();
-    return 0;
+    return headless.exit_code();
 }
 
 float *generate_colored_triangle()
@@ -157,7 +160,7 @@ GLuint process_shader_program()
     return shaderProgram;
 }
 
-void render_loop(GLFWwindow *window, GLuint shader_program, GLuint VAO)
+void render_loop(GLFWwindow *window, GLuint shader_program, GLuint VAO, HeadlessRun &headless)
 { // bind the VAO (it was already bound, but just to demonstrate): seeing as we only have a single VAO we can
     // just bind it beforehand before rendering the respective triangle; this is another approach.
     glBindVertexArray(VAO);
@@ -175,6 +178,7 @@ void render_loop(GLFWwindow *window, GLuint shader_program, GLuint VAO)
 
         // draw our first triangles
         glDrawArrays(GL_TRIANGLES, 0, 3);
+        headless.end_frame(window);
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // ------------------------------------------------------------------
@@ -1,15 +1,11 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec2 aTexCoord;
+layout (location = 1) in vec3 aColor;
 
-out vec2 TexCoord;
-
-uniform mat4 modal;
-uniform mat4 view;
-uniform mat4 projection;
+out vec3 ourColor;
 
 void main()
 {
-	gl_Position = projection * view * modal *vec4(aPos, 1.0);
-	TexCoord = vec2(aTexCoord.x, aTexCoord.y);
+	gl_Position = vec4(aPos, 1.0);
+	ourColor = aColor;
 }
\ No newline at end of file
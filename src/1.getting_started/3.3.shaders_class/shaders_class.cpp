@@ -7,13 +7,16 @@ float *generate_colored_triangle();
 void copy_vertices_to_gpu(float *vertices, GLuint &VBO, GLuint &VAO);
 // build and compile our shader program
 GLuint process_shader_program();
-void render_loop(GLFWwindow *window, Shader &shader, GLuint VAO);
+void render_loop(GLFWwindow *window, Shader &shader, GLuint VAO, HeadlessRun &headless);
 
-int main()
+int main(int argc, char **argv)
 {
+    // --frames runs a fixed number of frames in an invisible window, see headless.h
+    HeadlessRun headless(parse_headless_options(argc, argv));
+
     // glfw:initialization, configuration and window creation
     //-------------------------------------------------------
-    GLFWwindow *window = create_glfw_window(TITLE, SCR_WIDTH, SCR_HEIGHT);
+    GLFWwindow *window = create_glfw_window(TITLE, SCR_WIDTH, SCR_HEIGHT, headless);
     if (window == NULL)
     {
         std::cout << "Failed to create GlFW Window! " << std::endl;
@@ -42,7 +45,7 @@ int main()
     unsigned int VBO, VAO;
     copy_vertices_to_gpu(vertices, VBO, VAO);
 
-    render_loop(window, ourShader, VAO);
+    render_loop(window, ourShader, VAO, headless);
 
     // optional: de-allocate all resources once they've outlived their purpose:
     // ------------------------------------------------------------------------
@@ -53,7 +56,7 @@ int main()
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
     glfwTerminate();
-    return 0;
+    return headless.exit_code();
 }
 
 float *generate_colored_triangle()
@@ -86,7 +89,7 @@ void copy_vertices_to_gpu(float *vertices, GLuint &VBO, GLuint &VAO)
     glBindVertexArray(0);
 }
 
-void render_loop(GLFWwindow *window, Shader &our_shader, GLuint VAO)
+void render_loop(GLFWwindow *window, Shader &our_shader, GLuint VAO, HeadlessRun &headless)
 { // bind the VAO (it was already bound, but just to demonstrate): seeing as we only have a single VAO we can
     // just bind it beforehand before rendering the respective triangle; this is another approach.
     glBindVertexArray(VAO);
@@ -104,6 +107,7 @@ void render_loop(GLFWwindow *window, Shader &our_shader, GLuint VAO)
 
         // draw our first triangles
         glDrawArrays(GL_TRIANGLES, 0, 3);
+        headless.end_frame(window);
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // ------------------------------------------------------------------
@@ -9,17 +9,25 @@ uniform vec3 lightPos;
 uniform vec3 lightColor;
 uniform vec3 objectColor;
 
+#include "camera.glsl"
+#include "lighting.glsl"
+
 void main() {
 
 	// ambient
-	float ambient_strength = 0.1;
-	vec3 ambient = ambient_strength * lightColor;
+	vec3 ambient = ambient_term(0.1, lightColor);
 
 	// diffuse 
 	vec3 norm = normalize(Normal);
 	vec3 light_dir = normalize(lightPos - FragPos);
-	float diff = max(dot(norm, light_dir), 0.0);
-	vec3 diffuse = diff * lightColor;
-	vec3 result = (ambient + diffuse) * objectColor;
-	Fragcolor = vec4(result, 1.0);
+	vec3 diffuse = diffuse_term(norm, light_dir, lightColor);
+	vec3 result = ambient + diffuse;
+
+#ifdef USE_SPECULAR
+	// specular, compiled in only for the variant that asks for it
+	vec3 view_dir = normalize(camera.position.xyz - FragPos);
+	result += specular_term(norm, light_dir, view_dir, 0.5, 32.0, lightColor);
+#endif
+
+	Fragcolor = vec4(result * objectColor, 1.0);
 }
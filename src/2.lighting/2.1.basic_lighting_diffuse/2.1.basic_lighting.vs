@@ -5,13 +5,13 @@ layout(location = 1) in vec3 aNormal;
 out vec3 FragPos;
 out vec3 Normal;
 
+#include "camera.glsl"
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main() {
     FragPos = vec3(model * vec4(aPos, 1.0));
     Normal = aNormal;
 
-    gl_Position = projection * view * model * vec4(FragPos, 1.0);
-}
\ No newline at end of file
+    gl_Position = camera.view_projection * vec4(FragPos, 1.0);
+}
@@ -2,9 +2,9 @@
 
 layout(location = 0) in vec3 aPos;
 
+#include "camera.glsl"
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 void main() {
-	gl_Position = projection * view * model * vec4(aPos, 1.0);
-}
\ No newline at end of file
+	gl_Position = camera.view_projection * model * vec4(aPos, 1.0);
+}
@@ -2,14 +2,21 @@
 #include <glad/glad.h>
 #include "GLFW/glfw3.h"
 #include <iostream>
-#include <learnopengl/shader.h>
+#include <learnopengl/shader_library.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/camera_uniforms.h>
+#include <learnopengl/headless.h>
+#include <learnopengl/input_replay.h>
+
+#include <root_directory.h>
 
 unsigned int SCR_WIDTH = 800;
 unsigned int SCR_HEIGHT = 600;
 float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
+// keys and cursor go through it so a session can be recorded and replayed, see headless.h
+InputReplay input;
 
 // timing
 float deltaTime = 0.0f;
@@ -18,6 +25,9 @@ float lastFrame = 0.0f;
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 // lighting
 glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
+// the specular variant of the lighting shader, toggled with S
+bool useSpecular = false;
+bool specularKeyPressed = false;
 
 void
 processKeyboardInputs(GLFWwindow* window);
@@ -29,8 +39,11 @@ void
 framebuffer_size_callback(GLFWwindow* window, int width, int height);
 
 int
-main()
+main(int argc, char** argv)
 {
+	// --frames runs a fixed number of frames with a scripted camera in an invisible window, see headless.h
+	HeadlessRun headless(parse_headless_options(argc, argv));
+
 	// glfw: initialize and configure
 	// ------------------------------
 	glfwInit();
@@ -41,6 +54,7 @@ main()
 #if __APPLE__
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+	headless.apply_window_hints();
 
 	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "learn_opengl:diffuse_light", NULL, NULL);
 	if (window == NULL)
@@ -52,7 +66,9 @@ main()
 
 	// set window callbacks
 	glfwMakeContextCurrent(window);
-	glfwSetCursorPosCallback(window, mouseCursorCallback);
+	input.install(window, mouseCursorCallback, nullptr);
+	if (!headless.configure_input(input))
+		return -1;
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
 	// glad: load all OpenGL function pointers
@@ -115,40 +131,52 @@ main()
 	// configure global opengl state
 	// -----------------------------
 	glEnable(GL_DEPTH_TEST);
-	// process shaders
-	Shader lightingShader("2.1.basic_lighting.vs", "2.1.basic_lighting.fs");
-	Shader lightCubeShader("2.1.light_cube.vs", "2.1.light_cube.fs");
+	// process shaders: both variants of the lighting shader are submitted up front, each compiled with only the
+	// features it uses
+	ShaderLibrary shaders((GLADloadproc)glfwGetProcAddress);
+	shaders.add_include_directory(std::string(logl_root) + "/resources/shaders");
+	shaders.precompile_all("2.1.basic_lighting.vs", "2.1.basic_lighting.fs", {{}, {{"USE_SPECULAR", ""}}});
+	Shader& lightCubeShader = shaders.get("2.1.light_cube.vs", "2.1.light_cube.fs");
+
+	// every program reads the camera from one buffer, updated once per frame
+	CameraUniforms cameraUniforms;
+	CameraUniforms::bind_program(shaders.get("2.1.basic_lighting.vs", "2.1.basic_lighting.fs").ID);
+	CameraUniforms::bind_program(
+		shaders.get("2.1.basic_lighting.vs", "2.1.basic_lighting.fs", {{"USE_SPECULAR", ""}}).ID);
+	CameraUniforms::bind_program(lightCubeShader.ID);
 
 	while (!glfwWindowShouldClose(window))
 	{
 		// per-frame time logic
 		// --------------------
 		float currentFrame = static_cast<float>(glfwGetTime());
-		deltaTime = currentFrame - lastFrame;
+		deltaTime = input.begin_frame(window, headless.frame_delta(currentFrame - lastFrame));
 		lastFrame = currentFrame;
 
 		// input
 		// -----
 		processKeyboardInputs(window);
+		headless.move_camera(camera, deltaTime);
+		input.update_camera(camera);
 
 		// render
 		// ------
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+		// view/projection transformations, and the camera position of the specular term
+		cameraUniforms.update(camera, SCR_WIDTH, SCR_HEIGHT, currentFrame, deltaTime);
+
 		// be sure to activate shader when setting uniforms/drawing objects
+		Shader& lightingShader = shaders.get(
+			"2.1.basic_lighting.vs",
+			"2.1.basic_lighting.fs",
+			useSpecular ? ShaderDefines{{"USE_SPECULAR", ""}} : ShaderDefines{});
 		lightingShader.use();
 		lightingShader.setVec3("objectColor", 1.0f, 0.5f, 0.31f);
 		lightingShader.setVec3("lightColor", 1.0f, 1.0f, 1.0f);
 		lightingShader.setVec3("lightPos", lightPos);
 
-		// view/projection transformations
-		glm::mat4 projection =
-			glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-		glm::mat4 view = camera.GetViewMatrix();
-		lightingShader.setMat4("projection", projection);
-		lightingShader.setMat4("view", view);
-
 		// world transformation
 		glm::mat4 model = glm::mat4(1.0f);
 		lightingShader.setMat4("model", model);
@@ -159,8 +187,6 @@ main()
 
 		// also draw the lamp object
 		lightCubeShader.use();
-		lightCubeShader.setMat4("projection", projection);
-		lightCubeShader.setMat4("view", view);
 		model = glm::mat4(1.0f);
 		model = glm::translate(model, lightPos);
 		model = glm::scale(model, glm::vec3(0.2f)); // a smaller cube
@@ -168,6 +194,7 @@ main()
 
 		glBindVertexArray(lightCubeVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 36);
+		headless.end_frame(window);
 
 		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
 		// -------------------------------------------------------------------------------
@@ -184,7 +211,7 @@ main()
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
 	glfwTerminate();
-	return 0;
+	return headless.exit_code();
 }
 
 void
@@ -194,6 +221,16 @@ processKeyboardInputs(GLFWwindow* window)
 	{
 		glfwSetWindowShouldClose(window, true);
 	}
+
+	if (input.get_key(window, GLFW_KEY_S) == GLFW_PRESS && !specularKeyPressed)
+	{
+		useSpecular = !useSpecular;
+		specularKeyPressed = true;
+	}
+	if (input.get_key(window, GLFW_KEY_S) == GLFW_RELEASE)
+	{
+		specularKeyPressed = false;
+	}
 }
 
 void
@@ -0,0 +1,45 @@
+#version 430 core
+out vec4 FragColor;
+
+in vec3 Normal;
+in vec3 FragPos;
+
+#include "clusters.glsl"
+#include "lighting.glsl"
+
+uniform vec3 objectColor;
+// colors every cluster by the length of its list instead of lighting it
+uniform bool showHeatmap;
+
+vec3 heat(float t)
+{
+    // blue for empty lists, green half full, red full
+    return vec3(clamp(2.0 * t - 1.0, 0.0, 1.0), 1.0 - abs(2.0 * t - 1.0), clamp(1.0 - 2.0 * t, 0.0, 1.0));
+}
+
+void main()
+{
+    vec3 norm = normalize(Normal);
+    float depth = -(camera.view * vec4(FragPos, 1.0)).z;
+    uvec2 range = lightGrid[cluster_index(gl_FragCoord.xy, depth)];
+
+    // only the lights of the cluster of the fragment
+    vec3 light = ambient_term(0.02, vec3(1.0));
+    for (uint i = 0; i < range.y; ++i)
+    {
+        PointLight pointLight = lights[lightIndices[range.x + i]];
+        vec3 toLight = pointLight.position.xyz - FragPos;
+        float lightDistance = length(toLight);
+        // inverse square, windowed to reach zero at the radius the light was culled with
+        float window = clamp(1.0 - pow(lightDistance / pointLight.position.w, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (lightDistance * lightDistance + 1.0);
+        light += diffuse_term(norm, toLight / lightDistance, pointLight.color.rgb) * attenuation;
+    }
+    vec3 result = light * objectColor;
+    // reinhard, thousands of lights add up
+    result = result / (result + vec3(1.0));
+
+    if (showHeatmap)
+        result = mix(result, heat(float(range.y) / float(MAX_LIGHTS_PER_CLUSTER)), 0.75);
+    FragColor = vec4(result, 1.0);
+}
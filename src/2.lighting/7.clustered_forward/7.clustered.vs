@@ -0,0 +1,21 @@
+#version 430 core
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+
+out vec3 FragPos;
+out vec3 Normal;
+
+#include "camera.glsl"
+
+uniform mat4 model;
+// the instances are laid out on a gridSize x gridSize grid, spacing apart and centered on the origin
+uniform int gridSize;
+uniform float spacing;
+
+void main() {
+    vec2 cell = vec2(gl_InstanceID % gridSize, gl_InstanceID / gridSize) - 0.5 * float(gridSize - 1);
+    FragPos = vec3(model * vec4(aPos, 1.0)) + vec3(cell.x, 0.0, cell.y) * spacing;
+    Normal = aNormal;
+
+    gl_Position = camera.view_projection * vec4(FragPos, 1.0);
+}
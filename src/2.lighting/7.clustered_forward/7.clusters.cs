@@ -0,0 +1,37 @@
+#version 430 core
+layout(local_size_x = 64) in;
+
+#include "clusters.glsl"
+
+// the view space point of the far plane seen through a screen position, uv in [0, 1]
+vec3 view_ray(vec2 uv)
+{
+	vec4 point = camera.inverse_projection * vec4(uv * 2.0 - 1.0, 1.0, 1.0);
+	return point.xyz / point.w;
+}
+
+// bounds of every cluster, only rebuilt when the projection changes
+void main()
+{
+	uint index = gl_GlobalInvocationID.x;
+	if (index >= uint(CLUSTER_X * CLUSTER_Y * CLUSTER_Z))
+		return;
+	uvec3 cluster = uvec3(index % CLUSTER_X, index / CLUSTER_X % CLUSTER_Y, index / (CLUSTER_X * CLUSTER_Y));
+
+	float near_depth = slice_depth(cluster.z);
+	float far_depth = slice_depth(cluster.z + 1);
+	vec3 lo = vec3(1e30);
+	vec3 hi = vec3(-1e30);
+	// the corners of the tile on the near and the far plane of the slice
+	for (uint corner = 0; corner < 4; ++corner)
+	{
+		vec2 uv = (vec2(cluster.xy) + vec2(corner & 1u, corner >> 1)) / vec2(CLUSTER_X, CLUSTER_Y);
+		vec3 ray = view_ray(uv);
+		vec3 near_corner = ray * (near_depth / -ray.z);
+		vec3 far_corner = ray * (far_depth / -ray.z);
+		lo = min(lo, min(near_corner, far_corner));
+		hi = max(hi, max(near_corner, far_corner));
+	}
+	clusterBounds[2 * index] = vec4(lo, 0.0);
+	clusterBounds[2 * index + 1] = vec4(hi, 0.0);
+}
@@ -0,0 +1,50 @@
+#version 430 core
+// one invocation per cluster, a work group covers CULL_SLICES depth slices of the whole screen
+layout(local_size_x = CLUSTER_X, local_size_y = CLUSTER_Y, local_size_z = CULL_SLICES) in;
+
+#include "clusters.glsl"
+
+#define BATCH_SIZE (CLUSTER_X * CLUSTER_Y * CULL_SLICES)
+
+uniform int lightCount;
+
+// the lights are loaded batch after batch, each invocation of the group loading one, and tested from shared memory
+shared vec4 batch[BATCH_SIZE];
+
+bool intersects(vec4 light, vec3 lo, vec3 hi)
+{
+	vec3 offset = clamp(light.xyz, lo, hi) - light.xyz;
+	return dot(offset, offset) <= light.w * light.w;
+}
+
+void main()
+{
+	uint index = gl_LocalInvocationIndex + gl_WorkGroupID.z * BATCH_SIZE;
+	vec3 lo = clusterBounds[2 * index].xyz;
+	vec3 hi = clusterBounds[2 * index + 1].xyz;
+
+	uint visible[MAX_LIGHTS_PER_CLUSTER];
+	uint count = 0;
+	for (uint base = 0; base < uint(lightCount); base += BATCH_SIZE)
+	{
+		uint light = base + gl_LocalInvocationIndex;
+		if (light < uint(lightCount))
+			batch[gl_LocalInvocationIndex] = viewLights[light];
+		barrier();
+		uint batch_count = min(uint(BATCH_SIZE), uint(lightCount) - base);
+		for (uint i = 0; i < batch_count && count < MAX_LIGHTS_PER_CLUSTER; ++i)
+		{
+			if (intersects(batch[i], lo, hi))
+				visible[count++] = base + i;
+		}
+		barrier();
+	}
+
+	// one allocation per cluster, what does not fit anymore is dropped
+	uint offset = atomicAdd(lightIndexCount, count);
+	uint capacity = uint(lightIndices.length());
+	count = offset < capacity ? min(count, capacity - offset) : 0;
+	for (uint i = 0; i < count; ++i)
+		lightIndices[offset + i] = visible[i];
+	lightGrid[index] = uvec2(offset, count);
+}
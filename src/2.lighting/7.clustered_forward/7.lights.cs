@@ -0,0 +1,28 @@
+#version 430 core
+layout(local_size_x = 256) in;
+
+#include "clusters.glsl"
+
+// where every light circles around, position.w its radius and color.w its speed
+layout(std430, binding = 5) readonly buffer LightOrigins
+{
+	PointLight origins[];
+};
+
+uniform int lightCount;
+// shrinks the lights as their number grows, so the lists per cluster stay about as long
+uniform float radiusScale;
+
+void main()
+{
+	uint index = gl_GlobalInvocationID.x;
+	if (index >= uint(lightCount))
+		return;
+
+	PointLight origin = origins[index];
+	float t = camera.time.x * origin.color.w + float(index);
+	vec3 position = origin.position.xyz + vec3(cos(t), 0.25 * sin(2.0 * t), sin(t));
+	float radius = origin.position.w * radiusScale;
+	lights[index] = PointLight(vec4(position, radius), vec4(origin.color.rgb * radiusScale * radiusScale, 0.0));
+	viewLights[index] = vec4((camera.view * vec4(position, 1.0)).xyz, radius);
+}
@@ -0,0 +1,456 @@
+#include <glad/glad.h>
+#include "GLFW/glfw3.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <learnopengl/shader_library.h>
+#include <learnopengl/shader_c.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/camera_uniforms.h>
+#include <learnopengl/dynamic_resolution.h>
+#include <learnopengl/headless.h>
+#include <learnopengl/input_replay.h>
+
+#include <root_directory.h>
+
+unsigned int SCR_WIDTH = 1280;
+unsigned int SCR_HEIGHT = 720;
+float lastX = SCR_WIDTH / 2.0f;
+float lastY = SCR_HEIGHT / 2.0f;
+bool firstMouse = true;
+// keys and cursor go through it so a session can be recorded and replayed, see headless.h
+InputReplay input;
+
+// current framebuffer size, the clusters are found from the fragment position in it
+int framebufferWidth = SCR_WIDTH;
+int framebufferHeight = SCR_HEIGHT;
+
+// timing
+float deltaTime = 0.0f;
+float lastFrame = 0.0f;
+// camera
+Camera camera(glm::vec3(0.0f, 8.0f, 40.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, -15.0f);
+const float NEAR_PLANE = 0.1f;
+const float FAR_PLANE = 150.0f;
+
+// the cluster grid: 16 x 9 tiles on screen and 24 depth slices. The culling pass processes CULL_SLICES slices per
+// work group and keeps at most MAX_LIGHTS_PER_CLUSTER lights per cluster
+const unsigned int CLUSTER_X = 16;
+const unsigned int CLUSTER_Y = 9;
+const unsigned int CLUSTER_Z = 24;
+const unsigned int CULL_SLICES = 4;
+const unsigned int CLUSTER_COUNT = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+const unsigned int MAX_LIGHTS_PER_CLUSTER = 128;
+// room for 64 lights per cluster on average across all the lists
+const unsigned int LIGHT_INDEX_CAPACITY = CLUSTER_COUNT * 64;
+
+// lights, doubled and halved with up and down
+const unsigned int MIN_LIGHTS = 256;
+const unsigned int MAX_LIGHTS = 65536;
+unsigned int lightCount = 8192;
+bool lightKeyPressed = false;
+// H shows how many lights every cluster got
+bool showHeatmap = false;
+bool heatmapKeyPressed = false;
+
+// the scene: a grid of pillars on a floor, the lights move between them
+const int PILLAR_GRID = 32;
+const float PILLAR_SPACING = 2.0f;
+
+// as clusters.glsl lays out a light in its std430 buffers
+struct PointLight
+{
+	glm::vec4 position;
+	glm::vec4 color;
+};
+
+void
+processKeyboardInputs(GLFWwindow* window);
+
+void
+mouseCursorCallback(GLFWwindow* window, double xpos, double ypos);
+
+void
+framebuffer_size_callback(GLFWwindow* window, int width, int height);
+
+std::vector<PointLight>
+createLightOrigins();
+
+int
+main(int argc, char** argv)
+{
+	// --frames runs a fixed number of frames with a scripted camera in an invisible window, see headless.h
+	HeadlessRun headless(parse_headless_options(argc, argv));
+
+	// glfw: initialize and configure
+	// ------------------------------
+	glfwInit();
+	// shader storage buffers and compute shaders are core since 4.3, which macOS does not provide
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	headless.apply_window_hints();
+
+	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "learn_opengl:clustered_forward", NULL, NULL);
+	if (window == NULL)
+	{
+		std::cout << "glfw: failed to create window, an OpenGL 4.3 context is required!\n";
+		glfwTerminate();
+		return -1;
+	}
+
+	// set window callbacks
+	glfwMakeContextCurrent(window);
+	input.install(window, mouseCursorCallback, nullptr);
+	if (!headless.configure_input(input))
+		return -1;
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+
+	// tell GLFW to capture our mouse
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+	// glad: load all OpenGL function pointers
+	// ---------------------------------------
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return -1;
+	}
+
+	// set up vertex data (and buffer(s)) and configure vertex attributes
+	// ------------------------------------------------------------------
+	float vertices[] = {-0.5f, -0.5f, -0.5f, 0.0f,	0.0f,  -1.0f, 0.5f,	 -0.5f, -0.5f, 0.0f,  0.0f,	 -1.0f,
+						0.5f,  0.5f,  -0.5f, 0.0f,	0.0f,  -1.0f, 0.5f,	 0.5f,	-0.5f, 0.0f,  0.0f,	 -1.0f,
+						-0.5f, 0.5f,  -0.5f, 0.0f,	0.0f,  -1.0f, -0.5f, -0.5f, -0.5f, 0.0f,  0.0f,	 -1.0f,
+
+						-0.5f, -0.5f, 0.5f,	 0.0f,	0.0f,  1.0f,  0.5f,	 -0.5f, 0.5f,  0.0f,  0.0f,	 1.0f,
+						0.5f,  0.5f,  0.5f,	 0.0f,	0.0f,  1.0f,  0.5f,	 0.5f,	0.5f,  0.0f,  0.0f,	 1.0f,
+						-0.5f, 0.5f,  0.5f,	 0.0f,	0.0f,  1.0f,  -0.5f, -0.5f, 0.5f,  0.0f,  0.0f,	 1.0f,
+
+						-0.5f, 0.5f,  0.5f,	 -1.0f, 0.0f,  0.0f,  -0.5f, 0.5f,	-0.5f, -1.0f, 0.0f,	 0.0f,
+						-0.5f, -0.5f, -0.5f, -1.0f, 0.0f,  0.0f,  -0.5f, -0.5f, -0.5f, -1.0f, 0.0f,	 0.0f,
+						-0.5f, -0.5f, 0.5f,	 -1.0f, 0.0f,  0.0f,  -0.5f, 0.5f,	0.5f,  -1.0f, 0.0f,	 0.0f,
+
+						0.5f,  0.5f,  0.5f,	 1.0f,	0.0f,  0.0f,  0.5f,	 0.5f,	-0.5f, 1.0f,  0.0f,	 0.0f,
+						0.5f,  -0.5f, -0.5f, 1.0f,	0.0f,  0.0f,  0.5f,	 -0.5f, -0.5f, 1.0f,  0.0f,	 0.0f,
+						0.5f,  -0.5f, 0.5f,	 1.0f,	0.0f,  0.0f,  0.5f,	 0.5f,	0.5f,  1.0f,  0.0f,	 0.0f,
+
+						-0.5f, -0.5f, -0.5f, 0.0f,	-1.0f, 0.0f,  0.5f,	 -0.5f, -0.5f, 0.0f,  -1.0f, 0.0f,
+						0.5f,  -0.5f, 0.5f,	 0.0f,	-1.0f, 0.0f,  0.5f,	 -0.5f, 0.5f,  0.0f,  -1.0f, 0.0f,
+						-0.5f, -0.5f, 0.5f,	 0.0f,	-1.0f, 0.0f,  -0.5f, -0.5f, -0.5f, 0.0f,  -1.0f, 0.0f,
+
+						-0.5f, 0.5f,  -0.5f, 0.0f,	1.0f,  0.0f,  0.5f,	 0.5f,	-0.5f, 0.0f,  1.0f,	 0.0f,
+						0.5f,  0.5f,  0.5f,	 0.0f,	1.0f,  0.0f,  0.5f,	 0.5f,	0.5f,  0.0f,  1.0f,	 0.0f,
+						-0.5f, 0.5f,  0.5f,	 0.0f,	1.0f,  0.0f,  -0.5f, 0.5f,	-0.5f, 0.0f,  1.0f,	 0.0f};
+
+	// upload gpu
+	unsigned int VBO, cubeVAO;
+	glGenVertexArrays(1, &cubeVAO);
+	glBindVertexArray(cubeVAO);
+
+	glGenBuffers(1, &VBO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+
+	// the shader storage buffers of clusters.glsl, at their bindings; all sized for the most lights
+	// ---------------------------------------------------------------------------------------------
+	const std::vector<PointLight> lightOrigins = createLightOrigins();
+	const GLsizeiptr bufferSizes[] = {
+		GLsizeiptr(CLUSTER_COUNT * 2 * sizeof(glm::vec4)),
+		GLsizeiptr(MAX_LIGHTS * sizeof(PointLight)),
+		GLsizeiptr(MAX_LIGHTS * sizeof(glm::vec4)),
+		GLsizeiptr(CLUSTER_COUNT * 2 * sizeof(unsigned int)),
+		GLsizeiptr((1 + LIGHT_INDEX_CAPACITY) * sizeof(unsigned int)),
+		GLsizeiptr(MAX_LIGHTS * sizeof(PointLight))};
+	const void* bufferData[] = {nullptr, nullptr, nullptr, nullptr, nullptr, lightOrigins.data()};
+	unsigned int storageBuffers[6];
+	glGenBuffers(6, storageBuffers);
+	for (unsigned int i = 0; i < 6; ++i)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, storageBuffers[i]);
+		glBufferData(
+			GL_SHADER_STORAGE_BUFFER, bufferSizes[i], bufferData[i], bufferData[i] ? GL_STATIC_DRAW : GL_DYNAMIC_COPY);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, storageBuffers[i]);
+	}
+	const unsigned int lightIndexBuffer = storageBuffers[4];
+
+	// configure global opengl state
+	// -----------------------------
+	glEnable(GL_DEPTH_TEST);
+
+	// process shaders: the grid size goes into every stage as defines, so the shaders and the buffers always agree
+	ShaderDefines clusterDefines = {
+		{"CLUSTER_X", std::to_string(CLUSTER_X)},
+		{"CLUSTER_Y", std::to_string(CLUSTER_Y)},
+		{"CLUSTER_Z", std::to_string(CLUSTER_Z)},
+		{"CULL_SLICES", std::to_string(CULL_SLICES)},
+		{"MAX_LIGHTS_PER_CLUSTER", std::to_string(MAX_LIGHTS_PER_CLUSTER)}};
+	ShaderLibrary shaders((GLADloadproc)glfwGetProcAddress);
+	shaders.add_include_directory(std::string(logl_root) + "/resources/shaders");
+	Shader& lightingShader = shaders.get("7.clustered.vs", "7.clustered.fs", clusterDefines);
+
+	ShaderPreprocessor preprocessor;
+	preprocessor.add_include_directory(std::string(logl_root) + "/resources/shaders");
+	ComputeShader clusterShader = ComputeShader::fromSource(preprocessor.process("7.clusters.cs", clusterDefines).code);
+	ComputeShader lightShader = ComputeShader::fromSource(preprocessor.process("7.lights.cs", clusterDefines).code);
+	ComputeShader cullingShader =
+		ComputeShader::fromSource(preprocessor.process("7.light_culling.cs", clusterDefines).code);
+
+	// every program reads the camera from one buffer, updated once per frame
+	CameraUniforms cameraUniforms;
+	CameraUniforms::bind_program(lightingShader.ID);
+	CameraUniforms::bind_program(clusterShader.ID);
+	CameraUniforms::bind_program(lightShader.ID);
+	CameraUniforms::bind_program(cullingShader.ID);
+
+	// the GPU time of the compute passes, read back a few frames later without waiting for the GPU
+	GpuTimer cullingTimer;
+	uint64_t frameIndex = 0;
+	glm::mat4 clusterProjection(0.0f);
+	double cullingMsSum = 0.0;
+	int cullingSamples = 0;
+	int frameCount = 0;
+	float lastTitleTime = 0.0f;
+
+	while (!glfwWindowShouldClose(window))
+	{
+		// per-frame time logic
+		// --------------------
+		float currentFrame = static_cast<float>(glfwGetTime());
+		deltaTime = input.begin_frame(window, headless.frame_delta(currentFrame - lastFrame));
+		lastFrame = currentFrame;
+
+		// input
+		// -----
+		processKeyboardInputs(window);
+		headless.move_camera(camera, deltaTime);
+		input.update_camera(camera);
+
+		// nothing to draw while minimized
+		if (framebufferWidth == 0 || framebufferHeight == 0)
+		{
+			glfwPollEvents();
+			continue;
+		}
+
+		// the lights move with the time, a headless run counts it in frames
+		cameraUniforms.update(
+			camera,
+			framebufferWidth,
+			framebufferHeight,
+			headless.frame_time(currentFrame),
+			deltaTime,
+			NEAR_PLANE,
+			FAR_PLANE);
+
+		// assign the lights to the clusters
+		// ---------------------------------
+		cullingTimer.begin(frameIndex);
+		// the bounds of the clusters only depend on the projection
+		if (cameraUniforms.get_data().projection != clusterProjection)
+		{
+			clusterProjection = cameraUniforms.get_data().projection;
+			clusterShader.use();
+			glDispatchCompute((CLUSTER_COUNT + 63) / 64, 1, 1);
+		}
+
+		// move the lights, and bring them to view space for the culling
+		const float radiusScale = std::sqrt(8192.0f / float(lightCount));
+		lightShader.use();
+		lightShader.setInt("lightCount", lightCount);
+		lightShader.setFloat("radiusScale", radiusScale);
+		glDispatchCompute((lightCount + 255) / 256, 1, 1);
+
+		// reset the allocation counter of the index lists
+		const unsigned int zero = 0;
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightIndexBuffer);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), &zero);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		cullingShader.use();
+		cullingShader.setInt("lightCount", lightCount);
+		glDispatchCompute(1, 1, CLUSTER_Z / CULL_SLICES);
+		// the lists are read by the fragment shader, and the counter is reset by the next frame
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+		cullingTimer.end();
+
+		double measuredMs;
+		uint64_t measuredFrame;
+		while (cullingTimer.poll(measuredMs, measuredFrame))
+		{
+			cullingMsSum += measuredMs;
+			++cullingSamples;
+		}
+		++frameIndex;
+		++frameCount;
+
+		// render
+		// ------
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		lightingShader.use();
+		lightingShader.setBool("showHeatmap", showHeatmap);
+		glBindVertexArray(cubeVAO);
+
+		// the floor
+		glm::mat4 model = glm::mat4(1.0f);
+		model = glm::translate(model, glm::vec3(0.0f, -0.05f, 0.0f));
+		const float floorSize = PILLAR_GRID * PILLAR_SPACING + 8.0f;
+		model = glm::scale(model, glm::vec3(floorSize, 0.1f, floorSize));
+		lightingShader.setMat4("model", model);
+		lightingShader.setInt("gridSize", 1);
+		lightingShader.setFloat("spacing", 0.0f);
+		lightingShader.setVec3("objectColor", 0.8f, 0.8f, 0.8f);
+		glDrawArrays(GL_TRIANGLES, 0, 36);
+
+		// the pillars, in one instanced draw
+		model = glm::mat4(1.0f);
+		model = glm::translate(model, glm::vec3(0.0f, 1.5f, 0.0f));
+		model = glm::scale(model, glm::vec3(0.5f, 3.0f, 0.5f));
+		lightingShader.setMat4("model", model);
+		lightingShader.setInt("gridSize", PILLAR_GRID);
+		lightingShader.setFloat("spacing", PILLAR_SPACING);
+		lightingShader.setVec3("objectColor", 1.0f, 0.5f, 0.31f);
+		glDrawArraysInstanced(GL_TRIANGLES, 0, 36, PILLAR_GRID * PILLAR_GRID);
+		headless.end_frame(window);
+
+		// light count and timings in the title, once a second
+		if (currentFrame - lastTitleTime >= 1.0f)
+		{
+			const double cullingMs = cullingMsSum / std::max(cullingSamples, 1);
+			const std::string title = "learn_opengl:clustered_forward - " + std::to_string(lightCount) + " lights, " +
+									  std::to_string(1000.0f * (currentFrame - lastTitleTime) / frameCount) +
+									  " ms/frame, culling " + std::to_string(cullingMs) + " ms";
+			glfwSetWindowTitle(window, title.c_str());
+			lastTitleTime = currentFrame;
+			cullingMsSum = 0.0;
+			cullingSamples = 0;
+			frameCount = 0;
+		}
+
+		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+		// -------------------------------------------------------------------------------
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+	}
+
+	// optional: de-allocate all resources once they've outlived their purpose:
+	// ------------------------------------------------------------------------
+	glDeleteVertexArrays(1, &cubeVAO);
+	glDeleteBuffers(1, &VBO);
+	glDeleteBuffers(6, storageBuffers);
+
+	// glfw: terminate, clearing all previously allocated GLFW resources.
+	// ------------------------------------------------------------------
+	glfwTerminate();
+	return headless.exit_code();
+}
+
+// the lights circle around random points above the floor, with random colors, sizes and speeds
+std::vector<PointLight>
+createLightOrigins()
+{
+	std::mt19937 generator(1337);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	const float extent = 0.5f * PILLAR_GRID * PILLAR_SPACING;
+	std::vector<PointLight> origins(MAX_LIGHTS);
+	for (PointLight& origin : origins)
+	{
+		origin.position = glm::vec4(
+			(unit(generator) * 2.0f - 1.0f) * extent,
+			0.3f + unit(generator) * 3.0f,
+			(unit(generator) * 2.0f - 1.0f) * extent,
+			1.5f + unit(generator) * 1.5f);
+		// a saturated hue, the speed of the light in w
+		const glm::vec3 hue = glm::clamp(
+			glm::abs(glm::mod(unit(generator) * 6.0f + glm::vec3(0.0f, 4.0f, 2.0f), 6.0f) - 3.0f) - 1.0f,
+			0.0f,
+			1.0f);
+		origin.color = glm::vec4(hue * 2.0f, 0.2f + unit(generator) * 0.8f);
+	}
+	return origins;
+}
+
+void
+processKeyboardInputs(GLFWwindow* window)
+{
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+	{
+		glfwSetWindowShouldClose(window, true);
+	}
+
+	if (input.get_key(window, GLFW_KEY_W) == GLFW_PRESS)
+		camera.ProcessKeyboard(FORWARD, deltaTime * 20.0f);
+	if (input.get_key(window, GLFW_KEY_S) == GLFW_PRESS)
+		camera.ProcessKeyboard(BACKWARD, deltaTime * 20.0f);
+	if (input.get_key(window, GLFW_KEY_A) == GLFW_PRESS)
+		camera.ProcessKeyboard(LEFT, deltaTime * 20.0f);
+	if (input.get_key(window, GLFW_KEY_D) == GLFW_PRESS)
+		camera.ProcessKeyboard(RIGHT, deltaTime * 20.0f);
+
+	if (input.get_key(window, GLFW_KEY_UP) == GLFW_PRESS && !lightKeyPressed)
+	{
+		lightCount = std::min(lightCount * 2, MAX_LIGHTS);
+		lightKeyPressed = true;
+	}
+	if (input.get_key(window, GLFW_KEY_DOWN) == GLFW_PRESS && !lightKeyPressed)
+	{
+		lightCount = std::max(lightCount / 2, MIN_LIGHTS);
+		lightKeyPressed = true;
+	}
+	if (input.get_key(window, GLFW_KEY_UP) == GLFW_RELEASE && input.get_key(window, GLFW_KEY_DOWN) == GLFW_RELEASE)
+	{
+		lightKeyPressed = false;
+	}
+
+	if (input.get_key(window, GLFW_KEY_H) == GLFW_PRESS && !heatmapKeyPressed)
+	{
+		showHeatmap = !showHeatmap;
+		heatmapKeyPressed = true;
+	}
+	if (input.get_key(window, GLFW_KEY_H) == GLFW_RELEASE)
+	{
+		heatmapKeyPressed = false;
+	}
+}
+
+void
+mouseCursorCallback(GLFWwindow* window, double xposIn, double yposIn)
+{
+	float xpos = static_cast<float>(xposIn);
+	float ypos = static_cast<float>(yposIn);
+
+	if (firstMouse)
+	{
+		lastX = xpos;
+		lastY = ypos;
+		firstMouse = false;
+	}
+
+	float xoffset = xpos - lastX;
+	float yoffset = lastY - ypos; // reversed since y-coordinates go from bottom to top
+
+	lastX = xpos;
+	lastY = ypos;
+
+	camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+void
+framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+	glViewport(0, 0, width, height);
+	framebufferWidth = width;
+	framebufferHeight = height;
+}
@@ -41,6 +41,8 @@
 #include <GLFW/glfw3.h>
 #include <cstddef>
 #include <learnopengl/shader.h>
+#include <learnopengl/headless.h>
+#include <learnopengl/input_replay.h>
 #include <stb_image.h>
 
 // window sizing
@@ -52,6 +54,9 @@ Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 float lastX = (float)SCR_WIDTH / 2.0;
 float lastY = (float)SCR_HEIGHT / 2.0;
 bool firstMouse = true;
+// keys, cursor and scroll go through it so a session can be recorded and
+// replayed, see headless.h
+InputReplay input;
 
 // timing
 float deltaTime = 0.0f;
@@ -63,7 +68,11 @@ void scroll_callback(GLFWwindow *window, double xoffset, double yoffset);
 void process_input(GLFWwindow *window);
 unsigned int load_texture(const char *path);
 
-int main() {
+int main(int argc, char **argv) {
+  // --frames runs a fixed number of frames with a scripted camera in an
+  // invisible window, see headless.h
+  HeadlessRun headless(parse_headless_options(argc, argv));
+
   // glfw: initialize and configure
   // ------------------------------
   glfwInit();
@@ -74,6 +83,7 @@ int main() {
 #ifdef __APPLE__
   glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+  headless.apply_window_hints();
 
   // glfw window creation
   // --------------------
@@ -88,8 +98,9 @@ int main() {
 
   glfwMakeContextCurrent(window);
   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-  glfwSetCursorPosCallback(window, mouse_callback);
-  glfwSetScrollCallback(window, scroll_callback);
+  input.install(window, mouse_callback, scroll_callback);
+  if (!headless.configure_input(input))
+    return -1;
 
   // tell GLFW to capture our mouse;
   glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -192,12 +203,15 @@ int main() {
     // per-frame time logic
     // --------------------
     float currentFrame = static_cast<float>(glfwGetTime());
-    deltaTime = currentFrame - lastFrame;
+    deltaTime = input.begin_frame(
+        window, headless.frame_delta(currentFrame - lastFrame));
     lastFrame = currentFrame;
 
     // input
     // -----
     process_input(window);
+    headless.move_camera(camera, deltaTime);
+    input.update_camera(camera);
 
     // render
     // ------
@@ -229,6 +243,7 @@ int main() {
     shader.setMat4("model", glm::mat4(1.0f));
     glDrawArrays(GL_TRIANGLES, 0, 6);
     glBindVertexArray(0);
+    headless.end_frame(window);
 
     // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved
     // etc.)
@@ -245,7 +260,7 @@ int main() {
   glDeleteBuffers(1, &planeVBO);
 
   glfwTerminate();
-  return 0;
+  return headless.exit_code();
 }
 
 // process all input: query GLFW whether relevant keys are pressed/released this
@@ -255,13 +270,13 @@ void process_input(GLFWwindow *window) {
   if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
     glfwSetWindowShouldClose(window, true);
 
-  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+  if (input.get_key(window, GLFW_KEY_W) == GLFW_PRESS)
     camera.ProcessKeyboard(FORWARD, deltaTime);
-  if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+  if (input.get_key(window, GLFW_KEY_S) == GLFW_PRESS)
     camera.ProcessKeyboard(BACKWARD, deltaTime);
-  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+  if (input.get_key(window, GLFW_KEY_A) == GLFW_PRESS)
     camera.ProcessKeyboard(LEFT, deltaTime);
-  if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+  if (input.get_key(window, GLFW_KEY_D) == GLFW_PRESS)
     camera.ProcessKeyboard(RIGHT, deltaTime);
 }
 
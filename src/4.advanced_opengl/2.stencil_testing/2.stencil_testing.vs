@@ -4,11 +4,11 @@ layout(location = 1) in vec2 aTexCoords;
 
 out vec2 TexCoords;
 
+#include "camera.glsl"
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main() {
     TexCoords = aTexCoords;
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-}
\ No newline at end of file
+    gl_Position = camera.view_projection * model * vec4(aPos, 1.0);
+}
@@ -5,7 +5,12 @@
 
 #include <stb_image.h>
 #include <learnopengl/camera.h>
-#include <learnopengl/shader.h>
+#include <learnopengl/camera_uniforms.h>
+#include <learnopengl/shader_library.h>
+#include <learnopengl/headless.h>
+#include <learnopengl/input_replay.h>
+
+#include <root_directory.h>
 
 // General program data
 // window size
@@ -18,6 +23,8 @@ float lastY = (float)WINDOW_HEIGHT / 2.0;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 bool firstMouse = true;
+// keys, cursor and scroll go through it so a session can be recorded and replayed, see headless.h
+InputReplay input;
 // camera
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 
@@ -35,8 +42,11 @@ unsigned int
 load_texture(const char* path);
 
 int
-main()
+main(int argc, char** argv)
 {
+	// --frames runs a fixed number of frames with a scripted camera in an invisible window, see headless.h
+	HeadlessRun headless(parse_headless_options(argc, argv));
+
 	// step1 - Window Creation using windowing system
 	//------------------------------------------------
 	// Init GLFW
@@ -50,6 +60,7 @@ main()
 #ifdef __APPLE__
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+	headless.apply_window_hints();
 
 	// create window
 	//--------------
@@ -65,8 +76,9 @@ main()
 
 	// Register CallBack
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-	glfwSetCursorPosCallback(window, mouse_callback);
-	glfwSetScrollCallback(window, scroll_callback);
+	input.install(window, mouse_callback, scroll_callback);
+	if (!headless.configure_input(input))
+		return -1;
 
 	// step2- Load opengl functions using GLAD
 	//------------------------------------------------------
@@ -138,8 +150,15 @@ main()
 
 	// step3 -- Load and compile shaders
 	//----------------------------------
-	Shader shader("2.stencil_testing.vs", "2.stencil_testing.fs");
-	Shader shaderSingleColor("2.stencil_testing.vs", "2.stencil_single_color.fs");
+	ShaderLibrary shaders((GLADloadproc)glfwGetProcAddress);
+	shaders.add_include_directory(std::string(logl_root) + "/resources/shaders");
+	Shader& shader = shaders.get("2.stencil_testing.vs", "2.stencil_testing.fs");
+	Shader& shaderSingleColor = shaders.get("2.stencil_testing.vs", "2.stencil_single_color.fs");
+
+	// both programs read view and projection from the same buffer, filled once per frame
+	CameraUniforms cameraUniforms;
+	CameraUniforms::bind_program(shader.ID);
+	CameraUniforms::bind_program(shaderSingleColor.ID);
 
 	// step4 -- Load and bind textures
 	//--------------------------------codec
@@ -160,28 +179,24 @@ main()
 	while (!glfwWindowShouldClose(window))
 	{ // frame timing
 		float currentCurent = static_cast<float>(glfwGetTime());
-		deltaTime = currentCurent - lastFrame;
+		deltaTime = input.begin_frame(window, headless.frame_delta(currentCurent - lastFrame));
+		lastFrame = currentCurent;
 
 		// process inputs
 		//---------------
 		process_input(window);
+		headless.move_camera(camera, deltaTime);
+		input.update_camera(camera);
 
 		// prepare frame
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 		// don't forget to clear the stencil buffer!
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
-		shaderSingleColor.use();
-		glm::mat4 model = glm::mat4(1.0);
-		glm::mat4 view = camera.GetViewMatrix();
-		glm::mat4 projection =
-			glm::perspective(glm::radians(camera.Zoom), (float)(WINDOW_WIDTH) / (float)(WINDOW_HEIGHT), 0.1f, 100.0f);
-		shaderSingleColor.setMat4("view", view);
-		shaderSingleColor.setMat4("projection", projection);
+		cameraUniforms.update(camera, WINDOW_WIDTH, WINDOW_HEIGHT, currentCurent, deltaTime);
 
 		shader.use();
-		shaderSingleColor.setMat4("view", view);
-		shaderSingleColor.setMat4("projection", projection);
+		glm::mat4 model = glm::mat4(1.0);
 
 		// draw floor as normal, but don't write the floor to the stencil buffer, we only care about the containers. We
 		// set its mask to 0x00 to not write to the stencil buffer.
@@ -234,6 +249,7 @@ main()
 		glStencilMask(0xFF);
 		glStencilFunc(GL_ALWAYS, 0, 0xFF);
 		glEnable(GL_DEPTH_TEST);
+		headless.end_frame(window);
 
 		glfwSwapBuffers(window);
 		glfwPollEvents();
@@ -244,7 +260,7 @@ main()
 	glDeleteBuffers(1, &floorVBO);
 	glfwTerminate();
 
-	return 0;
+	return headless.exit_code();
 }
 
 // process all input: query GLFW whether relevant keys are pressed/released this
@@ -256,13 +272,13 @@ process_input(GLFWwindow* window)
 	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
 		glfwSetWindowShouldClose(window, true);
 
-	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+	if (input.get_key(window, GLFW_KEY_W) == GLFW_PRESS)
 		camera.ProcessKeyboard(FORWARD, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+	if (input.get_key(window, GLFW_KEY_S) == GLFW_PRESS)
 		camera.ProcessKeyboard(BACKWARD, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+	if (input.get_key(window, GLFW_KEY_A) == GLFW_PRESS)
 		camera.ProcessKeyboard(LEFT, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+	if (input.get_key(window, GLFW_KEY_D) == GLFW_PRESS)
 		camera.ProcessKeyboard(RIGHT, deltaTime);
 }
 
@@ -9,6 +9,8 @@
 
 #include <learnopengl/camera.h>
 #include <learnopengl/shader_m.h>
+#include <learnopengl/headless.h>
+#include <learnopengl/input_replay.h>
 
 #include <iostream>
 #include <vector>
@@ -28,12 +30,19 @@ Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 float lastX = (float)SCR_WIDTH / 2.0;
 float lastY = (float)SCR_HEIGHT / 2.0;
 bool firstMouse = true;
+// keys, cursor and scroll go through it so a session can be recorded and
+// replayed, see headless.h
+InputReplay input;
 
 // timing
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-int main() {
+int main(int argc, char **argv) {
+  // --frames runs a fixed number of frames with a scripted camera in an
+  // invisible window, see headless.h
+  HeadlessRun headless(parse_headless_options(argc, argv));
+
   // glfw: initialize and configure
   // ------------------------------
   glfwInit();
@@ -44,6 +53,7 @@ int main() {
 #ifdef __APPLE__
   glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+  headless.apply_window_hints();
 
   // glfw window creation
   // --------------------
@@ -56,8 +66,9 @@ int main() {
   }
   glfwMakeContextCurrent(window);
   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-  glfwSetCursorPosCallback(window, mouse_callback);
-  glfwSetScrollCallback(window, scroll_callback);
+  input.install(window, mouse_callback, scroll_callback);
+  if (!headless.configure_input(input))
+    return -1;
 
   // tell GLFW to capture our mouse
   glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -185,12 +196,15 @@ int main() {
     // per-frame time logic
     // --------------------
     float currentFrame = static_cast<float>(glfwGetTime());
-    deltaTime = currentFrame - lastFrame;
+    deltaTime = input.begin_frame(
+        window, headless.frame_delta(currentFrame - lastFrame));
     lastFrame = currentFrame;
 
     // input
     // -----
     processInput(window);
+    headless.move_camera(camera, deltaTime);
+    input.update_camera(camera);
 
     // render
     // ------
@@ -232,6 +246,7 @@ int main() {
       shader.setMat4("model", model);
       glDrawArrays(GL_TRIANGLES, 0, 6);
     }
+    headless.end_frame(window);
 
     // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved
     // etc.)
@@ -248,7 +263,7 @@ int main() {
   glDeleteBuffers(1, &planeVBO);
 
   glfwTerminate();
-  return 0;
+  return headless.exit_code();
 }
 
 // process all input: query GLFW whether relevant keys are pressed/released this
@@ -258,13 +273,13 @@ void processInput(GLFWwindow *window) {
   if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
     glfwSetWindowShouldClose(window, true);
 
-  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+  if (input.get_key(window, GLFW_KEY_W) == GLFW_PRESS)
     camera.ProcessKeyboard(FORWARD, deltaTime);
-  if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+  if (input.get_key(window, GLFW_KEY_S) == GLFW_PRESS)
     camera.ProcessKeyboard(BACKWARD, deltaTime);
-  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+  if (input.get_key(window, GLFW_KEY_A) == GLFW_PRESS)
     camera.ProcessKeyboard(LEFT, deltaTime);
-  if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+  if (input.get_key(window, GLFW_KEY_D) == GLFW_PRESS)
     camera.ProcessKeyboard(RIGHT, deltaTime);
 }
 
@@ -8,10 +8,12 @@
 
 #include <learnopengl/shader_m.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/transparent_queue.h>
+#include <learnopengl/headless.h>
+#include <learnopengl/input_replay.h>
 
 #include <iostream>
 #include <vector>
-#include <map>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -28,13 +30,18 @@ Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 float lastX = (float)SCR_WIDTH / 2.0;
 float lastY = (float)SCR_HEIGHT / 2.0;
 bool firstMouse = true;
+// keys, cursor and scroll go through it so a session can be recorded and replayed, see headless.h
+InputReplay input;
 
 // timing
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-int main()
+int main(int argc, char** argv)
 {
+    // --frames runs a fixed number of frames with a scripted camera in an invisible window, see headless.h
+    HeadlessRun headless(parse_headless_options(argc, argv));
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -45,6 +52,7 @@ int main()
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+    headless.apply_window_hints();
 
     // glfw window creation
     // --------------------
@@ -57,8 +65,9 @@ int main()
     }
     glfwMakeContextCurrent(window);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetScrollCallback(window, scroll_callback);
+    input.install(window, mouse_callback, scroll_callback);
+    if (!headless.configure_input(input))
+        return -1;
 
     // tell GLFW to capture our mouse
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -199,6 +208,9 @@ int main()
         glm::vec3( 0.5f, 0.0f, -0.6f)
     };
 
+    // windows are sorted back to front every frame, every window is kept even at the same distance
+    TransparentQueue transparentQueue;
+
     // shader configuration
     // --------------------
     shader.use();
@@ -211,21 +223,22 @@ int main()
         // per-frame time logic
         // --------------------
         float currentFrame = static_cast<float>(glfwGetTime());
-        deltaTime = currentFrame - lastFrame;
+        deltaTime = input.begin_frame(window, headless.frame_delta(currentFrame - lastFrame));
         lastFrame = currentFrame;
 
         // input
         // -----
         processInput(window);
+        headless.move_camera(camera, deltaTime);
+        input.update_camera(camera);
 
         // sort the transparent windows before rendering
         // ---------------------------------------------
-        std::map<float, glm::vec3> sorted;
+        glm::mat4 view = camera.GetViewMatrix();
+        transparentQueue.clear();
         for (unsigned int i = 0; i < windows.size(); i++)
-        {
-            float distance = glm::length(camera.Position - windows[i]);
-            sorted[distance] = windows[i];
-        }
+            transparentQueue.push(windows[i], i);
+        transparentQueue.sort(view);
 
         // render
         // ------
@@ -235,7 +248,6 @@ int main()
         // draw objects
         shader.use();
         glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = camera.GetViewMatrix();
         glm::mat4 model = glm::mat4(1.0f);
         shader.setMat4("projection", projection);
         shader.setMat4("view", view);
@@ -259,14 +271,15 @@ int main()
         // windows (from furthest to nearest)
         glBindVertexArray(transparentVAO);
         glBindTexture(GL_TEXTURE_2D, transparentTexture);
-        for (std::map<float, glm::vec3>::reverse_iterator it = sorted.rbegin(); it != sorted.rend(); ++it)
+        for (unsigned int i : transparentQueue.get_order())
         {
             model = glm::mat4(1.0f);
-            model = glm::translate(model, it->second);
+            model = glm::translate(model, windows[i]);
             shader.setMat4("model", model);
             glDrawArrays(GL_TRIANGLES, 0, 6);
         }
 
+        headless.end_frame(window);
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
@@ -282,7 +295,7 @@ int main()
     glDeleteBuffers(1, &planeVBO);
 
     glfwTerminate();
-    return 0;
+    return headless.exit_code();
 }
 
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
@@ -292,13 +305,13 @@ void processInput(GLFWwindow *window)
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+    if (input.get_key(window, GLFW_KEY_W) == GLFW_PRESS)
         camera.ProcessKeyboard(FORWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+    if (input.get_key(window, GLFW_KEY_S) == GLFW_PRESS)
         camera.ProcessKeyboard(BACKWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+    if (input.get_key(window, GLFW_KEY_A) == GLFW_PRESS)
         camera.ProcessKeyboard(LEFT, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+    if (input.get_key(window, GLFW_KEY_D) == GLFW_PRESS)
         camera.ProcessKeyboard(RIGHT, deltaTime);
 }
 
@@ -3,6 +3,18 @@
 #include <GLFW/glfw3.h>
 #include <iostream>
 #include <learnopengl/shader.h>
+#include <learnopengl/frame_graph.h>
+#include <learnopengl/post_process.h>
+#include <learnopengl/dynamic_resolution.h>
+#include <learnopengl/frame_capture.h>
+#include <learnopengl/headless.h>
+#include <learnopengl/input_replay.h>
+#include <learnopengl/job_system.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
 #include <stb_image.h>
 
 const unsigned int SCR_WIDTH = 800;
@@ -30,14 +42,44 @@ Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 float lastX = (float)SCR_WIDTH / 2.0;
 float lastY = (float)SCR_HEIGHT / 2.0;
 bool firstMouse = true;
+// keys, cursor and scroll go through it so a session can be recorded and replayed, see headless.h
+InputReplay input;
+
+// current framebuffer size, the frame graph sizes its render targets from it
+int framebufferWidth = SCR_WIDTH;
+int framebufferHeight = SCR_HEIGHT;
+
+// screen effects, toggled with the number keys; kept in the order of PostEffect
+std::vector<PostEffect> postEffects = {PostEffect::invert};
+// 9 toggles FXAA, P cycles through its quality presets
+const int fxaaPresets[] = {10, 12, 15, 20, 23, 25, 29, 39};
+int fxaaPreset = 1;
+
+// R toggles dynamic resolution, L a heavy scene to push the frame time over the budget
+bool dynamicResolution = true;
+bool heavyLoad = false;
+
+// C captures the frames to numbered QOI files, V streams them to ffmpeg
+enum class CaptureMode
+{
+	none,
+	files,
+	video,
+};
+CaptureMode captureMode = CaptureMode::none;
 
 // timing
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
 int
-main()
+main(int argc, char** argv)
 {
+	// --frames runs a fixed number of frames with a scripted camera in an invisible window, see headless.h
+	HeadlessRun headless(parse_headless_options(argc, argv));
+	// a resolution following the frame time would make the output differ from run to run
+	if (headless.is_enabled())
+		dynamicResolution = false;
 
 	// glfw: initialize and configure
 	// ------------------------------
@@ -48,6 +90,7 @@ main()
 #ifdef __APPLE__
 	glfwWindowHint(GLFW_OPENGL_COMPAT_PROFILE, GL_TRUE);
 #endif
+	headless.apply_window_hints();
 
 	// glfw: window creation
 	// ------------------------------
@@ -63,8 +106,9 @@ main()
 
 	// set mouse and window resizing callback funcs
 	// ------------------------------------------
-	glfwSetCursorPosCallback(window, mouse_callback);
-	glfwSetScrollCallback(window, scroll_callback);
+	input.install(window, mouse_callback, scroll_callback);
+	if (!headless.configure_input(input))
+		return -1;
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -76,6 +120,9 @@ main()
 		std::cout << "glad: failed to initialize opengl funcs\n";
 	}
 
+	// larger than the window size on retina displays
+	glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+
 	// configure global opengl state
 	// ------------------------------------------
 	glEnable(GL_DEPTH_TEST);
@@ -83,7 +130,6 @@ main()
 	// build and compile shaders
 	// ------------------------------------------
 	Shader shader("5.1.framebuffers.vs", "5.1.framebuffers.fs");
-	Shader screen_shader("5.1.framebuffers_screen.vs", "5.1.framebuffers_screen.fs");
 
 	// Setup Geomtry models
 	//-------------------------------------------
@@ -113,12 +159,6 @@ main()
 		5.0f, -0.5f, 5.0f, 2.0f, 0.0f, -5.0f, -0.5f, 5.0f,	0.0f, 0.0f, -5.0f, -0.5f, -5.0f, 0.0f, 2.0f,
 
 		5.0f, -0.5f, 5.0f, 2.0f, 0.0f, -5.0f, -0.5f, -5.0f, 0.0f, 2.0f, 5.0f,  -0.5f, -5.0f, 2.0f, 2.0f};
-	float quadVertices[] = {// vertex attributes for a quad that fills the entire
-							// screen in Normalized Device Coordinates.
-							// positions   // texCoords
-							-1.0f, 1.0f, 0.0f, 1.0f, -1.0f, -1.0f, 0.0f, 0.0f, 1.0f, -1.0f, 1.0f, 0.0f,
-
-							-1.0f, 1.0f, 0.0f, 1.0f, 1.0f,	-1.0f, 1.0f, 0.0f, 1.0f, 1.0f,	1.0f, 1.0f};
 
 	// upload vertices data to gpu
 	//------------------------------------
@@ -144,17 +184,6 @@ main()
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(1);
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-	// screen quad VAO
-	unsigned int quadVAO, quadVBO;
-	glGenVertexArrays(1, &quadVAO);
-	glGenBuffers(1, &quadVBO);
-	glBindVertexArray(quadVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
 
 	// load textures
 	//_________________________
@@ -166,43 +195,28 @@ main()
 	shader.use();
 	shader.setInt("texture1", 0);
 
-	screen_shader.use();
-	screen_shader.setInt("screenTexture", 0);
+	// the screen pass: the effects are fused into as few generated shaders as possible
+	PostProcessor postProcessor;
+
+	// render targets are declared per frame by the frame graph and recycled by this pool; a resize only changes the
+	// size they are declared with, the old ones are deleted once unused
+	// -------------------------
+	TransientResourcePool renderTargetPool;
+
+	// the scene is rendered at a fraction of the framebuffer size chosen from its GPU time, then upscaled by the
+	// first screen pass
+	// -------------------------
+	GpuTimer sceneTimer;
+	DynamicResolution resolution;
+	uint64_t frameNumber = 0;
+	double sceneMs = 0.0;
+	float lastTitleTime = 0.0f;
 
-	// framebuffer configuration
+	// captured frames are read back a few frames late and encoded by the job system, off the render thread
 	// -------------------------
-	unsigned int framebuffer;
-	glGenFramebuffers(1, &framebuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-	// create a color attachment texture
-	unsigned int textureColorbuffer;
-	glGenTextures(1, &textureColorbuffer);
-	glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureColorbuffer, 0);
-	// create a renderbuffer object for depth and stencil attachment (we won't be
-	// sampling these)
-	unsigned int rbo;
-	glGenRenderbuffers(1, &rbo);
-	glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-	glRenderbufferStorage(
-		GL_RENDERBUFFER,
-		GL_DEPTH24_STENCIL8,
-		SCR_WIDTH,
-		SCR_HEIGHT); // use a single renderbuffer object for
-					 // both a depth AND stencil buffer.
-	glFramebufferRenderbuffer(
-		GL_FRAMEBUFFER,
-		GL_DEPTH_STENCIL_ATTACHMENT,
-		GL_RENDERBUFFER,
-		rbo); // now actually attach it
-	// now that we actually created the framebuffer and added all attachments we
-	// want to check if it is actually complete now
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	JobSystem jobSystem;
+	FrameCapture frameCapture(jobSystem);
+	CaptureMode activeCapture = CaptureMode::none;
 
 	//  If we render the scene in wireframe it's obvious we've only drawn a single
 	//  quad in the default framebuffer. draw as wireframe
@@ -215,70 +229,152 @@ main()
 		// per-frame time logic
 		// --------------------
 		float currentFrame = static_cast<float>(glfwGetTime());
-		deltaTime = currentFrame - lastFrame;
+		deltaTime = input.begin_frame(window, headless.frame_delta(currentFrame - lastFrame));
 		lastFrame = currentFrame;
 
 		// input
 		// -----
 		process_input(window);
+		headless.move_camera(camera, deltaTime);
+		input.update_camera(camera);
+
+		// scene GPU times of the previous frames drive the scale of this one
+		double measuredMs;
+		uint64_t measuredFrame;
+		while (sceneTimer.poll(measuredMs, measuredFrame))
+		{
+			if (dynamicResolution)
+				resolution.update(measuredMs, measuredFrame);
+			sceneMs = measuredMs;
+		}
+		const float scale = dynamicResolution ? resolution.begin_frame(frameNumber) : 1.0f;
+		const int sceneWidth = std::max(1, (int)std::lround(framebufferWidth * scale));
+		const int sceneHeight = std::max(1, (int)std::lround(framebufferHeight * scale));
 
 		// render
 		// ------
-		// bind to framebuffer and draw scene as we normally would to color texture
-		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-		glEnable(GL_DEPTH_TEST); // enable depth testing (is disabled for rendering
-								 // screen-space quad)
-
-		// make sure we clear the framebuffer's content
-		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		shader.use();
-		glm::mat4 model = glm::mat4(1.0f);
-		glm::mat4 view = camera.GetViewMatrix();
-		glm::mat4 projection =
-			glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-		shader.setMat4("view", view);
-		shader.setMat4("projection", projection);
-		// cubes
-		glBindVertexArray(cubeVAO);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, cubeTexture);
-		model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
-		shader.setMat4("model", model);
-		glDrawArrays(GL_TRIANGLES, 0, 36);
-		model = glm::mat4(1.0f);
-		model = glm::translate(model, glm::vec3(2.0f, 0.0f, 0.0f));
-		shader.setMat4("model", model);
-		glDrawArrays(GL_TRIANGLES, 0, 36);
-		// floor
-		glBindVertexArray(planeVAO);
-		glBindTexture(GL_TEXTURE_2D, floorTexture);
-		shader.setMat4("model", glm::mat4(1.0f));
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-		glBindVertexArray(0);
-
-		// now bind back to default framebuffer and draw a quad plane with the
-		// attached framebuffer color texture
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		glDisable(GL_DEPTH_TEST); // disable depth test so screen-space quad isn't
-								  // discarded due to depth test.
-		// clear all relevant buffers
-		glClearColor(
-			1.0f,
-			1.0f,
-			1.0f,
-			1.0f); // set clear color to white (not really necessary actually, since
-				   // we won't be able to see behind the quad anyways)
-		glClear(GL_COLOR_BUFFER_BIT);
-
-		screen_shader.use();
-		glBindVertexArray(quadVAO);
-		glBindTexture(
-			GL_TEXTURE_2D,
-			textureColorbuffer); // use the color attachment texture as
-								 // the texture of the quad plane
-		glDrawArrays(GL_TRIANGLES, 0, 6);
+		FrameGraph frameGraph(renderTargetPool);
+		FrameGraphResource backbuffer = frameGraph.import_backbuffer(framebufferWidth, framebufferHeight);
+		FrameGraphResource sceneColor = -1;
+
+		// draw the scene as we normally would to a color texture
+		frameGraph.add_pass(
+			"scene",
+			[&](FrameGraph::Builder& builder) {
+				sceneColor = builder.create("scene color", {sceneWidth, sceneHeight, GL_RGB8});
+				// we won't be sampling the depth and stencil, it is only used inside this pass
+				builder.create("scene depth", {sceneWidth, sceneHeight, GL_DEPTH24_STENCIL8});
+			},
+			[&](const FrameGraph&) {
+				sceneTimer.begin(frameNumber);
+				glEnable(GL_DEPTH_TEST); // enable depth testing (is disabled for rendering
+										 // screen-space quad)
+
+				// make sure we clear the framebuffer's content
+				glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+				shader.use();
+				glm::mat4 model = glm::mat4(1.0f);
+				glm::mat4 view = camera.GetViewMatrix();
+				glm::mat4 projection = glm::perspective(
+					glm::radians(camera.Zoom),
+					(float)framebufferWidth / (float)framebufferHeight,
+					0.1f,
+					100.0f);
+				shader.setMat4("view", view);
+				shader.setMat4("projection", projection);
+				// cubes
+				glBindVertexArray(cubeVAO);
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, cubeTexture);
+				model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
+				shader.setMat4("model", model);
+				glDrawArrays(GL_TRIANGLES, 0, 36);
+				model = glm::mat4(1.0f);
+				model = glm::translate(model, glm::vec3(2.0f, 0.0f, 0.0f));
+				shader.setMat4("model", model);
+				glDrawArrays(GL_TRIANGLES, 0, 36);
+				// floor
+				glBindVertexArray(planeVAO);
+				glBindTexture(GL_TEXTURE_2D, floorTexture);
+				shader.setMat4("model", glm::mat4(1.0f));
+				glDrawArrays(GL_TRIANGLES, 0, 6);
+				// the heavy load draws the scene again on top of itself, its cost follows the pixel count
+				if (heavyLoad)
+				{
+					glDepthFunc(GL_LEQUAL);
+					for (int i = 0; i < 100; i++)
+					{
+						glBindVertexArray(cubeVAO);
+						glBindTexture(GL_TEXTURE_2D, cubeTexture);
+						shader.setMat4("model", glm::translate(glm::mat4(1.0f), glm::vec3(-1.0f, 0.0f, -1.0f)));
+						glDrawArrays(GL_TRIANGLES, 0, 36);
+						shader.setMat4("model", glm::translate(glm::mat4(1.0f), glm::vec3(2.0f, 0.0f, 0.0f)));
+						glDrawArrays(GL_TRIANGLES, 0, 36);
+						glBindVertexArray(planeVAO);
+						glBindTexture(GL_TEXTURE_2D, floorTexture);
+						shader.setMat4("model", glm::mat4(1.0f));
+						glDrawArrays(GL_TRIANGLES, 0, 6);
+					}
+					glDepthFunc(GL_LESS);
+				}
+				glBindVertexArray(0);
+				sceneTimer.end();
+			});
+
+		// now draw a quad plane with the scene color texture to the default framebuffer, applying the screen effects;
+		// a scaled down scene is sharpened while the first pass upscales it
+		std::vector<PostEffect> chain = postEffects;
+		if (scale < 1.0f)
+			chain.insert(chain.begin(), PostEffect::upscale_sharpen);
+		postProcessor.settings.fxaa_quality_preset = fxaaPresets[fxaaPreset];
+		postProcessor.add_passes(frameGraph, chain, sceneColor, backbuffer);
+
+		frameGraph.compile();
+		frameGraph.execute();
+		frameNumber++;
+
+		if (captureMode != activeCapture)
+		{
+			if (frameCapture.is_capturing())
+			{
+				frameCapture.stop();
+				std::cout << "captured " << frameCapture.get_captured_count() << " frames" << std::endl;
+			}
+			if (captureMode == CaptureMode::files)
+				frameCapture.start_files("capture_", CaptureFormat::qoi);
+			else if (captureMode == CaptureMode::video)
+			{
+				// the frames are stamped at 60 fps whatever the rate they are rendered at
+				const std::string command = "ffmpeg -y -loglevel error -f rawvideo -pix_fmt rgba -s " +
+											std::to_string(framebufferWidth) + "x" + std::to_string(framebufferHeight) +
+											" -framerate 60 -i - -pix_fmt yuv420p capture.mp4";
+				if (!frameCapture.start_pipe(command))
+				{
+					std::cout << "failed to start: " << command << std::endl;
+					captureMode = CaptureMode::none;
+				}
+			}
+			activeCapture = captureMode;
+		}
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+		frameCapture.capture(framebufferWidth, framebufferHeight);
+		if (!frameCapture.is_healthy())
+		{
+			std::cout << "frame capture failed, stopping it" << std::endl;
+			frameCapture.stop();
+			captureMode = activeCapture = CaptureMode::none;
+		}
+		headless.end_frame(window);
+
+		if (currentFrame - lastTitleTime > 1.0f)
+		{
+			const std::string title = "learn_opengl:framebuffer - scale " + std::to_string(scale).substr(0, 4) +
+									  ", scene " + std::to_string(sceneMs).substr(0, 5) + " ms";
+			glfwSetWindowTitle(window, title.c_str());
+			lastTitleTime = currentFrame;
+		}
 
 		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved
 		// etc.)
@@ -286,6 +382,7 @@ main()
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 	}
+	return headless.exit_code();
 }
 // process all input: query GLFW whether relevant keys are pressed/released this
 // frame and react accordingly
@@ -296,14 +393,81 @@ process_input(GLFWwindow* window)
 	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
 		glfwSetWindowShouldClose(window, true);
 
-	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+	if (input.get_key(window, GLFW_KEY_W) == GLFW_PRESS)
 		camera.ProcessKeyboard(FORWARD, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+	if (input.get_key(window, GLFW_KEY_S) == GLFW_PRESS)
 		camera.ProcessKeyboard(BACKWARD, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+	if (input.get_key(window, GLFW_KEY_A) == GLFW_PRESS)
 		camera.ProcessKeyboard(LEFT, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+	if (input.get_key(window, GLFW_KEY_D) == GLFW_PRESS)
 		camera.ProcessKeyboard(RIGHT, deltaTime);
+
+	static bool resolutionWasPressed = false, loadWasPressed = false;
+	const bool resolutionPressed = input.get_key(window, GLFW_KEY_R) == GLFW_PRESS;
+	const bool loadPressed = input.get_key(window, GLFW_KEY_L) == GLFW_PRESS;
+	if (resolutionPressed && !resolutionWasPressed)
+		dynamicResolution = !dynamicResolution;
+	if (loadPressed && !loadWasPressed)
+		heavyLoad = !heavyLoad;
+	resolutionWasPressed = resolutionPressed;
+	loadWasPressed = loadPressed;
+
+	static bool filesWasPressed = false, videoWasPressed = false;
+	const bool filesPressed = input.get_key(window, GLFW_KEY_C) == GLFW_PRESS;
+	const bool videoPressed = input.get_key(window, GLFW_KEY_V) == GLFW_PRESS;
+	if (filesPressed && !filesWasPressed)
+		captureMode = captureMode == CaptureMode::files ? CaptureMode::none : CaptureMode::files;
+	if (videoPressed && !videoWasPressed)
+		captureMode = captureMode == CaptureMode::video ? CaptureMode::none : CaptureMode::video;
+	filesWasPressed = filesPressed;
+	videoWasPressed = videoPressed;
+
+	// 1 to 9 toggle an effect, once per press
+	static bool wasPressed[9] = {};
+	const PostEffect effects[9] = {
+		PostEffect::sharpen,
+		PostEffect::blur,
+		PostEffect::edge_detect,
+		PostEffect::invert,
+		PostEffect::grayscale,
+		PostEffect::color_grading,
+		PostEffect::tonemap,
+		PostEffect::vignette,
+		PostEffect::fxaa};
+	bool changed = false;
+	for (int i = 0; i < 9; i++)
+	{
+		const bool pressed = input.get_key(window, GLFW_KEY_1 + i) == GLFW_PRESS;
+		if (pressed && !wasPressed[i])
+		{
+			auto found = std::find(postEffects.begin(), postEffects.end(), effects[i]);
+			if (found != postEffects.end())
+				postEffects.erase(found);
+			else
+			{
+				postEffects.push_back(effects[i]);
+				std::sort(postEffects.begin(), postEffects.end());
+			}
+			changed = true;
+		}
+		wasPressed[i] = pressed;
+	}
+	static bool presetWasPressed = false;
+	const bool presetPressed = input.get_key(window, GLFW_KEY_P) == GLFW_PRESS;
+	if (presetPressed && !presetWasPressed)
+	{
+		fxaaPreset = (fxaaPreset + 1) % int(sizeof(fxaaPresets) / sizeof(fxaaPresets[0]));
+		std::cout << "FXAA quality preset " << fxaaPresets[fxaaPreset] << std::endl;
+	}
+	presetWasPressed = presetPressed;
+	if (changed)
+	{
+		std::cout << "screen effects:";
+		for (PostEffect effect : postEffects)
+			std::cout << " " << get_post_effect_name(effect);
+		std::cout << " (" << std::max<size_t>(PostProcessor::split_passes(postEffects).size(), 1) << " passes)"
+				  << std::endl;
+	}
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback
@@ -312,9 +476,12 @@ process_input(GLFWwindow* window)
 void
 framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-	// make sure the viewport matches the new window dimensions; note that width
-	// and height will be significantly larger than specified on retina displays.
-	glViewport(0, 0, width, height);
+	// the frame graph sets the viewport of every pass, it only needs the new size; note that width
+	// and height will be significantly larger than specified on retina displays. A minimized window reports 0 x 0.
+	if (width == 0 || height == 0)
+		return;
+	framebufferWidth = width;
+	framebufferHeight = height;
 }
 
 // glfw: whenever the mouse moves, this callback is called
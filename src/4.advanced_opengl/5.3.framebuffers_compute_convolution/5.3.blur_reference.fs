@@ -0,0 +1,23 @@
+#version 330 core
+// Gaussian as a single fragment pass over the whole (2 * radius + 1)^2 footprint, the way the 3x3 kernels of the
+// framebuffers chapter are written. Used as the reference for the compute version.
+#define MAX_RADIUS 64
+
+out vec4 FragColor;
+
+uniform sampler2D screenTexture;
+uniform int radius;
+uniform float weights[MAX_RADIUS + 1];
+
+void main() {
+    ivec2 size = textureSize(screenTexture, 0);
+    ivec2 center = ivec2(gl_FragCoord.xy);
+    vec3 color = vec3(0.0);
+    for (int y = -radius; y <= radius; y++) {
+        for (int x = -radius; x <= radius; x++) {
+            ivec2 coords = clamp(center + ivec2(x, y), ivec2(0), size - 1);
+            color += weights[abs(x)] * weights[abs(y)] * texelFetch(screenTexture, coords, 0).rgb;
+        }
+    }
+    FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,48 @@
+#version 430 core
+// One direction of a separable Gaussian: every work group filters TILE_SIZE texels of one row or column. The tile and
+// radius texels on both sides are loaded into shared memory once, so each texel is read from the image about once per
+// pass instead of 2 * radius + 1 times, and the cost grows with the radius only through the arithmetic.
+#define TILE_SIZE 128
+#define MAX_RADIUS 64
+
+layout(local_size_x = TILE_SIZE, local_size_y = 1, local_size_z = 1) in;
+
+layout(rgba16f, binding = 0) uniform readonly image2D inputImage;
+layout(rgba16f, binding = 1) uniform writeonly image2D outputImage;
+
+// (1, 0) filters along the rows, (0, 1) along the columns
+uniform ivec2 direction;
+uniform int radius;
+// weights[0] is the center, weights[i] applies at distance i on both sides
+uniform float weights[MAX_RADIUS + 1];
+
+shared vec3 tile[TILE_SIZE + 2 * MAX_RADIUS];
+
+void main() {
+    ivec2 size = imageSize(inputImage);
+    int lineLength = direction.x == 1 ? size.x : size.y;
+    // work group y picks the row or column, x the segment along it
+    int line = int(gl_WorkGroupID.y);
+    int start = int(gl_WorkGroupID.x) * TILE_SIZE;
+    int local = int(gl_LocalInvocationID.x);
+
+    // cooperative load, clamped to the edge like GL_CLAMP_TO_EDGE
+    for (int i = local; i < TILE_SIZE + 2 * radius; i += TILE_SIZE) {
+        int along = clamp(start + i - radius, 0, lineLength - 1);
+        ivec2 coords = direction.x == 1 ? ivec2(along, line) : ivec2(line, along);
+        tile[i] = imageLoad(inputImage, coords).rgb;
+    }
+    barrier();
+
+    int along = start + local;
+    if (along >= lineLength)
+        return;
+
+    int center = local + radius;
+    vec3 color = weights[0] * tile[center];
+    for (int i = 1; i <= radius; i++)
+        color += weights[i] * (tile[center - i] + tile[center + i]);
+
+    ivec2 coords = direction.x == 1 ? ivec2(along, line) : ivec2(line, along);
+    imageStore(outputImage, coords, vec4(color, 1.0));
+}
@@ -0,0 +1,11 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D texture1;
+
+void main()
+{    
+    FragColor = texture(texture1, TexCoords);
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D screenTexture;
+
+void main() {
+    FragColor = vec4(texture(screenTexture, TexCoords).rgb, 1.0);
+}
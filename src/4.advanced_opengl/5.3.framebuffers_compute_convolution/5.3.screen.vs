@@ -8,4 +8,4 @@ void main()
 {
     TexCoords = aTexCoords;
     gl_Position = vec4(aPos.x, aPos.y, 0.0, 1.0); 
-}  
\ No newline at end of file
+}
@@ -0,0 +1,19 @@
+#version 430 core
+// sharpen by adding back the difference between the image and its blur
+layout(local_size_x = 16, local_size_y = 16, local_size_z = 1) in;
+
+layout(rgba16f, binding = 0) uniform readonly image2D originalImage;
+layout(rgba16f, binding = 1) uniform readonly image2D blurredImage;
+layout(rgba16f, binding = 2) uniform writeonly image2D outputImage;
+
+uniform float amount;
+
+void main() {
+    ivec2 coords = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(coords, imageSize(outputImage))))
+        return;
+
+    vec3 original = imageLoad(originalImage, coords).rgb;
+    vec3 blurred = imageLoad(blurredImage, coords).rgb;
+    imageStore(outputImage, coords, vec4(max(original + amount * (original - blurred), 0.0), 1.0));
+}
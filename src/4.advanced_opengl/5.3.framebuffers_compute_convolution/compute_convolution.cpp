@@ -0,0 +1,708 @@
+#include <learnopengl/camera.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <learnopengl/shader.h>
+#include <learnopengl/shader_c.h>
+#include <learnopengl/headless.h>
+#include <learnopengl/input_replay.h>
+#include <stb_image.h>
+
+// The Gaussian blur of the framebuffers chapter as two compute passes, one along the rows and one along the columns,
+// each loading a tile of the image into shared memory. The cost per pixel grows linearly with the radius instead of
+// with its square like a 2D fragment kernel. Sharpening is an unsharp mask on top of the same blur.
+//
+// 1: no filter, 2: compute blur, 3: fragment blur, 4: compute sharpen
+// up/down: double or halve the radius (1 to 64)
+// B: time both blurs over all radii and compare their results
+
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+
+// must match the compute and reference shaders
+const int MAX_RADIUS = 64;
+const int TILE_SIZE = 128;
+
+enum class FilterMode
+{
+	none,
+	computeBlur,
+	fragmentBlur,
+	computeSharpen,
+};
+
+// callback funcs
+void
+framebuffer_size_callback(GLFWwindow* window, int width, int height);
+
+void
+mouse_callback(GLFWwindow* window, double xpos, double ypos);
+
+void
+scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+
+void
+process_input(GLFWwindow* window);
+
+// load texture
+unsigned int
+loadTexture(const char* path);
+
+// camera
+Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+float lastX = (float)SCR_WIDTH / 2.0;
+float lastY = (float)SCR_HEIGHT / 2.0;
+bool firstMouse = true;
+// keys, cursor and scroll go through it so a session can be recorded and replayed, see headless.h
+InputReplay input;
+
+// current framebuffer size, the render targets are recreated when it changes
+int framebufferWidth = SCR_WIDTH;
+int framebufferHeight = SCR_HEIGHT;
+bool targetsDirty = true;
+
+// filter settings
+FilterMode filterMode = FilterMode::computeBlur;
+int blurRadius = 8;
+bool benchmarkRequested = false;
+
+// timing
+float deltaTime = 0.0f;
+float lastFrame = 0.0f;
+
+// scene color, two ping pong textures for the filters and the scene depth; the images are rgba16f for imageLoad
+struct RenderTargets
+{
+	unsigned int sceneFBO = 0;
+	unsigned int outputFBO = 0;
+	unsigned int depthRBO = 0;
+	unsigned int sceneTexture = 0;
+	unsigned int tempTexture = 0;
+	unsigned int outputTexture = 0;
+};
+
+// normalized so that weights[0] + 2 * (weights[1] + ... + weights[radius]) is 1
+std::vector<float>
+gaussianWeights(int radius)
+{
+	// the kernel is cut at three standard deviations
+	const float sigma = std::max(radius / 3.0f, 0.5f);
+	std::vector<float> weights(radius + 1);
+	float sum = 0.0f;
+	for (int i = 0; i <= radius; i++)
+	{
+		weights[i] = std::exp(-(i * i) / (2.0f * sigma * sigma));
+		sum += i == 0 ? weights[i] : 2.0f * weights[i];
+	}
+	for (float& weight : weights)
+		weight /= sum;
+	return weights;
+}
+
+unsigned int
+createImageTexture(int width, int height)
+{
+	unsigned int texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	return texture;
+}
+
+void
+destroyRenderTargets(RenderTargets& targets)
+{
+	glDeleteFramebuffers(1, &targets.sceneFBO);
+	glDeleteFramebuffers(1, &targets.outputFBO);
+	glDeleteRenderbuffers(1, &targets.depthRBO);
+	glDeleteTextures(1, &targets.sceneTexture);
+	glDeleteTextures(1, &targets.tempTexture);
+	glDeleteTextures(1, &targets.outputTexture);
+	targets = RenderTargets{};
+}
+
+void
+createRenderTargets(RenderTargets& targets, int width, int height)
+{
+	destroyRenderTargets(targets);
+	targets.sceneTexture = createImageTexture(width, height);
+	targets.tempTexture = createImageTexture(width, height);
+	targets.outputTexture = createImageTexture(width, height);
+
+	glGenRenderbuffers(1, &targets.depthRBO);
+	glBindRenderbuffer(GL_RENDERBUFFER, targets.depthRBO);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+	glGenFramebuffers(1, &targets.sceneFBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, targets.sceneFBO);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, targets.sceneTexture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, targets.depthRBO);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
+
+	// the fragment reference renders into the output texture
+	glGenFramebuffers(1, &targets.outputFBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, targets.outputFBO);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, targets.outputTexture, 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// horizontal pass from input to temp, vertical pass from temp to output
+void
+blurCompute(ComputeShader& shader, const RenderTargets& targets, unsigned int input, unsigned int output, int radius)
+{
+	const std::vector<float> weights = gaussianWeights(radius);
+	shader.use();
+	shader.setInt("radius", radius);
+	shader.setFloatArray("weights", weights.data(), (int)weights.size());
+
+	// one work group per TILE_SIZE texels of a row
+	glBindImageTexture(0, input, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA16F);
+	glBindImageTexture(1, targets.tempTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+	shader.setIVec2("direction", 1, 0);
+	glDispatchCompute((framebufferWidth + TILE_SIZE - 1) / TILE_SIZE, framebufferHeight, 1);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+	// and of a column
+	glBindImageTexture(0, targets.tempTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA16F);
+	glBindImageTexture(1, output, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+	shader.setIVec2("direction", 0, 1);
+	glDispatchCompute((framebufferHeight + TILE_SIZE - 1) / TILE_SIZE, framebufferWidth, 1);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+// the whole footprint in one fragment pass, into the output texture
+void
+blurFragment(Shader& shader, const RenderTargets& targets, unsigned int quadVAO, int radius)
+{
+	const std::vector<float> weights = gaussianWeights(radius);
+	glBindFramebuffer(GL_FRAMEBUFFER, targets.outputFBO);
+	glViewport(0, 0, framebufferWidth, framebufferHeight);
+	glDisable(GL_DEPTH_TEST);
+	shader.use();
+	shader.setInt("radius", radius);
+	glUniform1fv(glGetUniformLocation(shader.ID, "weights"), (GLsizei)weights.size(), weights.data());
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, targets.sceneTexture);
+	glBindVertexArray(quadVAO);
+	glDrawArrays(GL_TRIANGLES, 0, 6);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// blurs the scene into output, then writes scene + amount * (scene - blur) into temp
+unsigned int
+sharpenCompute(ComputeShader& blurShader, ComputeShader& unsharpShader, const RenderTargets& targets, int radius)
+{
+	blurCompute(blurShader, targets, targets.sceneTexture, targets.outputTexture, radius);
+	unsharpShader.use();
+	unsharpShader.setFloat("amount", 1.5f);
+	glBindImageTexture(0, targets.sceneTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA16F);
+	glBindImageTexture(1, targets.outputTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA16F);
+	glBindImageTexture(2, targets.tempTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+	glDispatchCompute((framebufferWidth + 15) / 16, (framebufferHeight + 15) / 16, 1);
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+	return targets.tempTexture;
+}
+
+// average GPU time of runs calls of filter in milliseconds, after one warm up call; waits for the results
+template<typename Filter>
+double
+timeGpu(unsigned int query, int runs, Filter&& filter)
+{
+	filter();
+	double totalMs = 0.0;
+	for (int i = 0; i < runs; i++)
+	{
+		glBeginQuery(GL_TIME_ELAPSED, query);
+		filter();
+		glEndQuery(GL_TIME_ELAPSED);
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+		totalMs += elapsed / 1e6;
+	}
+	return totalMs / runs;
+}
+
+std::vector<float>
+readTexture(unsigned int texture)
+{
+	std::vector<float> pixels((size_t)framebufferWidth * framebufferHeight * 4);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, pixels.data());
+	return pixels;
+}
+
+// both blurs on the current scene texture for every radius; the results differ only by the half float rounding of
+// the intermediate texture of the compute version
+void
+runBenchmark(
+	ComputeShader& blurShader,
+	Shader& referenceShader,
+	const RenderTargets& targets,
+	unsigned int quadVAO,
+	unsigned int query)
+{
+	std::printf("gaussian blur, %d x %d\n", framebufferWidth, framebufferHeight);
+	std::printf("%8s %14s %14s %10s %12s\n", "radius", "compute ms", "fragment ms", "speedup", "max diff");
+	for (int radius = 1; radius <= MAX_RADIUS; radius *= 2)
+	{
+		const double computeMs = timeGpu(query, 10, [&] {
+			blurCompute(blurShader, targets, targets.sceneTexture, targets.outputTexture, radius);
+		});
+		const std::vector<float> computeResult = readTexture(targets.outputTexture);
+
+		// the 2D kernel gets slow quickly, fewer runs for the large radii
+		const double fragmentMs = timeGpu(query, radius >= 32 ? 2 : 10, [&] {
+			blurFragment(referenceShader, targets, quadVAO, radius);
+		});
+		const std::vector<float> fragmentResult = readTexture(targets.outputTexture);
+
+		float maxDiff = 0.0f;
+		for (size_t i = 0; i < computeResult.size(); i++)
+			maxDiff = std::max(maxDiff, std::abs(computeResult[i] - fragmentResult[i]));
+		std::printf(
+			"%8d %14.3f %14.3f %9.1fx %12.5f\n",
+			radius,
+			computeMs,
+			fragmentMs,
+			fragmentMs / computeMs,
+			maxDiff);
+	}
+}
+
+int
+main(int argc, char** argv)
+{
+	// --frames runs a fixed number of frames with a scripted camera in an invisible window, see headless.h
+	HeadlessRun headless(parse_headless_options(argc, argv));
+
+	// glfw: initialize and configure
+	// ------------------------------
+	glfwInit();
+	// compute shaders are core since 4.3, which macOS does not provide
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	headless.apply_window_hints();
+
+	// glfw: window creation
+	// ------------------------------
+	GLFWwindow* window =
+		glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "learn_opengl:framebuffers_compute_convolution", NULL, NULL);
+	if (window == NULL)
+	{
+		std::cout << "glfw: failed to create window, an OpenGL 4.3 context is required!\n";
+		glfwTerminate();
+		return -1;
+	}
+
+	// Makes the context of the specified window current for the calling thread.
+	// ------------------------------------------
+	glfwMakeContextCurrent(window);
+
+	// set mouse and window resizing callback funcs
+	// ------------------------------------------
+	input.install(window, mouse_callback, scroll_callback);
+	if (!headless.configure_input(input))
+		return -1;
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+	// make sure that glad initilzed opengl funcs
+	// ------------------------------------------
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "glad: failed to initialize opengl funcs\n";
+		return -1;
+	}
+
+	// larger than the window size on retina displays
+	glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+
+	// build and compile shaders
+	// ------------------------------------------
+	Shader shader("5.3.framebuffers.vs", "5.3.framebuffers.fs");
+	Shader screenShader("5.3.screen.vs", "5.3.screen.fs");
+	Shader referenceShader("5.3.screen.vs", "5.3.blur_reference.fs");
+	ComputeShader blurShader("5.3.blur_separable.cs");
+	ComputeShader unsharpShader("5.3.unsharp_mask.cs");
+
+	// set up vertex data (and buffer(s)) and configure vertex attributes
+	// ------------------------------------------------------------------
+	float cubeVertices[] = {
+		// positions          // texture Coords
+		-0.5f, -0.5f, -0.5f, 0.0f, 0.0f, 0.5f,	-0.5f, -0.5f, 1.0f, 0.0f, 0.5f,	 0.5f,	-0.5f, 1.0f, 1.0f,
+		0.5f,  0.5f,  -0.5f, 1.0f, 1.0f, -0.5f, 0.5f,  -0.5f, 0.0f, 1.0f, -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
+
+		-0.5f, -0.5f, 0.5f,	 0.0f, 0.0f, 0.5f,	-0.5f, 0.5f,  1.0f, 0.0f, 0.5f,	 0.5f,	0.5f,  1.0f, 1.0f,
+		0.5f,  0.5f,  0.5f,	 1.0f, 1.0f, -0.5f, 0.5f,  0.5f,  0.0f, 1.0f, -0.5f, -0.5f, 0.5f,  0.0f, 0.0f,
+
+		-0.5f, 0.5f,  0.5f,	 1.0f, 0.0f, -0.5f, 0.5f,  -0.5f, 1.0f, 1.0f, -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+		-0.5f, -0.5f, -0.5f, 0.0f, 1.0f, -0.5f, -0.5f, 0.5f,  0.0f, 0.0f, -0.5f, 0.5f,	0.5f,  1.0f, 0.0f,
+
+		0.5f,  0.5f,  0.5f,	 1.0f, 0.0f, 0.5f,	0.5f,  -0.5f, 1.0f, 1.0f, 0.5f,	 -0.5f, -0.5f, 0.0f, 1.0f,
+		0.5f,  -0.5f, -0.5f, 0.0f, 1.0f, 0.5f,	-0.5f, 0.5f,  0.0f, 0.0f, 0.5f,	 0.5f,	0.5f,  1.0f, 0.0f,
+
+		-0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 0.5f,	-0.5f, -0.5f, 1.0f, 1.0f, 0.5f,	 -0.5f, 0.5f,  1.0f, 0.0f,
+		0.5f,  -0.5f, 0.5f,	 1.0f, 0.0f, -0.5f, -0.5f, 0.5f,  0.0f, 0.0f, -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+
+		-0.5f, 0.5f,  -0.5f, 0.0f, 1.0f, 0.5f,	0.5f,  -0.5f, 1.0f, 1.0f, 0.5f,	 0.5f,	0.5f,  1.0f, 0.0f,
+		0.5f,  0.5f,  0.5f,	 1.0f, 0.0f, -0.5f, 0.5f,  0.5f,  0.0f, 0.0f, -0.5f, 0.5f,	-0.5f, 0.0f, 1.0f};
+	float planeVertices[] = {
+		// positions          // texture Coords
+		5.0f, -0.5f, 5.0f, 2.0f, 0.0f, -5.0f, -0.5f, 5.0f,	0.0f, 0.0f, -5.0f, -0.5f, -5.0f, 0.0f, 2.0f,
+
+		5.0f, -0.5f, 5.0f, 2.0f, 0.0f, -5.0f, -0.5f, -5.0f, 0.0f, 2.0f, 5.0f,  -0.5f, -5.0f, 2.0f, 2.0f};
+	float quadVertices[] = {// vertex attributes for a quad that fills the entire
+							// screen in Normalized Device Coordinates.
+							// positions   // texCoords
+							-1.0f, 1.0f, 0.0f, 1.0f, -1.0f, -1.0f, 0.0f, 0.0f, 1.0f, -1.0f, 1.0f, 0.0f,
+
+							-1.0f, 1.0f, 0.0f, 1.0f, 1.0f,	-1.0f, 1.0f, 0.0f, 1.0f, 1.0f,	1.0f, 1.0f};
+
+	// upload vertices data to gpu
+	//------------------------------------
+	// cube VAO
+	unsigned int cubeVAO, cubeVBO;
+	glGenVertexArrays(1, &cubeVAO);
+	glGenBuffers(1, &cubeVBO);
+	glBindVertexArray(cubeVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), &cubeVertices, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+	// plane VAO
+	unsigned int planeVAO, planeVBO;
+	glGenVertexArrays(1, &planeVAO);
+	glGenBuffers(1, &planeVBO);
+	glBindVertexArray(planeVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, planeVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(planeVertices), &planeVertices, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+	// screen quad VAO
+	unsigned int quadVAO, quadVBO;
+	glGenVertexArrays(1, &quadVAO);
+	glGenBuffers(1, &quadVBO);
+	glBindVertexArray(quadVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+
+	// load textures
+	//_________________________
+	unsigned int cubeTexture = loadTexture("../../resources/textures/container.jpg");
+	unsigned int floorTexture = loadTexture("../../resources/textures/metal.png");
+
+	// shader configuration
+	//------------------------------
+	shader.use();
+	shader.setInt("texture1", 0);
+
+	screenShader.use();
+	screenShader.setInt("screenTexture", 0);
+
+	referenceShader.use();
+	referenceShader.setInt("screenTexture", 0);
+
+	RenderTargets targets;
+
+	// two timer queries, the result of the previous frame is read while the current one is recorded
+	unsigned int filterQueries[2];
+	glGenQueries(2, filterQueries);
+	unsigned int benchmarkQuery;
+	glGenQueries(1, &benchmarkQuery);
+	unsigned int frameIndex = 0;
+	double filterMsSum = 0.0;
+	int filterMsCount = 0;
+	float lastTitleTime = 0.0f;
+
+	// render loop
+	// -----------
+	while (!glfwWindowShouldClose(window))
+	{
+		// per-frame time logic
+		// --------------------
+		float currentFrame = static_cast<float>(glfwGetTime());
+		deltaTime = input.begin_frame(window, headless.frame_delta(currentFrame - lastFrame));
+		lastFrame = currentFrame;
+
+		// input
+		// -----
+		process_input(window);
+		headless.move_camera(camera, deltaTime);
+		input.update_camera(camera);
+
+		if (targetsDirty)
+		{
+			createRenderTargets(targets, framebufferWidth, framebufferHeight);
+			targetsDirty = false;
+		}
+
+		// render
+		// ------
+		// draw the scene as we normally would to the scene texture
+		glBindFramebuffer(GL_FRAMEBUFFER, targets.sceneFBO);
+		glViewport(0, 0, framebufferWidth, framebufferHeight);
+		glEnable(GL_DEPTH_TEST);
+		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		shader.use();
+		glm::mat4 model = glm::mat4(1.0f);
+		glm::mat4 view = camera.GetViewMatrix();
+		glm::mat4 projection = glm::perspective(
+			glm::radians(camera.Zoom),
+			(float)framebufferWidth / (float)framebufferHeight,
+			0.1f,
+			100.0f);
+		shader.setMat4("view", view);
+		shader.setMat4("projection", projection);
+		// cubes
+		glBindVertexArray(cubeVAO);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, cubeTexture);
+		model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
+		shader.setMat4("model", model);
+		glDrawArrays(GL_TRIANGLES, 0, 36);
+		model = glm::mat4(1.0f);
+		model = glm::translate(model, glm::vec3(2.0f, 0.0f, 0.0f));
+		shader.setMat4("model", model);
+		glDrawArrays(GL_TRIANGLES, 0, 36);
+		// floor
+		glBindVertexArray(planeVAO);
+		glBindTexture(GL_TEXTURE_2D, floorTexture);
+		shader.setMat4("model", glm::mat4(1.0f));
+		glDrawArrays(GL_TRIANGLES, 0, 6);
+		glBindVertexArray(0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		if (benchmarkRequested)
+		{
+			runBenchmark(blurShader, referenceShader, targets, quadVAO, benchmarkQuery);
+			benchmarkRequested = false;
+		}
+
+		// filter the scene texture
+		// ------------------------
+		const unsigned int query = filterQueries[frameIndex % 2];
+		if (frameIndex > 0)
+		{
+			// previous frame's query, skipped rather than waited for when the GPU has not finished it; the filter
+			// time is shown in the title once per second
+			const unsigned int previousQuery = filterQueries[(frameIndex + 1) % 2];
+			GLint available = 0;
+			glGetQueryObjectiv(previousQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (available)
+			{
+				GLuint64 elapsed = 0;
+				glGetQueryObjectui64v(previousQuery, GL_QUERY_RESULT, &elapsed);
+				filterMsSum += elapsed / 1e6;
+				filterMsCount++;
+			}
+		}
+		glBeginQuery(GL_TIME_ELAPSED, query);
+		unsigned int displayTexture = targets.sceneTexture;
+		switch (filterMode)
+		{
+		case FilterMode::computeBlur:
+			blurCompute(blurShader, targets, targets.sceneTexture, targets.outputTexture, blurRadius);
+			displayTexture = targets.outputTexture;
+			break;
+		case FilterMode::fragmentBlur:
+			blurFragment(referenceShader, targets, quadVAO, blurRadius);
+			displayTexture = targets.outputTexture;
+			break;
+		case FilterMode::computeSharpen:
+			displayTexture = sharpenCompute(blurShader, unsharpShader, targets, blurRadius);
+			break;
+		case FilterMode::none:
+			break;
+		}
+		glEndQuery(GL_TIME_ELAPSED);
+		frameIndex++;
+
+		if (currentFrame - lastTitleTime > 1.0f && filterMsCount > 0)
+		{
+			const char* modeNames[] = {"no filter", "compute blur", "fragment blur", "compute sharpen"};
+			const std::string title = std::string("learn_opengl:framebuffers_compute_convolution - ") +
+									  modeNames[(int)filterMode] + ", radius " + std::to_string(blurRadius) + ", " +
+									  std::to_string(filterMsSum / filterMsCount) + " ms";
+			glfwSetWindowTitle(window, title.c_str());
+			filterMsSum = 0.0;
+			filterMsCount = 0;
+			lastTitleTime = currentFrame;
+		}
+
+		// now bind back to default framebuffer and draw a quad plane with the filtered texture
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, framebufferWidth, framebufferHeight);
+		glDisable(GL_DEPTH_TEST);
+		screenShader.use();
+		glBindVertexArray(quadVAO);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, displayTexture);
+		glDrawArrays(GL_TRIANGLES, 0, 6);
+		headless.end_frame(window);
+
+		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved
+		// etc.)
+		// -------------------------------------------------------------------------------
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+	}
+
+	destroyRenderTargets(targets);
+	glDeleteQueries(2, filterQueries);
+	glDeleteQueries(1, &benchmarkQuery);
+	glfwTerminate();
+	return headless.exit_code();
+}
+
+// process all input: query GLFW whether relevant keys are pressed/released this
+// frame and react accordingly
+// ---------------------------------------------------------------------------------------------------------
+void
+process_input(GLFWwindow* window)
+{
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+		glfwSetWindowShouldClose(window, true);
+
+	if (input.get_key(window, GLFW_KEY_W) == GLFW_PRESS)
+		camera.ProcessKeyboard(FORWARD, deltaTime);
+	if (input.get_key(window, GLFW_KEY_S) == GLFW_PRESS)
+		camera.ProcessKeyboard(BACKWARD, deltaTime);
+	if (input.get_key(window, GLFW_KEY_A) == GLFW_PRESS)
+		camera.ProcessKeyboard(LEFT, deltaTime);
+	if (input.get_key(window, GLFW_KEY_D) == GLFW_PRESS)
+		camera.ProcessKeyboard(RIGHT, deltaTime);
+
+	if (input.get_key(window, GLFW_KEY_1) == GLFW_PRESS)
+		filterMode = FilterMode::none;
+	if (input.get_key(window, GLFW_KEY_2) == GLFW_PRESS)
+		filterMode = FilterMode::computeBlur;
+	if (input.get_key(window, GLFW_KEY_3) == GLFW_PRESS)
+		filterMode = FilterMode::fragmentBlur;
+	if (input.get_key(window, GLFW_KEY_4) == GLFW_PRESS)
+		filterMode = FilterMode::computeSharpen;
+
+	// once per press
+	static bool upWasPressed = false, downWasPressed = false, benchmarkWasPressed = false;
+	const bool upPressed = input.get_key(window, GLFW_KEY_UP) == GLFW_PRESS;
+	const bool downPressed = input.get_key(window, GLFW_KEY_DOWN) == GLFW_PRESS;
+	const bool benchmarkPressed = input.get_key(window, GLFW_KEY_B) == GLFW_PRESS;
+	if (upPressed && !upWasPressed)
+		blurRadius = std::min(blurRadius * 2, MAX_RADIUS);
+	if (downPressed && !downWasPressed)
+		blurRadius = std::max(blurRadius / 2, 1);
+	if (benchmarkPressed && !benchmarkWasPressed)
+		benchmarkRequested = true;
+	upWasPressed = upPressed;
+	downWasPressed = downPressed;
+	benchmarkWasPressed = benchmarkPressed;
+}
+
+// glfw: whenever the window size changed (by OS or user resize) this callback
+// function executes
+// ---------------------------------------------------------------------------------------------
+void
+framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+	// the render targets follow the framebuffer size; note that width and height will be significantly larger than
+	// specified on retina displays. A minimized window reports 0 x 0.
+	if (width == 0 || height == 0)
+		return;
+	framebufferWidth = width;
+	framebufferHeight = height;
+	targetsDirty = true;
+}
+
+// glfw: whenever the mouse moves, this callback is called
+// -------------------------------------------------------
+void
+mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
+{
+	float xpos = static_cast<float>(xposIn);
+	float ypos = static_cast<float>(yposIn);
+	if (firstMouse)
+	{
+		lastX = xpos;
+		lastY = ypos;
+		firstMouse = false;
+	}
+
+	float xoffset = xpos - lastX;
+	float yoffset = lastY - ypos; // reversed since y-coordinates go from bottom to top
+
+	lastX = xpos;
+	lastY = ypos;
+
+	camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+// glfw: whenever the mouse scroll wheel scrolls, this callback is called
+// ----------------------------------------------------------------------
+void
+scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+	camera.ProcessMouseScroll(static_cast<float>(yoffset));
+}
+
+// utility function for loading a 2D texture from file
+// ---------------------------------------------------
+unsigned int
+loadTexture(char const* path)
+{
+	unsigned int textureID;
+	glGenTextures(1, &textureID);
+
+	int width, height, nrComponents;
+	unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
+	if (data)
+	{
+		GLenum format;
+		if (nrComponents == 1)
+			format = GL_RED;
+		else if (nrComponents == 3)
+			format = GL_RGB;
+		else if (nrComponents == 4)
+			format = GL_RGBA;
+
+		glBindTexture(GL_TEXTURE_2D, textureID);
+		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		stbi_image_free(data);
+	}
+	else
+	{
+		std::cout << "Texture failed to load at path: " << path << std::endl;
+		stbi_image_free(data);
+	}
+
+	return textureID;
+}
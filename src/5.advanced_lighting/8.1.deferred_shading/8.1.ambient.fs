@@ -0,0 +1,31 @@
+#version 330 core
+out vec4 FragColor;
+
+#include "gbuffer.glsl"
+#include "lighting.glsl"
+
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+
+uniform vec3 ambientColor;
+uniform vec3 sunDirection;
+uniform vec3 sunColor;
+uniform vec3 backgroundColor;
+
+// the full screen pass: the ambient term and a directional light, once per pixel whatever the overdraw was
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+    if (depth == 1.0)
+    {
+        FragColor = vec4(backgroundColor, 1.0);
+        return;
+    }
+
+    vec4 albedo = texelFetch(gAlbedo, pixel, 0);
+    vec3 normal = decode_normal(texelFetch(gNormal, pixel, 0).xy);
+    vec3 light = ambient_term(1.0, ambientColor) + diffuse_term(normal, -sunDirection, sunColor);
+    FragColor = vec4(albedo.rgb * light, 1.0);
+}
@@ -0,0 +1,19 @@
+#version 330 core
+layout(location = 0) out vec4 gAlbedo;
+layout(location = 1) out vec4 gNormal;
+
+in vec3 Normal;
+in vec2 TexCoords;
+
+#include "gbuffer.glsl"
+
+uniform sampler2D diffuseTexture;
+uniform float specularStrength;
+uniform float shininess;
+
+// no lighting here, only what the lighting passes need
+void main()
+{
+    gAlbedo = vec4(texture(diffuseTexture, TexCoords).rgb, specularStrength);
+    gNormal = vec4(encode_normal(normalize(Normal)), shininess / 256.0, 0.0);
+}
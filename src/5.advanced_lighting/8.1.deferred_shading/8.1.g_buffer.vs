@@ -0,0 +1,27 @@
+#version 330 core
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoords;
+
+out vec3 Normal;
+out vec2 TexCoords;
+
+#include "camera.glsl"
+
+uniform mat4 model;
+// the instances fill a gridSize.x x gridSize.y x gridSize.z grid, spacing apart, centered on the origin in x and z
+uniform ivec3 gridSize;
+uniform float spacing;
+
+void main()
+{
+    ivec3 cell = ivec3(gl_InstanceID % gridSize.x, gl_InstanceID / gridSize.x % gridSize.y,
+                       gl_InstanceID / (gridSize.x * gridSize.y));
+    vec3 offset = vec3(float(cell.x) - 0.5 * float(gridSize.x - 1), float(cell.y),
+                       float(cell.z) - 0.5 * float(gridSize.z - 1)) * spacing;
+    vec3 worldPos = vec3(model * vec4(aPos, 1.0)) + offset;
+    Normal = mat3(model) * aNormal;
+    TexCoords = aTexCoords;
+
+    gl_Position = camera.view_projection * vec4(worldPos, 1.0);
+}
@@ -0,0 +1,37 @@
+#version 330 core
+out vec4 FragColor;
+
+flat in vec4 Light;
+flat in vec3 LightColor;
+
+#include "gbuffer.glsl"
+#include "lighting.glsl"
+
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+
+// one point light on one pixel of the G-buffer, added to the light accumulation
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec3 position = world_position_from_depth(gl_FragCoord.xy * camera.viewport.zw, texelFetch(gDepth, pixel, 0).r);
+    vec3 toLight = Light.xyz - position;
+    float lightDistance = length(toLight);
+    // the volume covers the pixel, the surface behind it may still be out of reach
+    if (lightDistance >= Light.w)
+        discard;
+
+    vec4 albedo = texelFetch(gAlbedo, pixel, 0);
+    vec4 normalShininess = texelFetch(gNormal, pixel, 0);
+    vec3 normal = decode_normal(normalShininess.xy);
+    vec3 lightDir = toLight / lightDistance;
+    vec3 viewDir = normalize(camera.position.xyz - position);
+
+    // inverse square, windowed to reach zero at the radius of the volume
+    float window = clamp(1.0 - pow(lightDistance / Light.w, 4.0), 0.0, 1.0);
+    float attenuation = window * window / (lightDistance * lightDistance + 1.0);
+    vec3 diffuse = albedo.rgb * diffuse_term(normal, lightDir, LightColor);
+    vec3 specular = specular_term(normal, lightDir, viewDir, albedo.a, normalShininess.z * 256.0, LightColor);
+    FragColor = vec4((diffuse + specular) * attenuation, 1.0);
+}
@@ -0,0 +1,29 @@
+#version 330 core
+layout(location = 0) in vec3 aPos;
+#ifdef INSTANCED
+// one instance per light
+layout(location = 1) in vec4 aLight;
+layout(location = 2) in vec4 aLightColor;
+#else
+uniform vec4 light;
+uniform vec4 lightColor;
+#endif
+
+// xyz world space position, w radius
+flat out vec4 Light;
+flat out vec3 LightColor;
+
+#include "camera.glsl"
+
+// a unit sphere scaled to the radius of the light, the pixels it covers are the only ones the light can reach
+void main()
+{
+#ifdef INSTANCED
+    Light = aLight;
+    LightColor = aLightColor.rgb;
+#else
+    Light = light;
+    LightColor = lightColor.rgb;
+#endif
+    gl_Position = camera.view_projection * vec4(Light.xyz + aPos * Light.w, 1.0);
+}
@@ -0,0 +1,6 @@
+#version 330 core
+
+// the stencil pass of a light volume only counts faces, it writes no color
+void main()
+{
+}
@@ -0,0 +1,672 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <learnopengl/shader_library.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/camera_uniforms.h>
+#include <learnopengl/frame_graph.h>
+#include <learnopengl/post_process.h>
+#include <learnopengl/dynamic_resolution.h>
+#include <learnopengl/headless.h>
+#include <learnopengl/input_replay.h>
+#include <stb_image.h>
+
+#include <root_directory.h>
+
+const unsigned int SCR_WIDTH = 1280;
+const unsigned int SCR_HEIGHT = 720;
+
+// callback funcs
+void
+framebuffer_size_callback(GLFWwindow* window, int width, int height);
+
+void
+mouse_callback(GLFWwindow* window, double xpos, double ypos);
+
+void
+scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+
+void
+process_input(GLFWwindow* window);
+
+// load texture
+unsigned int
+loadTexture(const char* path);
+
+// unit sphere for the light volumes
+unsigned int
+createSphere(unsigned int& indexCount);
+
+// camera
+Camera camera(glm::vec3(0.0f, 10.0f, 32.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, -20.0f);
+float lastX = (float)SCR_WIDTH / 2.0;
+float lastY = (float)SCR_HEIGHT / 2.0;
+bool firstMouse = true;
+// keys, cursor and scroll go through it so a session can be recorded and replayed, see headless.h
+InputReplay input;
+
+// current framebuffer size, the frame graph sizes the G-buffer from it
+int framebufferWidth = SCR_WIDTH;
+int framebufferHeight = SCR_HEIGHT;
+
+// how the point lights are drawn, toggled with M
+enum class LightVolumes
+{
+	// two draws per light: the stencil marks the pixels whose surface lies inside the sphere, only those are lit
+	stencil,
+	// one instanced draw for all the lights: the back faces behind the surface, tested against the depth buffer
+	instanced,
+};
+LightVolumes lightVolumes = LightVolumes::stencil;
+
+// lights, doubled and halved with up and down
+const unsigned int MIN_LIGHTS = 16;
+const unsigned int MAX_LIGHTS = 4096;
+unsigned int lightCount = 256;
+
+// the scene: layers of crates on a floor, much of it hidden behind the first layer
+const glm::ivec3 CRATE_GRID(16, 3, 16);
+const float CRATE_SPACING = 2.5f;
+
+// timing
+float deltaTime = 0.0f;
+float lastFrame = 0.0f;
+
+// per light, as the instanced light volume reads it
+struct PointLight
+{
+	// xyz world space position, w radius
+	glm::vec4 position;
+	glm::vec4 color;
+};
+
+int
+main(int argc, char** argv)
+{
+	// --frames runs a fixed number of frames with a scripted camera in an invisible window, see headless.h
+	HeadlessRun headless(parse_headless_options(argc, argv));
+
+	// glfw: initialize and configure
+	// ------------------------------
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+	headless.apply_window_hints();
+
+	// glfw: window creation
+	// ------------------------------
+	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "learn_opengl:deferred_shading", NULL, NULL);
+	if (window == NULL)
+	{
+		std::cout << "glfw: failed to create window!\n";
+		glfwTerminate();
+		return -1;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	input.install(window, mouse_callback, scroll_callback);
+	if (!headless.configure_input(input))
+		return -1;
+
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+	// make sure that glad initilzed opengl funcs
+	// ------------------------------------------
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "glad: failed to initialize opengl funcs\n";
+		return -1;
+	}
+
+	// larger than the window size on retina displays
+	glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+
+	// build and compile shaders
+	// ------------------------------------------
+	// the point light shader with per light uniforms for the stencil volumes, with instance attributes otherwise
+	ShaderLibrary shaders((GLADloadproc)glfwGetProcAddress);
+	shaders.add_include_directory(std::string(logl_root) + "/resources/shaders");
+	const ShaderDefines instanced = {{"INSTANCED", ""}};
+	shaders.precompile("8.1.g_buffer.vs", "8.1.g_buffer.fs");
+	shaders.precompile("8.1.ambient.vs", "8.1.ambient.fs");
+	shaders.precompile("8.1.light_volume.vs", "8.1.stencil.fs");
+	shaders.precompile_all("8.1.light_volume.vs", "8.1.light_volume.fs", {{}, instanced});
+	Shader& gBufferShader = shaders.get("8.1.g_buffer.vs", "8.1.g_buffer.fs");
+	Shader& ambientShader = shaders.get("8.1.ambient.vs", "8.1.ambient.fs");
+	Shader& stencilShader = shaders.get("8.1.light_volume.vs", "8.1.stencil.fs");
+	Shader& lightShader = shaders.get("8.1.light_volume.vs", "8.1.light_volume.fs");
+	Shader& instancedLightShader = shaders.get("8.1.light_volume.vs", "8.1.light_volume.fs", instanced);
+
+	// every program reads the camera from one buffer, updated once per frame
+	CameraUniforms cameraUniforms;
+	for (Shader* shader : {&gBufferShader, &ambientShader, &stencilShader, &lightShader, &instancedLightShader})
+		CameraUniforms::bind_program(shader->ID);
+
+	// the G-buffer is read with texelFetch, one pixel per pixel
+	for (Shader* shader : {&ambientShader, &lightShader, &instancedLightShader})
+	{
+		shader->use();
+		shader->setInt("gAlbedo", 0);
+		shader->setInt("gNormal", 1);
+		shader->setInt("gDepth", 2);
+	}
+	gBufferShader.use();
+	gBufferShader.setInt("diffuseTexture", 0);
+
+	// set up vertex data (and buffer(s)) and configure vertex attributes
+	// ------------------------------------------------------------------
+	float cubeVertices[] = {
+		// back face
+		-0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.5f, 0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f,
+		0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.5f, 0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f,
+		-0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -0.5f, 0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f,
+		// front face
+		-0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f,
+		0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f,
+		-0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, -0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
+		// left face
+		-0.5f, 0.5f, 0.5f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, -0.5f, 0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, -0.5f, -0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
+		-0.5f, -0.5f, 0.5f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -0.5f, 0.5f, 0.5f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+		// right face
+		0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
+		0.5f, 0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
+		0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.5f, -0.5f, 0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+		// bottom face
+		-0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, 1.0f, 1.0f,
+		0.5f, -0.5f, 0.5f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.5f, -0.5f, 0.5f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f,
+		-0.5f, -0.5f, 0.5f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, -0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f,
+		// top face
+		-0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f,
+		0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f,
+		-0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, -0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f};
+	float quadVertices[] = {-1.0f, 1.0f, -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f, 1.0f};
+
+	// upload vertices data to gpu
+	//------------------------------------
+	// cube VAO
+	unsigned int cubeVAO, cubeVBO;
+	glGenVertexArrays(1, &cubeVAO);
+	glGenBuffers(1, &cubeVBO);
+	glBindVertexArray(cubeVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), &cubeVertices, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+	// screen quad VAO
+	unsigned int quadVAO, quadVBO;
+	glGenVertexArrays(1, &quadVAO);
+	glGenBuffers(1, &quadVBO);
+	glBindVertexArray(quadVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+	// sphere VAO, with the lights as instance attributes for the instanced volumes
+	unsigned int sphereIndexCount = 0;
+	unsigned int sphereVAO = createSphere(sphereIndexCount);
+	unsigned int lightVBO;
+	glGenBuffers(1, &lightVBO);
+	glBindVertexArray(sphereVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, lightVBO);
+	glBufferData(GL_ARRAY_BUFFER, MAX_LIGHTS * sizeof(PointLight), NULL, GL_STREAM_DRAW);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(PointLight), (void*)0);
+	glVertexAttribDivisor(1, 1);
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(PointLight), (void*)sizeof(glm::vec4));
+	glVertexAttribDivisor(2, 1);
+	glBindVertexArray(0);
+
+	// load textures
+	//_________________________
+	unsigned int crateTexture = loadTexture("../../resources/textures/container.jpg");
+	unsigned int floorTexture = loadTexture("../../resources/textures/metal.png");
+
+	// lights move up and down around random points between the crates
+	// -------------------------
+	std::mt19937 generator(1337);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	const float extent = 0.5f * CRATE_GRID.x * CRATE_SPACING;
+	std::vector<PointLight> lightOrigins(MAX_LIGHTS);
+	std::vector<PointLight> lights(MAX_LIGHTS);
+	for (PointLight& origin : lightOrigins)
+	{
+		origin.position = glm::vec4(
+			(unit(generator) * 2.0f - 1.0f) * extent,
+			unit(generator) * CRATE_GRID.y * CRATE_SPACING,
+			(unit(generator) * 2.0f - 1.0f) * extent,
+			2.0f + unit(generator) * 2.0f);
+		// a bright color, its phase in w
+		origin.color = glm::vec4(
+			glm::vec3(0.2f) + 0.8f * glm::vec3(unit(generator), unit(generator), unit(generator)),
+			unit(generator) * 6.2831853f);
+	}
+
+	// the G-buffer and the other render targets are declared per frame by the frame graph and recycled by this pool
+	// -------------------------
+	TransientResourcePool renderTargetPool;
+	PostProcessor postProcessor;
+
+	// the GPU times of the G-buffer and of the lighting, shown in the title
+	GpuTimer gBufferTimer;
+	GpuTimer lightingTimer;
+	uint64_t frameNumber = 0;
+	double gBufferMs = 0.0;
+	double lightingMs = 0.0;
+	float lastTitleTime = 0.0f;
+
+	// render loop
+	// -----------
+	while (!glfwWindowShouldClose(window))
+	{
+		// per-frame time logic
+		// --------------------
+		float currentFrame = static_cast<float>(glfwGetTime());
+		deltaTime = input.begin_frame(window, headless.frame_delta(currentFrame - lastFrame));
+		lastFrame = currentFrame;
+
+		// input
+		// -----
+		process_input(window);
+		headless.move_camera(camera, deltaTime);
+		input.update_camera(camera);
+
+		double measuredMs;
+		uint64_t measuredFrame;
+		while (gBufferTimer.poll(measuredMs, measuredFrame))
+			gBufferMs = measuredMs;
+		while (lightingTimer.poll(measuredMs, measuredFrame))
+			lightingMs = measuredMs;
+
+		// the lights move with the time, a headless run counts it in frames
+		const float time = headless.frame_time(currentFrame);
+		cameraUniforms.update(camera, framebufferWidth, framebufferHeight, time, deltaTime);
+
+		for (unsigned int i = 0; i < lightCount; i++)
+		{
+			const PointLight& origin = lightOrigins[i];
+			lights[i].position = origin.position + glm::vec4(0.0f, std::sin(time + origin.color.w), 0.0f, 0.0f);
+			lights[i].color = glm::vec4(glm::vec3(origin.color) * 4.0f, 0.0f);
+		}
+
+		// render
+		// ------
+		FrameGraph frameGraph(renderTargetPool);
+		FrameGraphResource backbuffer = frameGraph.import_backbuffer(framebufferWidth, framebufferHeight);
+		FrameGraphResource gAlbedo = -1, gNormal = -1, gDepth = -1, lightDepth = -1, lightAccumulation = -1;
+
+		// the geometry is drawn once into the G-buffer: whatever the overdraw, the lighting passes only see the
+		// nearest surface of every pixel
+		frameGraph.add_pass(
+			"g-buffer",
+			[&](FrameGraph::Builder& builder) {
+				gAlbedo = builder.create("albedo specular", {framebufferWidth, framebufferHeight, GL_RGBA8});
+				gNormal = builder.create("normal shininess", {framebufferWidth, framebufferHeight, GL_RGB10_A2});
+				gDepth = builder.create("depth", {framebufferWidth, framebufferHeight, GL_DEPTH24_STENCIL8});
+			},
+			[&](const FrameGraph&) {
+				gBufferTimer.begin(frameNumber);
+				glEnable(GL_DEPTH_TEST);
+				glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+				gBufferShader.use();
+				glBindVertexArray(cubeVAO);
+				glActiveTexture(GL_TEXTURE0);
+				// floor
+				glBindTexture(GL_TEXTURE_2D, floorTexture);
+				glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.55f, 0.0f));
+				model = glm::scale(model, glm::vec3(2.0f * extent + 10.0f, 0.1f, 2.0f * extent + 10.0f));
+				gBufferShader.setMat4("model", model);
+				gBufferShader.setIVec3("gridSize", 1, 1, 1);
+				gBufferShader.setFloat("spacing", 0.0f);
+				gBufferShader.setFloat("specularStrength", 0.8f);
+				gBufferShader.setFloat("shininess", 64.0f);
+				glDrawArrays(GL_TRIANGLES, 0, 36);
+				// crates, in one instanced draw
+				glBindTexture(GL_TEXTURE_2D, crateTexture);
+				gBufferShader.setMat4("model", glm::mat4(1.0f));
+				gBufferShader.setIVec3("gridSize", CRATE_GRID.x, CRATE_GRID.y, CRATE_GRID.z);
+				gBufferShader.setFloat("spacing", CRATE_SPACING);
+				gBufferShader.setFloat("specularStrength", 0.2f);
+				gBufferShader.setFloat("shininess", 16.0f);
+				glDrawArraysInstanced(GL_TRIANGLES, 0, 36, CRATE_GRID.x * CRATE_GRID.y * CRATE_GRID.z);
+				glBindVertexArray(0);
+				gBufferTimer.end();
+			});
+
+		// the light volumes test against the depth while reading it for the positions. Sampling a texture attached
+		// to the framebuffer is a feedback loop, so they test against a copy
+		frameGraph.add_pass(
+			"copy depth",
+			[&](FrameGraph::Builder& builder) {
+				builder.read(gDepth);
+				lightDepth = builder.create("light depth", {framebufferWidth, framebufferHeight, GL_DEPTH24_STENCIL8});
+			},
+			[&](const FrameGraph& graph) {
+				GLint target = 0;
+				glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+				const GLuint source = renderTargetPool.get_framebuffer({}, graph.get_texture(gDepth), GL_DEPTH24_STENCIL8);
+				glBindFramebuffer(GL_READ_FRAMEBUFFER, source);
+				glBindFramebuffer(GL_DRAW_FRAMEBUFFER, GLuint(target));
+				glBlitFramebuffer(
+					0,
+					0,
+					framebufferWidth,
+					framebufferHeight,
+					0,
+					0,
+					framebufferWidth,
+					framebufferHeight,
+					GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT,
+					GL_NEAREST);
+			});
+
+		// lighting in screen space: a full screen pass for the ambient and the sun, then the point lights added over
+		// the pixels of their volumes; the cost follows the pixels times the lights, not the overdraw
+		frameGraph.add_pass(
+			"lighting",
+			[&](FrameGraph::Builder& builder) {
+				builder.read(gAlbedo);
+				builder.read(gNormal);
+				builder.read(gDepth);
+				lightAccumulation =
+					builder.create("light accumulation", {framebufferWidth, framebufferHeight, GL_RGBA16F});
+				// tested against rather than only written, or the copy would be culled as unread
+				builder.read(lightDepth);
+				builder.write(lightDepth);
+			},
+			[&](const FrameGraph& graph) {
+				lightingTimer.begin(frameNumber);
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, graph.get_texture(gAlbedo));
+				glActiveTexture(GL_TEXTURE1);
+				glBindTexture(GL_TEXTURE_2D, graph.get_texture(gNormal));
+				glActiveTexture(GL_TEXTURE2);
+				glBindTexture(GL_TEXTURE_2D, graph.get_texture(gDepth));
+
+				glDisable(GL_DEPTH_TEST);
+				ambientShader.use();
+				ambientShader.setVec3("ambientColor", glm::vec3(0.03f));
+				ambientShader.setVec3("sunDirection", glm::normalize(glm::vec3(-0.3f, -1.0f, -0.5f)));
+				ambientShader.setVec3("sunColor", glm::vec3(0.05f, 0.05f, 0.08f));
+				ambientShader.setVec3("backgroundColor", glm::vec3(0.01f));
+				glBindVertexArray(quadVAO);
+				glDrawArrays(GL_TRIANGLES, 0, 6);
+
+				glEnable(GL_BLEND);
+				glBlendFunc(GL_ONE, GL_ONE);
+				glDepthMask(GL_FALSE);
+				glEnable(GL_DEPTH_TEST);
+				glEnable(GL_CULL_FACE);
+				glBindVertexArray(sphereVAO);
+				if (lightVolumes == LightVolumes::stencil)
+				{
+					glEnable(GL_STENCIL_TEST);
+					for (unsigned int i = 0; i < lightCount; i++)
+					{
+						// front faces behind the surface (depth fail) decrement, back faces behind it increment:
+						// what is left is not zero where the surface is inside the sphere, even with the camera inside
+						stencilShader.use();
+						stencilShader.setVec4("light", lights[i].position);
+						glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+						glEnable(GL_DEPTH_TEST);
+						glDisable(GL_CULL_FACE);
+						glStencilFunc(GL_ALWAYS, 0, 0);
+						glStencilOpSeparate(GL_BACK, GL_KEEP, GL_INCR_WRAP, GL_KEEP);
+						glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
+						glDrawElements(GL_TRIANGLES, sphereIndexCount, GL_UNSIGNED_INT, 0);
+
+						// the back faces cover every marked pixel once, and clear the mark for the next light
+						lightShader.use();
+						lightShader.setVec4("light", lights[i].position);
+						lightShader.setVec4("lightColor", lights[i].color);
+						glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+						glDisable(GL_DEPTH_TEST);
+						glEnable(GL_CULL_FACE);
+						glCullFace(GL_FRONT);
+						glStencilFunc(GL_NOTEQUAL, 0, 0xFF);
+						glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+						glDrawElements(GL_TRIANGLES, sphereIndexCount, GL_UNSIGNED_INT, 0);
+						glCullFace(GL_BACK);
+					}
+					glDisable(GL_STENCIL_TEST);
+				}
+				else
+				{
+					// the back faces behind the surface: also passes for surfaces in front of the sphere, which the
+					// distance test of the shader then discards
+					glBindBuffer(GL_ARRAY_BUFFER, lightVBO);
+					glBufferSubData(GL_ARRAY_BUFFER, 0, lightCount * sizeof(PointLight), lights.data());
+					instancedLightShader.use();
+					glDepthFunc(GL_GEQUAL);
+					glCullFace(GL_FRONT);
+					glDrawElementsInstanced(GL_TRIANGLES, sphereIndexCount, GL_UNSIGNED_INT, 0, lightCount);
+					glCullFace(GL_BACK);
+					glDepthFunc(GL_LESS);
+				}
+				glBindVertexArray(0);
+				glDisable(GL_CULL_FACE);
+				glDepthMask(GL_TRUE);
+				glDisable(GL_BLEND);
+				glActiveTexture(GL_TEXTURE0);
+				lightingTimer.end();
+			});
+
+		// the accumulated light is tonemapped to the default framebuffer
+		postProcessor.add_passes(frameGraph, {PostEffect::tonemap}, lightAccumulation, backbuffer);
+
+		frameGraph.compile();
+		frameGraph.execute();
+		frameNumber++;
+		headless.end_frame(window);
+
+		if (currentFrame - lastTitleTime > 1.0f)
+		{
+			const std::string title = "learn_opengl:deferred_shading - " + std::to_string(lightCount) + " lights, " +
+									  (lightVolumes == LightVolumes::stencil ? "stencil" : "instanced") +
+									  " volumes, g-buffer " + std::to_string(gBufferMs).substr(0, 5) +
+									  " ms, lighting " + std::to_string(lightingMs).substr(0, 5) + " ms";
+			glfwSetWindowTitle(window, title.c_str());
+			lastTitleTime = currentFrame;
+		}
+
+		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+		// -------------------------------------------------------------------------------
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+	}
+
+	// optional: de-allocate all resources once they've outlived their purpose:
+	// ------------------------------------------------------------------------
+	glDeleteVertexArrays(1, &cubeVAO);
+	glDeleteVertexArrays(1, &quadVAO);
+	glDeleteVertexArrays(1, &sphereVAO);
+	glDeleteBuffers(1, &cubeVBO);
+	glDeleteBuffers(1, &quadVBO);
+	glDeleteBuffers(1, &lightVBO);
+
+	glfwTerminate();
+	return headless.exit_code();
+}
+
+// process all input: query GLFW whether relevant keys are pressed/released this
+// frame and react accordingly
+// ---------------------------------------------------------------------------------------------------------
+void
+process_input(GLFWwindow* window)
+{
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+		glfwSetWindowShouldClose(window, true);
+
+	if (input.get_key(window, GLFW_KEY_W) == GLFW_PRESS)
+		camera.ProcessKeyboard(FORWARD, deltaTime * 10.0f);
+	if (input.get_key(window, GLFW_KEY_S) == GLFW_PRESS)
+		camera.ProcessKeyboard(BACKWARD, deltaTime * 10.0f);
+	if (input.get_key(window, GLFW_KEY_A) == GLFW_PRESS)
+		camera.ProcessKeyboard(LEFT, deltaTime * 10.0f);
+	if (input.get_key(window, GLFW_KEY_D) == GLFW_PRESS)
+		camera.ProcessKeyboard(RIGHT, deltaTime * 10.0f);
+
+	static bool modeWasPressed = false, upWasPressed = false, downWasPressed = false;
+	const bool modePressed = input.get_key(window, GLFW_KEY_M) == GLFW_PRESS;
+	const bool upPressed = input.get_key(window, GLFW_KEY_UP) == GLFW_PRESS;
+	const bool downPressed = input.get_key(window, GLFW_KEY_DOWN) == GLFW_PRESS;
+	if (modePressed && !modeWasPressed)
+		lightVolumes = lightVolumes == LightVolumes::stencil ? LightVolumes::instanced : LightVolumes::stencil;
+	if (upPressed && !upWasPressed && lightCount < MAX_LIGHTS)
+		lightCount *= 2;
+	if (downPressed && !downWasPressed && lightCount > MIN_LIGHTS)
+		lightCount /= 2;
+	modeWasPressed = modePressed;
+	upWasPressed = upPressed;
+	downWasPressed = downPressed;
+}
+
+// glfw: whenever the window size changed (by OS or user resize) this callback
+// function executes
+// ---------------------------------------------------------------------------------------------
+void
+framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+	// the frame graph sets the viewport of every pass, it only needs the new size. A minimized window reports 0 x 0.
+	if (width == 0 || height == 0)
+		return;
+	framebufferWidth = width;
+	framebufferHeight = height;
+}
+
+// glfw: whenever the mouse moves, this callback is called
+// -------------------------------------------------------
+void
+mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
+{
+	float xpos = static_cast<float>(xposIn);
+	float ypos = static_cast<float>(yposIn);
+	if (firstMouse)
+	{
+		lastX = xpos;
+		lastY = ypos;
+		firstMouse = false;
+	}
+
+	float xoffset = xpos - lastX;
+	float yoffset = lastY - ypos; // reversed since y-coordinates go from bottom to top
+
+	lastX = xpos;
+	lastY = ypos;
+
+	camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+// glfw: whenever the mouse scroll wheel scrolls, this callback is called
+// ----------------------------------------------------------------------
+void
+scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+	camera.ProcessMouseScroll(static_cast<float>(yoffset));
+}
+
+// a UV sphere of radius one, enlarged so its flat faces still contain the unit sphere, as indexed triangles
+// -------------------------------------------------------------------------------------------------------------
+unsigned int
+createSphere(unsigned int& indexCount)
+{
+	const unsigned int stacks = 8;
+	const unsigned int slices = 16;
+	const float pi = 3.14159265359f;
+	const float scale = 1.0f / (std::cos(pi / slices) * std::cos(pi / (2.0f * stacks)));
+
+	std::vector<float> positions;
+	for (unsigned int stack = 0; stack <= stacks; stack++)
+	{
+		const float phi = pi * stack / stacks;
+		for (unsigned int slice = 0; slice <= slices; slice++)
+		{
+			const float theta = 2.0f * pi * slice / slices;
+			positions.push_back(scale * std::sin(phi) * std::cos(theta));
+			positions.push_back(scale * std::cos(phi));
+			positions.push_back(scale * std::sin(phi) * std::sin(theta));
+		}
+	}
+	// counter-clockwise seen from outside
+	std::vector<unsigned int> indices;
+	for (unsigned int stack = 0; stack < stacks; stack++)
+	{
+		for (unsigned int slice = 0; slice < slices; slice++)
+		{
+			const unsigned int first = stack * (slices + 1) + slice;
+			const unsigned int second = first + slices + 1;
+			indices.insert(indices.end(), {first, first + 1, second, second, first + 1, second + 1});
+		}
+	}
+	indexCount = unsigned(indices.size());
+
+	unsigned int VAO, VBO, EBO;
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &VBO);
+	glGenBuffers(1, &EBO);
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(float), positions.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+	glBindVertexArray(0);
+	return VAO;
+}
+
+// utility function for loading a 2D texture from file
+// ---------------------------------------------------
+unsigned int
+loadTexture(char const* path)
+{
+	unsigned int textureID;
+	glGenTextures(1, &textureID);
+
+	int width, height, nrComponents;
+	unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
+	if (data)
+	{
+		GLenum format;
+		if (nrComponents == 1)
+			format = GL_RED;
+		else if (nrComponents == 3)
+			format = GL_RGB;
+		else if (nrComponents == 4)
+			format = GL_RGBA;
+
+		glBindTexture(GL_TEXTURE_2D, textureID);
+		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		stbi_image_free(data);
+	}
+	else
+	{
+		std::cout << "Texture failed to load at path: " << path << std::endl;
+		stbi_image_free(data);
+	}
+
+	return textureID;
+}
@@ -0,0 +1,10 @@
+#version 330 core
+in vec4 Color;
+in float ViewDepth;
+
+out vec4 FragColor;
+
+// plain alpha blending in submission order, for comparison with the weighted blended pass
+void main() {
+	FragColor = Color;
+}
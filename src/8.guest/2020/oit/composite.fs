@@ -0,0 +1,33 @@
+#version 330 core
+layout(location = 0) out vec4 FragColor;
+
+uniform sampler2D accum;
+uniform sampler2D reveal;
+
+const float EPSILON = 0.00001;
+
+bool is_approximately_equal(float a, float b) {
+	return abs(a - b) <= max(abs(a), abs(b)) * EPSILON;
+}
+
+float max3(vec3 v) {
+	return max(max(v.x, v.y), v.z);
+}
+
+void main() {
+	ivec2 coords = ivec2(gl_FragCoord.xy);
+
+	// nothing transparent covers this pixel
+	float revealage = texelFetch(reveal, coords, 0).r;
+	if (is_approximately_equal(revealage, 1.0))
+		discard;
+
+	// the half float sum can overflow when many bright surfaces overlap
+	vec4 accumulation = texelFetch(accum, coords, 0);
+	if (isinf(max3(abs(accumulation.rgb))))
+		accumulation.rgb = vec3(accumulation.a);
+
+	// weighted average of the colors, blended over the opaque image with GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA
+	vec3 average_color = accumulation.rgb / max(accumulation.a, EPSILON);
+	FragColor = vec4(average_color, 1.0 - revealage);
+}
@@ -0,0 +1,12 @@
+#version 330 core
+in vec3 WorldPos;
+out vec4 FragColor;
+
+uniform vec3 color;
+
+void main() {
+	// flat face normal from the screen space derivatives, enough to tell the faces apart
+	vec3 normal = normalize(cross(dFdx(WorldPos), dFdy(WorldPos)));
+	float diffuse = max(dot(normal, normalize(vec3(0.4, 1.0, 0.6))), 0.0);
+	FragColor = vec4(color * (0.3 + 0.7 * diffuse), 1.0);
+}
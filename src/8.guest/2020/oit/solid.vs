@@ -0,0 +1,14 @@
+#version 330 core
+layout(location = 0) in vec3 aPos;
+
+out vec3 WorldPos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main() {
+	vec4 world_pos = model * vec4(aPos, 1.0);
+	WorldPos = world_pos.xyz;
+	gl_Position = projection * view * world_pos;
+}
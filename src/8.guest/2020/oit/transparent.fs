@@ -0,0 +1,18 @@
+#version 330 core
+in vec4 Color;
+in float ViewDepth;
+
+// sum of the weighted premultiplied colors, alpha holds the sum of the weights
+layout(location = 0) out vec4 accum;
+// product of (1 - alpha), blended with GL_ZERO, GL_ONE_MINUS_SRC_COLOR
+layout(location = 1) out float reveal;
+
+void main() {
+	// depth weight of McGuire and Bavoil, equation 10: nearer and more opaque surfaces dominate the average.
+	// The clamp keeps the sum inside the range of a half float target.
+	float z = ViewDepth;
+	float weight = Color.a * clamp(10.0 / (1e-5 + pow(z / 5.0, 2.0) + pow(z / 200.0, 6.0)), 1e-2, 3e3);
+
+	accum = vec4(Color.rgb * Color.a, Color.a) * weight;
+	reveal = Color.a;
+}
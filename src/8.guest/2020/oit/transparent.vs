@@ -0,0 +1,18 @@
+#version 330 core
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec4 aColor;
+// per instance, takes locations 2 to 5
+layout(location = 2) in mat4 aModel;
+
+out vec4 Color;
+out float ViewDepth;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main() {
+	vec4 view_pos = view * aModel * vec4(aPos, 1.0);
+	Color = aColor;
+	ViewDepth = -view_pos.z;
+	gl_Position = projection * view_pos;
+}
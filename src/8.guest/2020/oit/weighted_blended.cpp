@@ -0,0 +1,531 @@
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <learnopengl/shader_manager.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/headless.h>
+#include <learnopengl/input_replay.h>
+
+// Weighted blended order independent transparency (McGuire and Bavoil, JCGT 2013). The transparent quads are drawn
+// with one instanced call, in any order and without a CPU sort: every fragment adds its weighted color to an
+// accumulation target and multiplies its coverage into a revealage target. A full screen pass then divides the sum by
+// the weights and blends the average over the opaque image. Press space to compare with plain unsorted blending.
+
+void
+framebuffer_size_callback(GLFWwindow* window, int width, int height);
+
+void
+mouse_callback(GLFWwindow* window, double xpos, double ypos);
+
+void
+scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+
+void
+process_input(GLFWwindow* window);
+
+// settings
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+
+// current framebuffer size, the render targets follow it
+int framebuffer_width = SCR_WIDTH;
+int framebuffer_height = SCR_HEIGHT;
+bool targets_dirty = true;
+
+// camera
+Camera camera(glm::vec3(0.0f, 1.0f, 8.0f));
+float lastX = SCR_WIDTH / 2.0f;
+float lastY = SCR_HEIGHT / 2.0f;
+bool firstMouse = true;
+// keys, cursor and scroll go through it so a session can be recorded and replayed, see headless.h
+InputReplay input;
+
+// timing
+float delta_time = 0.0f;
+float last_frame = 0.0f;
+
+// space toggles between the weighted blended pass and unsorted alpha blending
+bool use_oit = true;
+
+struct QuadInstance
+{
+	glm::vec4 color;
+	glm::mat4 model;
+};
+
+// opaque color and depth, plus the two transparent targets sharing that depth buffer
+struct RenderTargets
+{
+	unsigned int opaque_fbo = 0;
+	unsigned int transparent_fbo = 0;
+	unsigned int opaque_texture = 0;
+	unsigned int depth_rbo = 0;
+	unsigned int accum_texture = 0;
+	unsigned int reveal_texture = 0;
+};
+
+static unsigned int
+create_target_texture(GLint internal_format, GLenum format, GLenum type, int width, int height)
+{
+	unsigned int texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format, type, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return texture;
+}
+
+static void
+destroy_render_targets(RenderTargets& targets)
+{
+	glDeleteFramebuffers(1, &targets.opaque_fbo);
+	glDeleteFramebuffers(1, &targets.transparent_fbo);
+	glDeleteTextures(1, &targets.opaque_texture);
+	glDeleteTextures(1, &targets.accum_texture);
+	glDeleteTextures(1, &targets.reveal_texture);
+	glDeleteRenderbuffers(1, &targets.depth_rbo);
+	targets = RenderTargets{};
+}
+
+static void
+create_render_targets(RenderTargets& targets, int width, int height)
+{
+	destroy_render_targets(targets);
+
+	glGenRenderbuffers(1, &targets.depth_rbo);
+	glBindRenderbuffer(GL_RENDERBUFFER, targets.depth_rbo);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	// half float so the composite can blend before the conversion to the window format
+	targets.opaque_texture = create_target_texture(GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, width, height);
+	glGenFramebuffers(1, &targets.opaque_fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, targets.opaque_fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, targets.opaque_texture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, targets.depth_rbo);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::FRAMEBUFFER:: Opaque framebuffer is not complete!" << std::endl;
+
+	// the weighted sums need the range of a float target, revealage is a product of values in [0, 1]
+	targets.accum_texture = create_target_texture(GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, width, height);
+	targets.reveal_texture = create_target_texture(GL_R8, GL_RED, GL_UNSIGNED_BYTE, width, height);
+	glGenFramebuffers(1, &targets.transparent_fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, targets.transparent_fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, targets.accum_texture, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, targets.reveal_texture, 0);
+	// transparent surfaces are still hidden by the opaque ones in front of them
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, targets.depth_rbo);
+	const GLenum draw_buffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+	glDrawBuffers(2, draw_buffers);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::FRAMEBUFFER:: Transparent framebuffer is not complete!" << std::endl;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// intersecting quads of random colors, rotations and opacities; no order gives a correct result for these
+static std::vector<QuadInstance>
+create_quad_instances(size_t count)
+{
+	std::mt19937 rng(2020);
+	std::uniform_real_distribution<float> position(-4.0f, 4.0f);
+	std::uniform_real_distribution<float> height(0.0f, 3.0f);
+	std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::uniform_real_distribution<float> opacity(0.25f, 0.75f);
+
+	std::vector<QuadInstance> instances(count);
+	for (auto&& instance : instances)
+	{
+		instance.color = glm::vec4(unit(rng), unit(rng), unit(rng), opacity(rng));
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(position(rng), height(rng), position(rng)));
+		const glm::vec3 axis = glm::normalize(glm::vec3(unit(rng) - 0.5f, unit(rng) - 0.5f, unit(rng) - 0.5f) + 1e-3f);
+		model = glm::rotate(model, glm::radians(angle(rng)), axis);
+		instance.model = glm::scale(model, glm::vec3(0.5f + unit(rng)));
+	}
+	return instances;
+}
+
+int
+main(int argc, char** argv)
+{
+	// --frames runs a fixed number of frames with a scripted camera in an invisible window, see headless.h
+	HeadlessRun headless(parse_headless_options(argc, argv));
+
+	// glfw: initialize and configure
+	// ------------------------------
+	glfwInit();
+	// glBlendFunci, a different blend function per draw buffer, is core since 4.0
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+	headless.apply_window_hints();
+
+	// glfw window creation
+	// --------------------
+	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "learn_opengl:weighted_blended_oit", NULL, NULL);
+	if (window == NULL)
+	{
+		std::cout << "Failed to create GLFW window" << std::endl;
+		glfwTerminate();
+		return -1;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	input.install(window, mouse_callback, scroll_callback);
+	if (!headless.configure_input(input))
+		return -1;
+
+	// tell GLFW to capture our mouse
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+	// glad: load all OpenGL function pointers
+	// ---------------------------------------
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return -1;
+	}
+
+	// larger than SCR_WIDTH x SCR_HEIGHT on retina displays
+	glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+
+	// build and compile shaders: all of them are submitted before any is checked, so the driver can compile them in
+	// parallel while the buffers are set up, and the blended one is only checked if it is ever toggled on
+	// ---------------------------------------------------------------------------------------------------------------
+	ShaderManager shaders((GLADloadproc)glfwGetProcAddress);
+	const ShaderManager::Handle solid_program = shaders.submit("solid.vs", "solid.fs");
+	const ShaderManager::Handle transparent_program = shaders.submit("transparent.vs", "transparent.fs");
+	const ShaderManager::Handle blended_program = shaders.submit("transparent.vs", "blended.fs");
+	const ShaderManager::Handle composite_program = shaders.submit("composite.vs", "composite.fs");
+
+	// set up vertex data (and buffer(s)) and configure vertex attributes
+	// ------------------------------------------------------------------
+	float cube_vertices[] = {
+		// positions          // texture Coords
+		-0.5f, -0.5f, -0.5f, 0.0f, 0.0f, 0.5f,	-0.5f, -0.5f, 1.0f, 0.0f, 0.5f,	 0.5f,	-0.5f, 1.0f, 1.0f,
+		0.5f,  0.5f,  -0.5f, 1.0f, 1.0f, -0.5f, 0.5f,  -0.5f, 0.0f, 1.0f, -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
+
+		-0.5f, -0.5f, 0.5f,	 0.0f, 0.0f, 0.5f,	-0.5f, 0.5f,  1.0f, 0.0f, 0.5f,	 0.5f,	0.5f,  1.0f, 1.0f,
+		0.5f,  0.5f,  0.5f,	 1.0f, 1.0f, -0.5f, 0.5f,  0.5f,  0.0f, 1.0f, -0.5f, -0.5f, 0.5f,  0.0f, 0.0f,
+
+		-0.5f, 0.5f,  0.5f,	 1.0f, 0.0f, -0.5f, 0.5f,  -0.5f, 1.0f, 1.0f, -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+		-0.5f, -0.5f, -0.5f, 0.0f, 1.0f, -0.5f, -0.5f, 0.5f,  0.0f, 0.0f, -0.5f, 0.5f,	0.5f,  1.0f, 0.0f,
+
+		0.5f,  0.5f,  0.5f,	 1.0f, 0.0f, 0.5f,	0.5f,  -0.5f, 1.0f, 1.0f, 0.5f,	 -0.5f, -0.5f, 0.0f, 1.0f,
+		0.5f,  -0.5f, -0.5f, 0.0f, 1.0f, 0.5f,	-0.5f, 0.5f,  0.0f, 0.0f, 0.5f,	 0.5f,	0.5f,  1.0f, 0.0f,
+
+		-0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 0.5f,	-0.5f, -0.5f, 1.0f, 1.0f, 0.5f,	 -0.5f, 0.5f,  1.0f, 0.0f,
+		0.5f,  -0.5f, 0.5f,	 1.0f, 0.0f, -0.5f, -0.5f, 0.5f,  0.0f, 0.0f, -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+
+		-0.5f, 0.5f,  -0.5f, 0.0f, 1.0f, 0.5f,	0.5f,  -0.5f, 1.0f, 1.0f, 0.5f,	 0.5f,	0.5f,  1.0f, 0.0f,
+		0.5f,  0.5f,  0.5f,	 1.0f, 0.0f, -0.5f, 0.5f,  0.5f,  0.0f, 0.0f, -0.5f, 0.5f,	-0.5f, 0.0f, 1.0f};
+	float quad_vertices[] = {
+		// positions
+		-0.5f, -0.5f, 0.0f, 0.5f, -0.5f, 0.0f, 0.5f, 0.5f, 0.0f,
+		0.5f,  0.5f,  0.0f, -0.5f, 0.5f, 0.0f, -0.5f, -0.5f, 0.0f};
+	float screen_vertices[] = {
+		// positions in normalized device coordinates
+		-1.0f, 1.0f, -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f, 1.0f};
+
+	// cube VAO
+	unsigned int cube_vao, cube_vbo;
+	glGenVertexArrays(1, &cube_vao);
+	glGenBuffers(1, &cube_vbo);
+	glBindVertexArray(cube_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, cube_vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), cube_vertices, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+
+	// instanced quad VAO: the positions per vertex, color and model matrix per instance
+	const std::vector<QuadInstance> instances = create_quad_instances(1000);
+	unsigned int quad_vao, quad_vbo, instance_vbo;
+	glGenVertexArrays(1, &quad_vao);
+	glGenBuffers(1, &quad_vbo);
+	glGenBuffers(1, &instance_vbo);
+	glBindVertexArray(quad_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(quad_vertices), quad_vertices, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+	glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+	glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(QuadInstance), instances.data(), GL_STATIC_DRAW);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(QuadInstance), (void*)offsetof(QuadInstance, color));
+	glVertexAttribDivisor(1, 1);
+	// a mat4 attribute takes four vec4 locations
+	for (unsigned int column = 0; column < 4; ++column)
+	{
+		glEnableVertexAttribArray(2 + column);
+		glVertexAttribPointer(
+			2 + column,
+			4,
+			GL_FLOAT,
+			GL_FALSE,
+			sizeof(QuadInstance),
+			(void*)(offsetof(QuadInstance, model) + column * sizeof(glm::vec4)));
+		glVertexAttribDivisor(2 + column, 1);
+	}
+
+	// screen quad VAO
+	unsigned int screen_vao, screen_vbo;
+	glGenVertexArrays(1, &screen_vao);
+	glGenBuffers(1, &screen_vbo);
+	glBindVertexArray(screen_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, screen_vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(screen_vertices), screen_vertices, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+	glBindVertexArray(0);
+
+	RenderTargets targets;
+
+	const glm::vec4 zero_color(0.0f);
+	const glm::vec4 one_color(1.0f);
+
+	// render loop
+	// -----------
+	while (!glfwWindowShouldClose(window))
+	{
+		// per-frame time logic
+		// --------------------
+		float current_frame = static_cast<float>(glfwGetTime());
+		delta_time = input.begin_frame(window, headless.frame_delta(current_frame - last_frame));
+		last_frame = current_frame;
+
+		// input
+		// -----
+		process_input(window);
+		headless.move_camera(camera, delta_time);
+		input.update_camera(camera);
+
+		if (targets_dirty)
+		{
+			create_render_targets(targets, framebuffer_width, framebuffer_height);
+			targets_dirty = false;
+		}
+
+		glm::mat4 projection = glm::perspective(
+			glm::radians(camera.Zoom),
+			(float)framebuffer_width / (float)framebuffer_height,
+			0.1f,
+			100.0f);
+		glm::mat4 view = camera.GetViewMatrix();
+
+		// solid pass: opaque geometry with depth writes
+		// ---------------------------------------------
+		glBindFramebuffer(GL_FRAMEBUFFER, targets.opaque_fbo);
+		glViewport(0, 0, framebuffer_width, framebuffer_height);
+		glEnable(GL_DEPTH_TEST);
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_TRUE);
+		glDisable(GL_BLEND);
+		glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		Shader& solid_shader = shaders.get(solid_program);
+		solid_shader.use();
+		solid_shader.setMat4("projection", projection);
+		solid_shader.setMat4("view", view);
+		glBindVertexArray(cube_vao);
+		// floor
+		solid_shader.setMat4(
+			"model",
+			glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.75f, 0.0f)), glm::vec3(12.0f, 0.5f, 12.0f)));
+		solid_shader.setVec3("color", glm::vec3(0.6f));
+		glDrawArrays(GL_TRIANGLES, 0, 36);
+		// a few pillars poking through the transparent cloud
+		const glm::vec3 pillars[] = {{-2.0f, 1.0f, -2.0f}, {2.5f, 1.0f, 0.5f}, {-0.5f, 1.0f, 2.5f}};
+		for (const glm::vec3& pillar : pillars)
+		{
+			solid_shader.setMat4(
+				"model",
+				glm::scale(glm::translate(glm::mat4(1.0f), pillar), glm::vec3(0.75f, 3.0f, 0.75f)));
+			solid_shader.setVec3("color", glm::vec3(0.8f, 0.5f, 0.3f));
+			glDrawArrays(GL_TRIANGLES, 0, 36);
+		}
+
+		// transparent pass: one instanced draw in buffer order, depth tested against the opaque scene but not written
+		// -----------------------------------------------------------------------------------------------------------
+		glDepthMask(GL_FALSE);
+		glEnable(GL_BLEND);
+		if (use_oit)
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, targets.transparent_fbo);
+			// accumulation starts empty, revealage starts fully visible
+			glClearBufferfv(GL_COLOR, 0, &zero_color[0]);
+			glClearBufferfv(GL_COLOR, 1, &one_color[0]);
+			// accum += color, reveal *= (1 - alpha)
+			glBlendFunci(0, GL_ONE, GL_ONE);
+			glBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+			glBlendEquation(GL_FUNC_ADD);
+
+			Shader& transparent_shader = shaders.get(transparent_program);
+			transparent_shader.use();
+			transparent_shader.setMat4("projection", projection);
+			transparent_shader.setMat4("view", view);
+		}
+		else
+		{
+			// the same draw straight into the opaque target, only correct if the instances happened to be sorted
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			Shader& blended_shader = shaders.get(blended_program);
+			blended_shader.use();
+			blended_shader.setMat4("projection", projection);
+			blended_shader.setMat4("view", view);
+		}
+		glBindVertexArray(quad_vao);
+		glDrawArraysInstanced(GL_TRIANGLES, 0, 6, (GLsizei)instances.size());
+
+		// composite pass: weighted average of the transparent surfaces over the opaque image
+		// ----------------------------------------------------------------------------------
+		if (use_oit)
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, targets.opaque_fbo);
+			glDisable(GL_DEPTH_TEST);
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+			Shader& composite_shader = shaders.get(composite_program);
+			composite_shader.use();
+			composite_shader.setInt("accum", 0);
+			composite_shader.setInt("reveal", 1);
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, targets.accum_texture);
+			glActiveTexture(GL_TEXTURE1);
+			glBindTexture(GL_TEXTURE_2D, targets.reveal_texture);
+			glBindVertexArray(screen_vao);
+			glDrawArrays(GL_TRIANGLES, 0, 6);
+		}
+
+		// copy the result to the window
+		// -----------------------------
+		glDisable(GL_BLEND);
+		glDepthMask(GL_TRUE);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, targets.opaque_fbo);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		glBlitFramebuffer(
+			0,
+			0,
+			framebuffer_width,
+			framebuffer_height,
+			0,
+			0,
+			framebuffer_width,
+			framebuffer_height,
+			GL_COLOR_BUFFER_BIT,
+			GL_NEAREST);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		headless.end_frame(window);
+
+		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+		// -------------------------------------------------------------------------------
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+	}
+
+	// optional: de-allocate all resources once they've outlived their purpose:
+	// ------------------------------------------------------------------------
+	destroy_render_targets(targets);
+	glDeleteVertexArrays(1, &cube_vao);
+	glDeleteVertexArrays(1, &quad_vao);
+	glDeleteVertexArrays(1, &screen_vao);
+	glDeleteBuffers(1, &cube_vbo);
+	glDeleteBuffers(1, &quad_vbo);
+	glDeleteBuffers(1, &instance_vbo);
+	glDeleteBuffers(1, &screen_vbo);
+
+	// glfw: terminate, clearing all previously allocated GLFW resources.
+	// ------------------------------------------------------------------
+	glfwTerminate();
+	return headless.exit_code();
+}
+
+// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+// ---------------------------------------------------------------------------------------------------------
+void
+process_input(GLFWwindow* window)
+{
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+		glfwSetWindowShouldClose(window, true);
+
+	if (input.get_key(window, GLFW_KEY_W) == GLFW_PRESS)
+		camera.ProcessKeyboard(FORWARD, delta_time);
+	if (input.get_key(window, GLFW_KEY_S) == GLFW_PRESS)
+		camera.ProcessKeyboard(BACKWARD, delta_time);
+	if (input.get_key(window, GLFW_KEY_A) == GLFW_PRESS)
+		camera.ProcessKeyboard(LEFT, delta_time);
+	if (input.get_key(window, GLFW_KEY_D) == GLFW_PRESS)
+		camera.ProcessKeyboard(RIGHT, delta_time);
+
+	// toggle once per press
+	static bool space_was_pressed = false;
+	const bool space_pressed = input.get_key(window, GLFW_KEY_SPACE) == GLFW_PRESS;
+	if (space_pressed && !space_was_pressed)
+	{
+		use_oit = !use_oit;
+		std::cout << (use_oit ? "weighted blended OIT" : "unsorted alpha blending") << std::endl;
+	}
+	space_was_pressed = space_pressed;
+}
+
+// glfw: whenever the window size changed (by OS or user resize) this callback function executes
+// ---------------------------------------------------------------------------------------------
+void
+framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+	// the render targets are recreated at the new size before the next frame; a minimized window reports 0 x 0
+	if (width == 0 || height == 0)
+		return;
+	framebuffer_width = width;
+	framebuffer_height = height;
+	targets_dirty = true;
+}
+
+// glfw: whenever the mouse moves, this callback is called
+// -------------------------------------------------------
+void
+mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
+{
+	float xpos = static_cast<float>(xposIn);
+	float ypos = static_cast<float>(yposIn);
+	if (firstMouse)
+	{
+		lastX = xpos;
+		lastY = ypos;
+		firstMouse = false;
+	}
+
+	float xoffset = xpos - lastX;
+	float yoffset = lastY - ypos; // reversed since y-coordinates go from bottom to top
+
+	lastX = xpos;
+	lastY = ypos;
+
+	camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+// glfw: whenever the mouse scroll wheel scrolls, this callback is called
+// ----------------------------------------------------------------------
+void
+scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+	camera.ProcessMouseScroll(static_cast<float>(yoffset));
+}
@@ -1,9 +1,10 @@
 #version 330 core 
 in vec2 TexCoords;
+in vec4 Tint;
 out vec4 FragColor;
 
 uniform sampler2D texture_diffuse1;
 
 void main() {
-    FragColor = texture(texture_diffuse1, TexCoords);
+    FragColor = texture(texture_diffuse1, TexCoords) * Tint;
 }
\ No newline at end of file
@@ -2,14 +2,27 @@
 layout(location = 0) in vec3 aPosition;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aTexCoords;
+#ifdef DRAW_RECORDS
+// the DrawRecord of the draw, fetched from the ring buffer at the base instance of the draw call
+layout(location = 7) in mat4 aModel;
+layout(location = 11) in vec4 aTint;
+#else
+uniform mat4 model;
+uniform vec4 tint;
+#endif
 
 out vec2 TexCoords;
+out vec4 Tint;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "camera.glsl"
 
 void main() {
+#ifdef DRAW_RECORDS
+	mat4 model = aModel;
+	Tint = aTint;
+#else
+	Tint = tint;
+#endif
 	TexCoords = aTexCoords;
-	gl_Position = projection * view * model * vec4(aPosition, 1.0);
-}
\ No newline at end of file
+	gl_Position = camera.view_projection * model * vec4(aPosition, 1.0);
+}
@@ -1,11 +1,19 @@
 #include <iostream>
+#include <memory>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
-#include <learnopengl/shader_m.h>
+#include <learnopengl/shader_library.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/camera_uniforms.h>
 #include <learnopengl/model.h>
 #include <learnopengl/entity.h>
+#include <learnopengl/draw_list.h>
+#include <learnopengl/headless.h>
+#include <learnopengl/input_replay.h>
+#include <learnopengl/ring_buffer.h>
+
+#include <root_directory.h>
 
 void
 framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -28,14 +36,19 @@ Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
+// keys, cursor and scroll go through it so a session can be recorded and replayed, see headless.h
+InputReplay input;
 
 // timing
 float delta_time = 0.0f;
 float last_frame = 0.0f;
 
 int
-main()
+main(int argc, char** argv)
 {
+	// --frames runs a fixed number of frames with a scripted camera in an invisible window, see headless.h
+	HeadlessRun headless(parse_headless_options(argc, argv));
+
 	// glfw: initialize and configure
 	// ------------------------------
 	glfwInit();
@@ -46,6 +59,7 @@ main()
 #ifdef __APPLE__
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+	headless.apply_window_hints();
 
 	// glfw window creation
 	// --------------------
@@ -58,8 +72,9 @@ main()
 	}
 	glfwMakeContextCurrent(window);
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-	glfwSetCursorPosCallback(window, mouse_callback);
-	glfwSetScrollCallback(window, scroll_callback);
+	input.install(window, mouse_callback, scroll_callback);
+	if (!headless.configure_input(input))
+		return -1;
 
 	// tell GLFW to capture our mouse
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -81,7 +96,19 @@ main()
 
 	// build and compile shaders
 	// -------------------------
-	Shader ourShader("1.model_loading.vs", "1.model_loading.fs");
+	// with OpenGL 4.4 the per-draw matrices and tints go through a persistently mapped ring buffer instead of uniforms
+	ShaderLibrary shaders((GLADloadproc)glfwGetProcAddress);
+	shaders.add_include_directory(std::string(logl_root) + "/resources/shaders");
+	std::unique_ptr<PersistentRingBuffer> draw_records;
+	ShaderDefines defines;
+	if (PersistentRingBuffer::is_supported())
+	{
+		draw_records = std::make_unique<PersistentRingBuffer>(1024 * sizeof(DrawRecord));
+		defines["DRAW_RECORDS"] = "";
+	}
+	Shader& ourShader = shaders.get("1.model_loading.vs", "1.model_loading.fs", defines);
+	CameraUniforms camera_uniforms;
+	CameraUniforms::bind_program(ourShader.ID);
 
 	// load entities
 	Model model("../../../../../resources//objects/planet/planet.obj");
@@ -98,10 +125,15 @@ main()
 			// set transform values
 			lastEntity->transform.set_local_position({10.0f, 0.0f, 0.0f});
 			lastEntity->transform.set_local_scale({scale, scale, scale});
+			// from white to orange down the hierarchy
+			lastEntity->tint = glm::mix(glm::vec4(1.0f), glm::vec4(1.0f, 0.5f, 0.2f, 1.0f), (i + 1) / 10.0f);
 		}
 	}
 	ourEntity.update_self_and_child();
 
+	JobSystem job_system;
+	DrawListBuilder draw_list_builder(job_system);
+
 	// render loop
 
 	while (!glfwWindowShouldClose(window))
@@ -109,12 +141,14 @@ main()
 		// per-frame time logic
 		// --------------------
 		float current_frame = glfwGetTime();
-		delta_time = current_frame - last_frame;
+		delta_time = input.begin_frame(window, headless.frame_delta(current_frame - last_frame));
 		last_frame = current_frame;
 
 		// input
 		//--------------------
 		process_input(window);
+		headless.move_camera(camera, delta_time);
+		input.update_camera(camera);
 
 		// render
 		//--------------------
@@ -125,23 +159,28 @@ main()
 		ourShader.use();
 
 		// view/projection transformations
-		glm::mat4 projection =
-			glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-		glm::mat4 view = camera.GetViewMatrix();
-		ourShader.setMat4("projection", projection);
-		ourShader.setMat4("view", view);
+		camera_uniforms.update(camera, SCR_WIDTH, SCR_HEIGHT, current_frame, delta_time);
 
 		// draw our scene graph
-		Entity* lastEntity = &ourEntity;
-		while (lastEntity->children.size())
+		const Frustum cam_frustum = create_frustum_from_camera(
+			camera,
+			(float)SCR_WIDTH / (float)SCR_HEIGHT,
+			glm::radians(camera.Zoom),
+			0.1f,
+			100.0f);
+		draw_list_builder.build(ourEntity, cam_frustum, camera.Position);
+		if (draw_records)
 		{
-			ourShader.setMat4("model", lastEntity->transform.get_model_matrix());
-			lastEntity->pModel->Draw(ourShader);
-			lastEntity = lastEntity->children.back().get();
+			draw_records->begin_frame();
+			draw_list_builder.submit(ourShader, *draw_records);
+			draw_records->end_frame();
 		}
+		else
+			draw_list_builder.submit(ourShader);
 		ourEntity.transform.set_local_rotation(
 			{0.f, ourEntity.transform.get_local_rotation().y + 20 * delta_time, 0.f});
-		ourEntity.update_self_and_child();
+		ourEntity.update_dirty(job_system);
+		headless.end_frame(window);
 		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
 		// -------------------------------------------------------------------------------
 		glfwSwapBuffers(window);
@@ -151,7 +190,7 @@ main()
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
 	glfwTerminate();
-	return 0;
+	return headless.exit_code();
 }
 
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
@@ -162,13 +201,13 @@ process_input(GLFWwindow* window)
 	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
 		glfwSetWindowShouldClose(window, true);
 
-	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+	if (input.get_key(window, GLFW_KEY_W) == GLFW_PRESS)
 		camera.ProcessKeyboard(FORWARD, delta_time);
-	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+	if (input.get_key(window, GLFW_KEY_S) == GLFW_PRESS)
 		camera.ProcessKeyboard(BACKWARD, delta_time);
-	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+	if (input.get_key(window, GLFW_KEY_A) == GLFW_PRESS)
 		camera.ProcessKeyboard(LEFT, delta_time);
-	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+	if (input.get_key(window, GLFW_KEY_D) == GLFW_PRESS)
 		camera.ProcessKeyboard(RIGHT, delta_time);
 }
 
@@ -0,0 +1,9 @@
+#version 330 core 
+in vec2 TexCoords;
+out vec4 FragColor;
+
+uniform sampler2D texture_diffuse1;
+
+void main() {
+    FragColor = texture(texture_diffuse1, TexCoords);
+}
\ No newline at end of file
@@ -9,6 +9,10 @@
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
 #include <learnopengl/entity.h>
+#include <learnopengl/draw_list.h>
+#include <learnopengl/spatial_index.h>
+#include <learnopengl/headless.h>
+#include <learnopengl/input_replay.h>
 
 #include <iostream>
 
@@ -31,14 +35,19 @@ Camera cameraSpy(glm::vec3(0.0f, 10.0f, 0.f));
 float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
+// keys, cursor and scroll go through it so a session can be recorded and replayed, see headless.h
+InputReplay input;
 
 // timing
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
 int
-main()
+main(int argc, char** argv)
 {
+	// --frames runs a fixed number of frames with a scripted camera in an invisible window, see headless.h
+	HeadlessRun headless(parse_headless_options(argc, argv));
+
 	// glfw: initialize and configure
 	// ------------------------------
 	glfwInit();
@@ -49,6 +58,7 @@ main()
 #ifdef __APPLE__
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+	headless.apply_window_hints();
 
 	// glfw window creation
 	// --------------------
@@ -61,8 +71,9 @@ main()
 	}
 	glfwMakeContextCurrent(window);
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-	glfwSetCursorPosCallback(window, mouse_callback);
-	glfwSetScrollCallback(window, scroll_callback);
+	input.install(window, mouse_callback, scroll_callback);
+	if (!headless.configure_input(input))
+		return -1;
 
 	// tell GLFW to capture our mouse
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -88,9 +99,14 @@ main()
 	// -------------------------
 	Shader ourShader("1.model_loading.vs", "1.model_loading.fs");
 
-	// load entities
+	// traversal, culling and draw packet generation run on worker threads, submission stays on this one
+	JobSystem job_system;
+	DrawListBuilder draw_list_builder(job_system);
+
+	// load entities, with the triangle hierarchy used for picking
 	// -----------
 	Model model("../../../../../resources//objects/planet/planet.obj");
+	model.buildBVH(&job_system);
 	Entity ourEntity(model);
 	ourEntity.transform.set_local_position({0, 0, 0});
 	const float scale = 1.0;
@@ -113,6 +129,10 @@ main()
 	}
 	ourEntity.update_self_and_child();
 
+	// world bounds of every entity, culling and picking query it instead of walking the tree
+	EntitySpatialIndex spatial_index;
+	spatial_index.insert(ourEntity);
+
 	// draw in wireframe
 	// glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
@@ -123,12 +143,14 @@ main()
 		// per-frame time logic
 		// --------------------
 		float currentFrame = glfwGetTime();
-		deltaTime = currentFrame - lastFrame;
+		deltaTime = input.begin_frame(window, headless.frame_delta(currentFrame - lastFrame));
 		lastFrame = currentFrame;
 
 		// input
 		// -----
 		processInput(window);
+		headless.move_camera(camera, deltaTime);
+		input.update_camera(camera);
 
 		// render
 		// ------
@@ -158,13 +180,25 @@ main()
 		ourShader.setMat4("view", view);
 
 		// draw our scene graph
-		unsigned int total = 0, display = 0;
-		ourEntity.draw_self_and_child(cam_frustum, ourShader, display, total);
-		std::cout << "Total process in CPU : " << total << " / Total send to GPU : " << display << std::endl;
+		draw_list_builder.build(spatial_index, cam_frustum, camera.Position);
+		draw_list_builder.submit(ourShader);
+		std::cout << "Total process in CPU : " << draw_list_builder.get_total()
+				  << " / Total send to GPU : " << draw_list_builder.get_visible() << std::endl;
+
+		// pick the triangle in the middle of the screen
+		if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS)
+		{
+			RayHit hit;
+			if (spatial_index.pick(camera.Position, camera.Front, 100.0f, &hit))
+				std::cout << "Picked triangle " << hit.triangle << " of mesh " << hit.mesh << " at distance "
+						  << hit.distance << std::endl;
+		}
 
 		// ourEntity.transform.setLocalRotation({ 0.f, ourEntity.transform.getLocalRotation().y + 20 * deltaTime, 0.f
 		// });
-		ourEntity.update_self_and_child();
+		ourEntity.update_dirty(job_system);
+		spatial_index.update(ourEntity);
+		headless.end_frame(window);
 
 		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
 		// -------------------------------------------------------------------------------
@@ -175,7 +209,7 @@ main()
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
 	glfwTerminate();
-	return 0;
+	return headless.exit_code();
 }
 
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
@@ -186,13 +220,13 @@ processInput(GLFWwindow* window)
 	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
 		glfwSetWindowShouldClose(window, true);
 
-	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+	if (input.get_key(window, GLFW_KEY_W) == GLFW_PRESS)
 		camera.ProcessKeyboard(FORWARD, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+	if (input.get_key(window, GLFW_KEY_S) == GLFW_PRESS)
 		camera.ProcessKeyboard(BACKWARD, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+	if (input.get_key(window, GLFW_KEY_A) == GLFW_PRESS)
 		camera.ProcessKeyboard(LEFT, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+	if (input.get_key(window, GLFW_KEY_D) == GLFW_PRESS)
 		camera.ProcessKeyboard(RIGHT, deltaTime);
 }
 
@@ -0,0 +1,515 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/shader_library.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/camera_uniforms.h>
+#include <learnopengl/model.h>
+#include <learnopengl/entity.h>
+#include <learnopengl/draw_list.h>
+#include <learnopengl/spatial_index.h>
+#include <learnopengl/cascaded_shadows.h>
+#include <learnopengl/headless.h>
+#include <learnopengl/input_replay.h>
+
+#include <root_directory.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+void
+framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void
+mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void
+scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void
+processInput(GLFWwindow* window);
+unsigned int
+loadTexture(const char* path);
+
+// settings
+const unsigned int SCR_WIDTH = 1280;
+const unsigned int SCR_HEIGHT = 720;
+const float NEAR_PLANE = 0.1f;
+const float FAR_PLANE = 400.0f;
+
+// camera
+Camera camera(glm::vec3(0.0f, 30.0f, 90.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, -20.0f);
+float lastX = SCR_WIDTH / 2.0f;
+float lastY = SCR_HEIGHT / 2.0f;
+bool firstMouse = true;
+// keys, cursor and scroll go through it so a session can be recorded and replayed, see headless.h
+InputReplay input;
+
+// current framebuffer size, the shadow passes change the viewport
+int framebufferWidth = SCR_WIDTH;
+int framebufferHeight = SCR_HEIGHT;
+
+// the sun, turned with the arrow keys, in degrees
+float sunAzimuth = 30.0f;
+float sunElevation = 40.0f;
+
+// split between uniform and logarithmic cascades, changed with [ and ]
+float splitLambda = 0.75f;
+// C tints the cascades, K draws every caster into every cascade every frame, P stops the moving planets
+bool showCascades = false;
+bool cacheCascades = true;
+bool paused = false;
+
+// timing
+float deltaTime = 0.0f;
+float lastFrame = 0.0f;
+
+int
+main(int argc, char** argv)
+{
+	// --frames runs a fixed number of frames with a scripted camera in an invisible window, see headless.h
+	HeadlessRun headless(parse_headless_options(argc, argv));
+
+	// glfw: initialize and configure
+	// ------------------------------
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+	headless.apply_window_hints();
+
+	// glfw window creation
+	// --------------------
+	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "learn_opengl:csm", NULL, NULL);
+	if (window == NULL)
+	{
+		std::cout << "Failed to create GLFW window" << std::endl;
+		glfwTerminate();
+		return -1;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	input.install(window, mouse_callback, scroll_callback);
+	if (!headless.configure_input(input))
+		return -1;
+
+	// tell GLFW to capture our mouse
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+	// glad: load all OpenGL function pointers
+	// ---------------------------------------
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return -1;
+	}
+
+	// larger than the window size on retina displays
+	glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+
+	// tell stb_image.h to flip loaded texture's on the y-axis (before loading model).
+	stbi_set_flip_vertically_on_load(true);
+
+	// configure global opengl state
+	// -----------------------------
+	glEnable(GL_DEPTH_TEST);
+
+	camera.MovementSpeed = 20.f;
+
+	// build and compile shaders
+	// -------------------------
+	ShaderLibrary shaders((GLADloadproc)glfwGetProcAddress);
+	shaders.add_include_directory(std::string(logl_root) + "/resources/shaders");
+	shaders.precompile("shadow_depth.vs", "shadow_depth.fs");
+	shaders.precompile("csm.vs", "csm.fs");
+	Shader& depthShader = shaders.get("shadow_depth.vs", "shadow_depth.fs");
+	Shader& sceneShader = shaders.get("csm.vs", "csm.fs");
+
+	CameraUniforms cameraUniforms;
+	CameraUniforms::bind_program(sceneShader.ID);
+
+	// traversal, culling and draw packet generation run on worker threads, submission stays on this one
+	JobSystem job_system;
+	DrawListBuilder draw_list_builder(job_system);
+
+	// ground
+	// ------
+	const float groundVertices[] = {
+		// positions, normals, texture coords
+		-1.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f,
+		1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f,
+	};
+	const unsigned int groundIndices[] = {0, 1, 2, 0, 2, 3};
+	unsigned int groundVAO, groundVBO, groundEBO;
+	glGenVertexArrays(1, &groundVAO);
+	glGenBuffers(1, &groundVBO);
+	glGenBuffers(1, &groundEBO);
+	glBindVertexArray(groundVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, groundVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(groundVertices), groundVertices, GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, groundEBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(groundIndices), groundIndices, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+	glBindVertexArray(0);
+	const unsigned int groundTexture =
+		loadTexture((std::string(logl_root) + "/resources/textures/marble.jpg").c_str());
+
+	// load entities: a large planet in the middle of a field of static ones, and a ring of planets turning above it
+	// -----------
+	Model model(std::string(logl_root) + "/resources/objects/planet/planet.obj");
+	const float radius = generate_aabb(model).extents.x;
+	const float spacing = radius * 6.0f;
+	const int grid = 32;
+	const float fieldExtent = 0.5f * grid * spacing;
+
+	Entity staticRoot(model);
+	staticRoot.transform.set_local_position({0.0f, radius * 3.0f, 0.0f});
+	staticRoot.transform.set_local_scale({3.0f, 3.0f, 3.0f});
+
+	std::mt19937 generator(2021);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	for (int x = 0; x < grid; ++x)
+	{
+		for (int z = 0; z < grid; ++z)
+		{
+			const glm::vec2 cell((x + 0.5f) * spacing - fieldExtent, (z + 0.5f) * spacing - fieldExtent);
+			// room for the large planet and the ring
+			if (glm::length(cell) < radius * 16.0f)
+				continue;
+
+			// children are placed relative to the large planet
+			staticRoot.add_child(model);
+			Entity& entity = *staticRoot.children.back();
+			const float scale = 0.5f + unit(generator);
+			const float height = radius * scale + unit(generator) * radius * 2.0f;
+			entity.transform.set_local_position(glm::vec3(cell.x, height - radius * 3.0f, cell.y) / 3.0f);
+			entity.transform.set_local_scale(glm::vec3(scale / 3.0f));
+			entity.transform.set_local_rotation({0.0f, unit(generator) * 360.0f, 0.0f});
+		}
+	}
+	staticRoot.update_self_and_child();
+
+	// the ring turns with its root
+	Entity movingRoot(model);
+	movingRoot.transform.set_local_position({0.0f, radius * 9.0f, 0.0f});
+	const int ringCount = 12;
+	for (int i = 0; i < ringCount; ++i)
+	{
+		const float angle = i * 6.2831853f / ringCount;
+		movingRoot.add_child(model);
+		Entity& entity = *movingRoot.children.back();
+		entity.transform.set_local_position(
+			glm::vec3(std::cos(angle) * 12.0f, std::sin(angle * 3.0f) * 2.0f - 5.0f, std::sin(angle) * 12.0f) *
+			radius);
+		entity.transform.set_local_scale(glm::vec3(0.75f));
+		entity.tint = glm::vec4(1.0f, 0.8f, 0.6f, 1.0f);
+	}
+	movingRoot.update_self_and_child();
+	std::vector<Entity*> movingEntities = {&movingRoot};
+	for (auto&& child : movingRoot.children)
+		movingEntities.push_back(child.get());
+
+	// world bounds of the entities, the view and the cascades query them instead of walking the trees. The moving
+	// casters have an index of their own, drawn over the cached static casters of the cascades
+	EntitySpatialIndex staticIndex;
+	staticIndex.insert(staticRoot);
+	EntitySpatialIndex movingIndex;
+	movingIndex.insert(movingRoot);
+
+	// everything that casts: the cascades reach toward the light over it
+	const AABB sceneBounds(
+		glm::vec3(-fieldExtent, 0.0f, -fieldExtent),
+		glm::vec3(fieldExtent, radius * 10.0f, fieldExtent));
+
+	// the shadows of the sun
+	// ----------------------
+	CascadedShadowMap shadows(2048);
+	// where the moving planets were when the cascades last saw them
+	std::vector<AABB> previousBounds(movingEntities.size());
+	for (size_t i = 0; i < movingEntities.size(); ++i)
+		previousBounds[i] = movingEntities[i]->get_world_aabb();
+
+	float ringAngle = 0.0f;
+	float lastTitleTime = 0.0f;
+	unsigned int frames = 0, staticCascades = 0, shadowDraws = 0;
+
+	// render loop
+	// -----------
+	while (!glfwWindowShouldClose(window))
+	{
+		// per-frame time logic
+		// --------------------
+		float currentFrame = glfwGetTime();
+		deltaTime = input.begin_frame(window, headless.frame_delta(currentFrame - lastFrame));
+		lastFrame = currentFrame;
+
+		// input
+		// -----
+		processInput(window);
+		headless.move_camera(camera, deltaTime);
+		input.update_camera(camera);
+
+		// the ring turns above the large planet, the rest of the scene stays where it is
+		if (!paused)
+		{
+			ringAngle += deltaTime * 20.0f;
+			movingRoot.transform.set_local_rotation({0.0f, ringAngle, 0.0f});
+		}
+		movingRoot.update_dirty(job_system);
+		movingIndex.update(movingRoot);
+
+		const float aspect = float(framebufferWidth) / float(std::max(framebufferHeight, 1));
+		const glm::vec3 lightDirection = -glm::vec3(
+			std::cos(glm::radians(sunElevation)) * std::cos(glm::radians(sunAzimuth)),
+			std::sin(glm::radians(sunElevation)),
+			std::cos(glm::radians(sunElevation)) * std::sin(glm::radians(sunAzimuth)));
+
+		shadows.split_lambda = splitLambda;
+		shadows.cached_from = cacheCascades ? 1 : shadows.get_cascade_count();
+		shadows.update(camera, aspect, NEAR_PLANE, FAR_PLANE, lightDirection, sceneBounds);
+
+		// the moving casters are drawn again into the cascades where their shadows were and where they are now
+		if (!movingRoot.get_updated_roots().empty())
+		{
+			for (size_t i = 0; i < movingEntities.size(); ++i)
+			{
+				const AABB bounds = movingEntities[i]->get_world_aabb();
+				shadows.invalidate(previousBounds[i]);
+				shadows.invalidate(bounds);
+				previousBounds[i] = bounds;
+			}
+		}
+
+		// render what changed in the cascades, each with the casters in its own box only
+		// ------
+		depthShader.use();
+		for (unsigned int i = 0; i < shadows.get_cascade_count(); ++i)
+		{
+			depthShader.setMat4("lightSpaceMatrix", shadows.get_light_matrix(i));
+			if (shadows.begin_static(i))
+			{
+				draw_list_builder.build(staticIndex, shadows.get_caster_frustum(i), camera.Position);
+				draw_list_builder.submit(depthShader);
+				shadows.end_render();
+				shadowDraws += draw_list_builder.get_visible();
+			}
+			if (shadows.begin_dynamic(i))
+			{
+				draw_list_builder.build(movingIndex, shadows.get_caster_frustum(i), camera.Position);
+				draw_list_builder.submit(depthShader);
+				shadows.end_render();
+				shadowDraws += draw_list_builder.get_visible();
+			}
+		}
+		staticCascades += shadows.get_static_render_count();
+
+		// render the scene
+		// ------
+		glViewport(0, 0, framebufferWidth, framebufferHeight);
+		glClearColor(0.55f, 0.7f, 0.9f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		cameraUniforms.update(
+			camera, framebufferWidth, framebufferHeight, currentFrame, deltaTime, NEAR_PLANE, FAR_PLANE);
+		sceneShader.use();
+		shadows.bind(sceneShader, 8);
+		sceneShader.setVec3("lightColor", glm::vec3(1.0f, 0.95f, 0.85f));
+		sceneShader.setVec3("ambientColor", glm::vec3(0.25f, 0.28f, 0.35f));
+		sceneShader.setBool("showCascades", showCascades);
+
+		// ground
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, groundTexture);
+		sceneShader.setInt("texture_diffuse1", 0);
+		sceneShader.setMat4("model", glm::scale(glm::mat4(1.0f), glm::vec3(fieldExtent, 1.0f, fieldExtent)));
+		sceneShader.setVec4("tint", glm::vec4(1.0f));
+		sceneShader.setFloat("texCoordScale", fieldExtent / 4.0f);
+		glBindVertexArray(groundVAO);
+		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+		glBindVertexArray(0);
+
+		// planets
+		const Frustum cam_frustum =
+			create_frustum_from_camera(camera, aspect, glm::radians(camera.Zoom), NEAR_PLANE, FAR_PLANE);
+		sceneShader.setFloat("texCoordScale", 1.0f);
+		draw_list_builder.build(staticIndex, cam_frustum, camera.Position);
+		draw_list_builder.submit(sceneShader);
+		draw_list_builder.build(movingIndex, cam_frustum, camera.Position);
+		draw_list_builder.submit(sceneShader);
+		headless.end_frame(window);
+
+		++frames;
+		if (currentFrame - lastTitleTime > 1.0f)
+		{
+			const std::string title = "learn_opengl:csm - " +
+									  std::to_string(float(staticCascades) / frames).substr(0, 4) +
+									  " static cascades and " + std::to_string(shadowDraws / frames) +
+									  " shadow draws per frame, lambda " + std::to_string(splitLambda).substr(0, 4) +
+									  (cacheCascades ? ", cached" : ", not cached");
+			glfwSetWindowTitle(window, title.c_str());
+			lastTitleTime = currentFrame;
+			frames = staticCascades = shadowDraws = 0;
+		}
+
+		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+		// -------------------------------------------------------------------------------
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+	}
+
+	// optional: de-allocate all resources once they've outlived their purpose:
+	// ------------------------------------------------------------------------
+	glDeleteVertexArrays(1, &groundVAO);
+	glDeleteBuffers(1, &groundVBO);
+	glDeleteBuffers(1, &groundEBO);
+
+	// glfw: terminate, clearing all previously allocated GLFW resources.
+	// ------------------------------------------------------------------
+	glfwTerminate();
+	return headless.exit_code();
+}
+
+// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+// ---------------------------------------------------------------------------------------------------------
+void
+processInput(GLFWwindow* window)
+{
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+		glfwSetWindowShouldClose(window, true);
+
+	if (input.get_key(window, GLFW_KEY_W) == GLFW_PRESS)
+		camera.ProcessKeyboard(FORWARD, deltaTime);
+	if (input.get_key(window, GLFW_KEY_S) == GLFW_PRESS)
+		camera.ProcessKeyboard(BACKWARD, deltaTime);
+	if (input.get_key(window, GLFW_KEY_A) == GLFW_PRESS)
+		camera.ProcessKeyboard(LEFT, deltaTime);
+	if (input.get_key(window, GLFW_KEY_D) == GLFW_PRESS)
+		camera.ProcessKeyboard(RIGHT, deltaTime);
+
+	// turning the sun renders every cascade again
+	if (input.get_key(window, GLFW_KEY_LEFT) == GLFW_PRESS)
+		sunAzimuth -= deltaTime * 30.0f;
+	if (input.get_key(window, GLFW_KEY_RIGHT) == GLFW_PRESS)
+		sunAzimuth += deltaTime * 30.0f;
+	if (input.get_key(window, GLFW_KEY_UP) == GLFW_PRESS)
+		sunElevation = std::min(sunElevation + deltaTime * 20.0f, 85.0f);
+	if (input.get_key(window, GLFW_KEY_DOWN) == GLFW_PRESS)
+		sunElevation = std::max(sunElevation - deltaTime * 20.0f, 10.0f);
+
+	static bool lowerWasPressed = false, higherWasPressed = false, cascadesWasPressed = false, cacheWasPressed = false,
+				pauseWasPressed = false;
+	const bool lowerPressed = input.get_key(window, GLFW_KEY_LEFT_BRACKET) == GLFW_PRESS;
+	const bool higherPressed = input.get_key(window, GLFW_KEY_RIGHT_BRACKET) == GLFW_PRESS;
+	const bool cascadesPressed = input.get_key(window, GLFW_KEY_C) == GLFW_PRESS;
+	const bool cachePressed = input.get_key(window, GLFW_KEY_K) == GLFW_PRESS;
+	const bool pausePressed = input.get_key(window, GLFW_KEY_P) == GLFW_PRESS;
+	if (lowerPressed && !lowerWasPressed)
+		splitLambda = std::max(splitLambda - 0.05f, 0.0f);
+	if (higherPressed && !higherWasPressed)
+		splitLambda = std::min(splitLambda + 0.05f, 1.0f);
+	if (cascadesPressed && !cascadesWasPressed)
+		showCascades = !showCascades;
+	if (cachePressed && !cacheWasPressed)
+		cacheCascades = !cacheCascades;
+	if (pausePressed && !pauseWasPressed)
+		paused = !paused;
+	lowerWasPressed = lowerPressed;
+	higherWasPressed = higherPressed;
+	cascadesWasPressed = cascadesPressed;
+	cacheWasPressed = cachePressed;
+	pauseWasPressed = pausePressed;
+}
+
+// glfw: whenever the window size changed (by OS or user resize) this callback function executes
+// ---------------------------------------------------------------------------------------------
+void
+framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+	// make sure the viewport matches the new window dimensions; note that width and
+	// height will be significantly larger than specified on retina displays.
+	framebufferWidth = width;
+	framebufferHeight = height;
+	glViewport(0, 0, width, height);
+}
+
+// glfw: whenever the mouse moves, this callback is called
+// -------------------------------------------------------
+void
+mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+	if (firstMouse)
+	{
+		lastX = xpos;
+		lastY = ypos;
+		firstMouse = false;
+	}
+
+	float xoffset = xpos - lastX;
+	float yoffset = lastY - ypos; // reversed since y-coordinates go from bottom to top
+
+	lastX = xpos;
+	lastY = ypos;
+
+	camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+// glfw: whenever the mouse scroll wheel scrolls, this callback is called
+// ----------------------------------------------------------------------
+void
+scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+	camera.ProcessMouseScroll(yoffset);
+}
+
+// utility function for loading a 2D texture from file
+// ---------------------------------------------------
+unsigned int
+loadTexture(char const* path)
+{
+	unsigned int textureID;
+	glGenTextures(1, &textureID);
+
+	int width, height, nrComponents;
+	unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
+	if (data)
+	{
+		GLenum format;
+		if (nrComponents == 1)
+			format = GL_RED;
+		else if (nrComponents == 3)
+			format = GL_RGB;
+		else if (nrComponents == 4)
+			format = GL_RGBA;
+
+		glBindTexture(GL_TEXTURE_2D, textureID);
+		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		stbi_image_free(data);
+	}
+	else
+	{
+		std::cout << "Texture failed to load at path: " << path << std::endl;
+		stbi_image_free(data);
+	}
+
+	return textureID;
+}
@@ -0,0 +1,32 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 WorldPos;
+in vec3 Normal;
+in vec2 TexCoords;
+in float ViewDepth;
+
+#include "shadows.glsl"
+#include "lighting.glsl"
+
+uniform sampler2D texture_diffuse1;
+uniform vec4 tint;
+uniform vec3 lightColor;
+uniform vec3 ambientColor;
+// tints every cascade in its own color
+uniform bool showCascades;
+
+const vec3 cascadeColors[MAX_CASCADES] = vec3[](
+    vec3(1.0, 0.25, 0.25), vec3(0.25, 1.0, 0.25), vec3(0.25, 0.25, 1.0), vec3(1.0, 1.0, 0.25));
+
+void main()
+{
+    vec3 normal = normalize(Normal);
+    vec3 albedo = texture(texture_diffuse1, TexCoords).rgb * tint.rgb;
+    float shadow = shadow_factor(WorldPos, normal, ViewDepth);
+    vec3 light = ambientColor + shadow * diffuse_term(normal, -lightDirection, lightColor);
+    vec3 color = albedo * light;
+    if (showCascades && ViewDepth < cascadeSplits[cascadeCount - 1])
+        color = mix(color, cascadeColors[shadow_cascade(ViewDepth)], 0.25);
+    FragColor = vec4(color, 1.0);
+}
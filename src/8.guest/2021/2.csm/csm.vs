@@ -0,0 +1,27 @@
+#version 330 core
+layout(location = 0) in vec3 aPosition;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoords;
+
+out vec3 WorldPos;
+out vec3 Normal;
+out vec2 TexCoords;
+// distance along the view direction, selects the cascade
+out float ViewDepth;
+
+#include "camera.glsl"
+
+uniform mat4 model;
+// tiling of the texture, the ground repeats it
+uniform float texCoordScale;
+
+void main()
+{
+    vec4 worldPos = model * vec4(aPosition, 1.0);
+    WorldPos = worldPos.xyz;
+    // the entities are scaled uniformly
+    Normal = mat3(model) * aNormal;
+    TexCoords = aTexCoords * texCoordScale;
+    ViewDepth = -(camera.view * worldPos).z;
+    gl_Position = camera.view_projection * worldPos;
+}
@@ -0,0 +1,6 @@
+#version 330 core
+
+// a cascade only stores depth
+void main()
+{
+}
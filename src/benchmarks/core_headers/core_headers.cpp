@@ -0,0 +1,214 @@
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/benchmark.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/entity.h>
+#include <learnopengl/mesh.h>
+#include <learnopengl/model.h>
+#include <learnopengl/shader.h>
+#include <learnopengl/transparent_queue.h>
+
+#include <root_directory.h>
+
+// Baseline of the hot paths of include/learnopengl, to measure optimizations against:
+//   bin/benchmarks/core_headers/benchmarks_core_headers --pin 2 --samples 31 --json baseline.json
+// The CPU only paths run first. Mesh construction, Model import and the Shader setters need a context, they run in an
+// invisible window and are skipped when none can be created.
+
+static void
+run_cpu_benchmarks(BenchmarkSuite& suite)
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> angle(-180.0f, 180.0f);
+	std::uniform_real_distribution<float> offset(-10.0f, 10.0f);
+
+	std::vector<Transform> transforms(1024);
+	for (auto&& transform : transforms)
+	{
+		transform.set_local_position({offset(rng), offset(rng), offset(rng)});
+		transform.set_local_rotation({angle(rng), angle(rng), angle(rng)});
+	}
+	glm::mat4 parent = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f));
+	suite.run("Transform::compute_model_matrix, 1024 transforms", 20, [&] {
+		for (auto&& transform : transforms)
+			transform.compute_model_matrix(parent);
+		do_not_optimize(transforms.back().get_model_matrix());
+	});
+
+	// hierarchies of the scene graph and frustum culling demos, the root rotates so everything is recomputed
+	Model empty_model;
+	Entity flat(empty_model);
+	for (unsigned int x = 0; x < 20; ++x)
+	{
+		for (unsigned int z = 0; z < 20; ++z)
+		{
+			flat.add_child(empty_model);
+			flat.children.back()->transform.set_local_position({x * 10.f - 100.f, 0.f, z * 10.f - 100.f});
+		}
+	}
+	float flat_angle = 0.0f;
+	suite.run("Entity::update_self_and_child, flat, 400 children", 100, [&] {
+		flat.transform.set_local_rotation({0.f, flat_angle += 1.0f, 0.f});
+		flat.update_self_and_child();
+	});
+
+	Entity deep(empty_model);
+	Entity* last_entity = &deep;
+	for (int i = 0; i < 10; i++)
+	{
+		last_entity->add_child(empty_model);
+		last_entity = last_entity->children.back().get();
+		last_entity->transform.set_local_position({10.0f, 0.0f, 0.0f});
+		last_entity->transform.set_local_scale({0.75f, 0.75f, 0.75f});
+	}
+	float deep_angle = 0.0f;
+	suite.run("Entity::update_self_and_child, deep, 10 levels", 1000, [&] {
+		deep.transform.set_local_rotation({0.f, deep_angle += 1.0f, 0.f});
+		deep.update_self_and_child();
+	});
+
+	Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+	suite.run("Camera::GetViewMatrix", 10000, [&] {
+		camera.Position.x += 1e-6f;
+		do_not_optimize(camera.GetViewMatrix());
+	});
+
+	// the windows of the blending_sort demo, sorted back to front every frame
+	std::vector<glm::vec3> windows(1000);
+	for (auto&& position : windows)
+		position = glm::vec3(offset(rng), 0.0f, offset(rng));
+	suite.run("transparent sort, std::map, 1000 windows", 10, [&] {
+		std::map<float, glm::vec3> sorted;
+		for (auto&& position : windows)
+			sorted[glm::length(camera.Position - position)] = position;
+		do_not_optimize(sorted);
+	});
+	TransparentQueue queue;
+	const glm::mat4 view = camera.GetViewMatrix();
+	suite.run("transparent sort, TransparentQueue, 1000 windows", 10, [&] {
+		queue.clear();
+		for (unsigned int i = 0; i < windows.size(); ++i)
+			queue.push(windows[i], i);
+		queue.sort(view);
+		do_not_optimize(queue.get_order());
+	});
+}
+
+// Mesh keeps its buffers for the lifetime of the program, the benchmarks create thousands of them
+static void
+delete_mesh(const Mesh& mesh)
+{
+	GLint vertex_buffer = 0, index_buffer = 0;
+	glBindVertexArray(mesh.VAO);
+	glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &vertex_buffer);
+	glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &index_buffer);
+	glBindVertexArray(0);
+	const GLuint buffers[] = {GLuint(vertex_buffer), GLuint(index_buffer)};
+	glDeleteBuffers(2, buffers);
+	glDeleteVertexArrays(1, &mesh.VAO);
+}
+
+static void
+run_gl_benchmarks(BenchmarkSuite& suite)
+{
+	// a sphere of 64 x 32 quads
+	vector<Vertex> vertices;
+	vector<unsigned int> indices;
+	for (unsigned int y = 0; y <= 32; ++y)
+	{
+		for (unsigned int x = 0; x <= 64; ++x)
+		{
+			const float theta = glm::pi<float>() * y / 32, phi = glm::two_pi<float>() * x / 64;
+			Vertex vertex{};
+			vertex.Position =
+				glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+			vertex.Normal = vertex.Position;
+			vertex.TexCoords = glm::vec2(float(x) / 64, float(y) / 32);
+			vertices.push_back(vertex);
+		}
+	}
+	for (unsigned int y = 0; y < 32; ++y)
+	{
+		for (unsigned int x = 0; x < 64; ++x)
+		{
+			const unsigned int i = y * 65 + x;
+			indices.insert(indices.end(), {i, i + 65, i + 1, i + 1, i + 65, i + 66});
+		}
+	}
+	suite.run("Mesh construction, 2145 vertices", 1, [&] {
+		Mesh mesh(vertices, indices, {});
+		delete_mesh(mesh);
+	});
+
+	// the import includes reading the file, assimp's post processing, the texture decode and the uploads
+	const std::string planet = std::string(logl_root) + "/resources/objects/planet/planet.obj";
+	suite.run("Model import, planet.obj", 1, [&] {
+		Model model(planet);
+		for (auto&& mesh : model.meshes)
+			delete_mesh(mesh);
+		for (auto&& texture : model.textures_loaded)
+			glDeleteTextures(1, &texture.id);
+	});
+
+	Shader shader = Shader::fromSource(
+		"#version 330 core\n"
+		"layout (location = 0) in vec3 aPos;\n"
+		"uniform mat4 model;\n"
+		"uniform mat4 view;\n"
+		"uniform mat4 projection;\n"
+		"void main() { gl_Position = projection * view * model * vec4(aPos, 1.0); }\n",
+		"#version 330 core\n"
+		"out vec4 FragColor;\n"
+		"uniform vec3 color;\n"
+		"uniform float alpha;\n"
+		"void main() { FragColor = vec4(color, alpha); }\n");
+	shader.use();
+	const glm::mat4 matrix = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f);
+	suite.run("Shader::setMat4 x3, setVec3, setFloat", 1000, [&] {
+		shader.setMat4("model", matrix);
+		shader.setMat4("view", matrix);
+		shader.setMat4("projection", matrix);
+		shader.setVec3("color", glm::vec3(1.0f, 0.5f, 0.25f));
+		shader.setFloat("alpha", 0.5f);
+	});
+	glFinish();
+}
+
+int
+main(int argc, char** argv)
+{
+	BenchmarkSuite suite(argc, argv);
+	run_cpu_benchmarks(suite);
+
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(64, 64, "benchmark", NULL, NULL);
+	if (window)
+	{
+		glfwMakeContextCurrent(window);
+		if (gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+			run_gl_benchmarks(suite);
+	}
+	else
+		std::printf("no OpenGL context, skipping the Mesh, Model and Shader benchmarks\n");
+	glfwTerminate();
+
+	return suite.finish() ? 0 : 1;
+}
@@ -0,0 +1,75 @@
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <learnopengl/benchmark.h>
+#include <learnopengl/job_system.h>
+
+// Measures the cost of scheduling a job and how parallel_for scales from 1 to N threads.
+
+// some arithmetic heavy enough to hide the scheduling cost
+static float
+work(float x)
+{
+	for (int i = 0; i < 16; ++i)
+		x = std::sqrt(x * x + 1.0f);
+	return x;
+}
+
+int
+main()
+{
+	const unsigned int max_threads = std::max(1u, std::thread::hardware_concurrency());
+	const size_t job_count = 10000;
+	const size_t element_count = 1 << 20;
+
+	std::vector<float> data(element_count, 1.0f);
+
+	// powers of two up to the hardware thread count, plus the count itself
+	std::vector<unsigned int> thread_counts;
+	for (unsigned int threads = 1; threads < max_threads; threads *= 2)
+		thread_counts.push_back(threads);
+	thread_counts.push_back(max_threads);
+
+	std::printf("scheduling overhead, %zu empty jobs per iteration\n", job_count);
+	for (unsigned int threads : thread_counts)
+	{
+		JobSystem job_system(threads - 1);
+		BenchmarkResult result = run_benchmark(
+			"run + wait, " + std::to_string(threads) + " threads",
+			1,
+			[&] {
+				JobCounter counter;
+				for (size_t i = 0; i < job_count; ++i)
+					job_system.run([] {}, &counter);
+				job_system.wait(counter);
+			});
+		result.median_ns /= job_count;
+		result.min_ns /= job_count;
+		print_benchmark_result(result);
+	}
+
+	std::printf("\nparallel_for scaling, %zu elements\n", element_count);
+	double serial_ns = 0.0;
+	for (unsigned int threads : thread_counts)
+	{
+		JobSystem job_system(threads - 1);
+		const BenchmarkResult result = run_benchmark(
+			"parallel_for, " + std::to_string(threads) + " threads",
+			1,
+			[&] {
+				job_system.parallel_for(0, data.size(), 0, [&](size_t first, size_t last) {
+					for (size_t i = first; i < last; ++i)
+						data[i] = work(data[i]);
+				});
+			});
+		if (threads == 1)
+			serial_ns = result.median_ns;
+		print_benchmark_result(result);
+		std::printf("%-56s %14.2fx\n", "  speedup", serial_ns / result.median_ns);
+	}
+	do_not_optimize(data[0]);
+	return 0;
+}
@@ -0,0 +1,173 @@
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/benchmark.h>
+#include <learnopengl/bounding_volume.h>
+#include <learnopengl/entity.h>
+#include <learnopengl/spatial_index.h>
+
+// Frustum culling, sphere queries and ray picking through EntitySpatialIndex compared with a walk over the whole
+// Entity tree, for growing scenes of unit boxes spread in a cube. Also measures the refit after 1% of the entities
+// moved.
+
+struct Scene
+{
+	Entity root;
+	std::vector<Entity*> entities;
+
+	explicit Scene(Model& model) : root(model){};
+};
+
+static void
+build_scene(Scene& scene, Model& model, size_t count, float size)
+{
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> coordinate(-size, size);
+	for (size_t i = 0; i < count; ++i)
+	{
+		scene.root.add_child(model);
+		Entity* entity = scene.root.children.back().get();
+		entity->bounding_volume = AABB(glm::vec3(-1.0f), glm::vec3(1.0f));
+		entity->transform.set_local_position({coordinate(rng), coordinate(rng), coordinate(rng)});
+		scene.entities.push_back(entity);
+	}
+	scene.root.update_self_and_child();
+}
+
+static size_t
+linear_frustum(const Entity& entity, const Frustum& frustum)
+{
+	size_t visible = entity.get_world_aabb().is_on_frustum(frustum) ? 1 : 0;
+	for (auto&& child : entity.children)
+		visible += linear_frustum(*child, frustum);
+	return visible;
+}
+
+static Entity*
+linear_ray_cast(Entity& root, const glm::vec3& origin, const glm::vec3& direction, float max_distance)
+{
+	const glm::vec3 inv_direction = 1.0f / direction;
+	Entity* closest = nullptr;
+	float distance;
+	if (root.get_world_aabb().intersects_ray(origin, inv_direction, max_distance, distance))
+	{
+		closest = &root;
+		max_distance = distance;
+	}
+	for (auto&& child : root.children)
+	{
+		if (child->get_world_aabb().intersects_ray(origin, inv_direction, max_distance, distance))
+		{
+			closest = child.get();
+			max_distance = distance;
+		}
+	}
+	return closest;
+}
+
+int
+main()
+{
+	Model model;
+
+	Camera camera(glm::vec3(0.0f, 0.0f, 0.0f));
+	const Frustum frustum = create_frustum_from_camera(camera, 4.0f / 3.0f, glm::radians(45.0f), 0.1f, 100.0f);
+	const glm::vec3 ray_origin = glm::vec3(0.0f, 0.0f, 1.0f);
+	const glm::vec3 ray_direction = glm::normalize(glm::vec3(0.3f, 0.2f, -1.0f));
+
+	int errors = 0;
+	for (size_t count : {size_t(1000), size_t(10000), size_t(100000)})
+	{
+		// constant density, the visible part grows with the scene
+		const float size = 10.0f * std::cbrt(static_cast<float>(count));
+		Scene scene(model);
+		build_scene(scene, model, count, size);
+
+		EntitySpatialIndex index;
+		index.insert(scene.root);
+		const std::string name = std::to_string(count) + " entities";
+		std::printf("%s, tree height %d\n", name.c_str(), index.get_tree().get_height());
+
+		size_t linear_visible = 0;
+		const BenchmarkResult linear = run_benchmark(name + ", frustum, tree walk", 10, [&] {
+			linear_visible = linear_frustum(scene.root, frustum);
+		});
+		print_benchmark_result(linear);
+
+		size_t indexed_visible = 0;
+		const BenchmarkResult indexed = run_benchmark(name + ", frustum, spatial index", 10, [&] {
+			indexed_visible = 0;
+			index.query(frustum, [&](Entity& entity) {
+				indexed_visible += entity.get_world_aabb().is_on_frustum(frustum) ? 1 : 0;
+				return true;
+			});
+		});
+		print_benchmark_result(indexed);
+		std::printf("%-56s %14.2fx\n", "  speedup", linear.median_ns / indexed.median_ns);
+
+		size_t near_camera = 0;
+		const BenchmarkResult sphere = run_benchmark(name + ", sphere radius 20, spatial index", 10, [&] {
+			near_camera = 0;
+			index.query(glm::vec3(0.0f), 20.0f, [&](Entity&) {
+				++near_camera;
+				return true;
+			});
+		});
+		print_benchmark_result(sphere);
+
+		Entity* linear_hit = nullptr;
+		const BenchmarkResult linear_ray = run_benchmark(name + ", ray pick, linear", 10, [&] {
+			linear_hit = linear_ray_cast(scene.root, ray_origin, ray_direction, 1e6f);
+			do_not_optimize(linear_hit);
+		});
+		print_benchmark_result(linear_ray);
+
+		Entity* indexed_hit = nullptr;
+		const BenchmarkResult indexed_ray = run_benchmark(name + ", ray pick, spatial index", 10, [&] {
+			indexed_hit = index.ray_cast(ray_origin, ray_direction, 1e6f);
+			do_not_optimize(indexed_hit);
+		});
+		print_benchmark_result(indexed_ray);
+		std::printf("%-56s %14.2fx\n", "  speedup", linear_ray.median_ns / indexed_ray.median_ns);
+
+		// 1% of the entities move by a small step every frame
+		std::mt19937 rng(7);
+		std::uniform_int_distribution<size_t> pick(0, count - 1);
+		std::uniform_real_distribution<float> step(-0.5f, 0.5f);
+		const BenchmarkResult refit = run_benchmark(name + ", 1% moving, update_dirty + refit", 10, [&] {
+			for (size_t i = 0; i < count / 100; ++i)
+			{
+				Entity* entity = scene.entities[pick(rng)];
+				entity->transform.set_local_position(
+					entity->transform.get_local_position() + glm::vec3(step(rng), step(rng), step(rng)));
+			}
+			scene.root.update_dirty();
+			index.update(scene.root);
+		});
+		print_benchmark_result(refit);
+
+		// the index must agree with the walk over the tree after all the moves
+		linear_visible = linear_frustum(scene.root, frustum);
+		indexed_visible = 0;
+		index.query(frustum, [&](Entity& entity) {
+			indexed_visible += entity.get_world_aabb().is_on_frustum(frustum) ? 1 : 0;
+			return true;
+		});
+		linear_hit = linear_ray_cast(scene.root, ray_origin, ray_direction, 1e6f);
+		indexed_hit = index.ray_cast(ray_origin, ray_direction, 1e6f);
+		if (linear_visible != indexed_visible || linear_hit != indexed_hit)
+		{
+			std::printf("  ERROR: spatial index disagrees with the tree walk (%zu / %zu visible)\n",
+						indexed_visible,
+						linear_visible);
+			++errors;
+		}
+		std::printf("%-56s %14zu\n\n", "  visible", indexed_visible);
+		do_not_optimize(near_camera);
+	}
+	return errors;
+}
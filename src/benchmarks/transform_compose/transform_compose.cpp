@@ -0,0 +1,95 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/benchmark.h>
+#include <learnopengl/entity.h>
+
+// Per node cost of composing parent * TRS: the former euler path (three rotate matrices, a translate and a scale
+// matrix, five 4x4 products), the quaternion path of Transform::compute_model_matrix and the batched
+// compute_model_matrices kernel.
+
+static glm::mat4
+euler_model_matrix(const glm::mat4& parent, const glm::vec3& pos, const glm::vec3& euler_rot, const glm::vec3& scale)
+{
+	glm::mat4 transform_x = glm::rotate(glm::mat4(1.0), glm::radians(euler_rot.x), glm::vec3(1.0f, 0.0f, 0.0f));
+	glm::mat4 transform_y = glm::rotate(glm::mat4(1.0), glm::radians(euler_rot.y), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 transform_z = glm::rotate(glm::mat4(1.0), glm::radians(euler_rot.z), glm::vec3(0.0f, 0.0f, 1.0f));
+	glm::mat4 rotation_matrix = transform_y * transform_x * transform_z;
+	glm::mat4 translate_matrix = glm::translate(glm::mat4(1.0), pos);
+	glm::mat4 scale_matrix = glm::scale(glm::mat4(1.0), scale);
+	return parent * (translate_matrix * rotation_matrix * scale_matrix);
+}
+
+int
+main()
+{
+	const size_t count = 4096;
+
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> angle(-180.0f, 180.0f);
+	std::uniform_real_distribution<float> offset(-10.0f, 10.0f);
+	std::uniform_real_distribution<float> size(0.5f, 2.0f);
+
+	std::vector<Transform> transforms(count);
+	std::vector<Transform*> pointers;
+	for (auto&& transform : transforms)
+	{
+		transform.set_local_position({offset(rng), offset(rng), offset(rng)});
+		transform.set_local_rotation({angle(rng), angle(rng), angle(rng)});
+		transform.set_local_scale({size(rng), size(rng), size(rng)});
+		pointers.push_back(&transform);
+	}
+
+	Transform parent;
+	parent.set_local_position({1.0f, 2.0f, 3.0f});
+	parent.set_local_rotation({10.0f, 20.0f, 30.0f});
+	parent.compute_model_matrix();
+	const glm::mat4& parent_matrix = parent.get_model_matrix();
+
+	std::vector<glm::mat4> reference(count);
+	BenchmarkResult euler = run_benchmark("euler, five 4x4 products", 20, [&] {
+		for (size_t i = 0; i < count; ++i)
+		{
+			reference[i] = euler_model_matrix(
+				parent_matrix,
+				transforms[i].get_local_position(),
+				transforms[i].get_local_rotation(),
+				transforms[i].m_scale);
+		}
+		do_not_optimize(reference[0]);
+	});
+
+	BenchmarkResult quaternion = run_benchmark("quaternion, one 4x4 product", 20, [&] {
+		for (auto&& transform : transforms)
+			transform.compute_model_matrix(parent_matrix);
+		do_not_optimize(transforms[0].model_matrix);
+	});
+
+	BenchmarkResult batch = run_benchmark("compute_model_matrices batch", 20, [&] {
+		compute_model_matrices(pointers.data(), pointers.size(), parent_matrix);
+		do_not_optimize(transforms[0].model_matrix);
+	});
+
+	std::printf("per node, %zu nodes\n", count);
+	for (BenchmarkResult* result : {&euler, &quaternion, &batch})
+	{
+		result->median_ns /= count;
+		result->min_ns /= count;
+		print_benchmark_result(*result);
+		std::printf("%-56s %14.2fx\n", "  speedup over euler", euler.median_ns / result->median_ns);
+	}
+
+	// the paths differ by rounding only
+	float max_error = 0.0f;
+	for (size_t i = 0; i < count; ++i)
+		for (int c = 0; c < 4; ++c)
+			for (int r = 0; r < 4; ++r)
+				max_error = std::max(max_error, std::abs(reference[i][c][r] - transforms[i].model_matrix[c][r]));
+	std::printf("max difference to the euler path: %g\n", max_error);
+	return max_error < 1e-3f ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <learnopengl/benchmark.h>
+#include <learnopengl/entity.h>
+#include <learnopengl/job_system.h>
+
+// Compares the serial and parallel Entity::update_self_and_child on the hierarchies of the scene graph demos and on
+// a larger forest, from 1 to N threads. Every frame the root rotates so the whole tree is recomputed.
+// Then compares a full update with Entity::update_dirty when only a few leaves move.
+
+// root with 400 children laid out on a grid, as in the frustum culling demo
+static void
+build_flat(Entity& root, Model& model)
+{
+	for (unsigned int x = 0; x < 20; ++x)
+	{
+		for (unsigned int z = 0; z < 20; ++z)
+		{
+			root.add_child(model);
+			root.children.back()->transform.set_local_position({x * 10.f - 100.f, 0.f, z * 10.f - 100.f});
+		}
+	}
+}
+
+// chain of depth children below the entity, as in the scene graph demo
+static void
+build_deep(Entity& root, Model& model, size_t depth)
+{
+	Entity* last_entity = &root;
+	for (size_t i = 0; i < depth; i++)
+	{
+		last_entity->add_child(model);
+		last_entity = last_entity->children.back().get();
+		last_entity->transform.set_local_position({10.0f, 0.0f, 0.0f});
+		last_entity->transform.set_local_scale({0.75f, 0.75f, 0.75f});
+	}
+}
+
+// 400 chains of 25 entities
+static void
+build_forest(Entity& root, Model& model)
+{
+	build_flat(root, model);
+	for (auto&& child : root.children)
+		build_deep(*child, model, 24);
+}
+
+static bool
+same_matrices(const Entity& a, const Entity& b)
+{
+	if (std::memcmp(&a.transform.get_model_matrix(), &b.transform.get_model_matrix(), sizeof(glm::mat4)) != 0)
+		return false;
+	auto child_b = b.children.begin();
+	for (auto&& child_a : a.children)
+	{
+		if (!same_matrices(*child_a, **child_b))
+			return false;
+		++child_b;
+	}
+	return true;
+}
+
+template<typename Build>
+static void
+run_hierarchy(const std::string& name, Model& model, const std::vector<unsigned int>& thread_counts, Build&& build)
+{
+	Entity serial_root(model);
+	Entity parallel_root(model);
+	build(serial_root, model);
+	build(parallel_root, model);
+
+	float angle = 0.0f;
+	const BenchmarkResult serial = run_benchmark(name + ", serial", 100, [&] {
+		serial_root.transform.set_local_rotation({0.f, angle += 1.0f, 0.f});
+		serial_root.update_self_and_child();
+	});
+	print_benchmark_result(serial);
+
+	for (unsigned int threads : thread_counts)
+	{
+		JobSystem job_system(threads - 1);
+		float parallel_angle = 0.0f;
+		const BenchmarkResult result =
+			run_benchmark(name + ", " + std::to_string(threads) + " threads", 100, [&] {
+				parallel_root.transform.set_local_rotation({0.f, parallel_angle += 1.0f, 0.f});
+				parallel_root.update_self_and_child(job_system);
+			});
+		print_benchmark_result(result);
+		std::printf("%-56s %14.2fx\n", "  speedup over serial", serial.median_ns / result.median_ns);
+
+		// both paths must produce bit identical matrices for the same input
+		serial_root.transform.set_local_rotation({0.f, 42.0f, 0.f});
+		serial_root.update_self_and_child();
+		parallel_root.transform.set_local_rotation({0.f, 42.0f, 0.f});
+		parallel_root.update_self_and_child(job_system);
+		if (!same_matrices(serial_root, parallel_root))
+			std::printf("  ERROR: parallel result differs from serial result\n");
+	}
+	std::printf("\n");
+}
+
+// a few leaves of the forest move every frame, the rest of the scene is static
+static void
+run_incremental(Model& model)
+{
+	Entity full_root(model);
+	Entity dirty_root(model);
+	build_forest(full_root, model);
+	build_forest(dirty_root, model);
+	full_root.update_self_and_child();
+	dirty_root.update_self_and_child();
+
+	std::vector<Entity*> full_leaves;
+	std::vector<Entity*> dirty_leaves;
+	for (auto&& child : full_root.children)
+	{
+		Entity* leaf = child.get();
+		while (!leaf->children.empty())
+			leaf = leaf->children.back().get();
+		full_leaves.push_back(leaf);
+	}
+	for (auto&& child : dirty_root.children)
+	{
+		Entity* leaf = child.get();
+		while (!leaf->children.empty())
+			leaf = leaf->children.back().get();
+		dirty_leaves.push_back(leaf);
+	}
+
+	for (size_t moving : {size_t(0), size_t(1), size_t(16), full_leaves.size()})
+	{
+		float angle = 0.0f;
+		const BenchmarkResult full =
+			run_benchmark("forest, " + std::to_string(moving) + " leaves moving, full update", 100, [&] {
+				angle += 1.0f;
+				for (size_t i = 0; i < moving; ++i)
+					full_leaves[i]->transform.set_local_rotation({0.f, angle, 0.f});
+				full_root.update_self_and_child();
+			});
+		print_benchmark_result(full);
+
+		float dirty_angle = 0.0f;
+		const BenchmarkResult dirty =
+			run_benchmark("forest, " + std::to_string(moving) + " leaves moving, update_dirty", 100, [&] {
+				dirty_angle += 1.0f;
+				for (size_t i = 0; i < moving; ++i)
+					dirty_leaves[i]->transform.set_local_rotation({0.f, dirty_angle, 0.f});
+				dirty_root.update_dirty();
+			});
+		print_benchmark_result(dirty);
+		std::printf("%-56s %14.2fx\n", "  speedup over full update", full.median_ns / dirty.median_ns);
+
+		if (!same_matrices(full_root, dirty_root))
+			std::printf("  ERROR: update_dirty result differs from full update\n");
+	}
+	std::printf("\n");
+}
+
+int
+main()
+{
+	const unsigned int max_threads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<unsigned int> thread_counts;
+	for (unsigned int threads = 1; threads < max_threads; threads *= 2)
+		thread_counts.push_back(threads);
+	thread_counts.push_back(max_threads);
+
+	// transforms only, no meshes to draw
+	Model model;
+
+	run_hierarchy("flat, 400 children", model, thread_counts, build_flat);
+	run_hierarchy("deep, 10 levels", model, thread_counts, [](Entity& root, Model& model) {
+		build_deep(root, model, 10);
+	});
+	run_hierarchy("forest, 400 x 25 entities", model, thread_counts, build_forest);
+	run_incremental(model);
+	return 0;
+}
@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/benchmark.h>
+#include <learnopengl/transparent_queue.h>
+
+// Back to front sorting of transparent quads: the std::map of the blending_sort demo, std::stable_sort on view
+// depths and TransparentQueue, from 10 to 100k quads. Positions sit on a coarse grid so many quads share a depth.
+
+// view space z summed in the order TransparentQueue uses, so ties are ties for both
+static float
+view_depth(const glm::mat4& view, const glm::vec3& position)
+{
+	return ((view[0][2] * position.x + view[1][2] * position.y) + view[2][2] * position.z) + view[3][2];
+}
+
+int
+main()
+{
+	const glm::vec3 eye(3.0f, 2.0f, 40.0f);
+	const glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	int errors = 0;
+	for (size_t count : {size_t(10), size_t(100), size_t(1000), size_t(10000), size_t(100000)})
+	{
+		std::mt19937 rng(11);
+		std::uniform_int_distribution<int> cell(-20, 20);
+		std::vector<glm::vec3> positions(count);
+		for (auto&& position : positions)
+			position = glm::vec3(cell(rng), cell(rng), cell(rng)) * 0.5f;
+		const std::string name = std::to_string(count) + " quads";
+
+		size_t map_size = 0;
+		const BenchmarkResult map = run_benchmark(name + ", std::map by distance", 1, [&] {
+			std::map<float, glm::vec3> sorted;
+			for (auto&& position : positions)
+				sorted[glm::length(eye - position)] = position;
+			map_size = sorted.size();
+			do_not_optimize(sorted);
+		});
+		print_benchmark_result(map);
+
+		std::vector<std::pair<float, unsigned int>> depths;
+		const BenchmarkResult stable = run_benchmark(name + ", std::stable_sort by view depth", 1, [&] {
+			depths.clear();
+			for (unsigned int i = 0; i < count; ++i)
+				depths.emplace_back(view_depth(view, positions[i]), i);
+			std::stable_sort(depths.begin(), depths.end(), [](const auto& a, const auto& b) {
+				return a.first < b.first;
+			});
+			do_not_optimize(depths);
+		});
+		print_benchmark_result(stable);
+
+		TransparentQueue queue;
+		const BenchmarkResult radix = run_benchmark(name + ", TransparentQueue", 1, [&] {
+			queue.clear();
+			for (unsigned int i = 0; i < count; ++i)
+				queue.push(positions[i], i);
+			queue.sort(view);
+			do_not_optimize(queue.get_order());
+		});
+		print_benchmark_result(radix);
+		std::printf("%-56s %14.2fx\n", "  speedup over std::map", map.median_ns / radix.median_ns);
+		std::printf("%-56s %14.2fx\n", "  speedup over std::stable_sort", stable.median_ns / radix.median_ns);
+		std::printf("%-56s %14zu\n", "  quads lost by std::map", count - map_size);
+
+		// same order as the stable sort, ties included
+		bool same = queue.get_order().size() == count;
+		for (size_t i = 0; same && i < count; ++i)
+			same = queue.get_order()[i] == depths[i].second;
+		if (!same)
+		{
+			std::printf("  ERROR: TransparentQueue order differs from std::stable_sort\n");
+			++errors;
+		}
+		std::printf("\n");
+	}
+	return errors;
+}
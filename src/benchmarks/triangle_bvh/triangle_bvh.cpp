@@ -0,0 +1,155 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/benchmark.h>
+#include <learnopengl/job_system.h>
+#include <learnopengl/mesh.h>
+#include <learnopengl/triangle_bvh.h>
+
+// Build time of TriangleBVH, serial and on the job system, and ray queries through it compared with testing every
+// triangle, on a bumpy sphere of growing resolution.
+
+static void
+build_sphere(unsigned int rings, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	const unsigned int segments = rings * 2;
+	vertices.clear();
+	indices.clear();
+	for (unsigned int r = 0; r <= rings; ++r)
+	{
+		for (unsigned int s = 0; s <= segments; ++s)
+		{
+			const float theta = glm::pi<float>() * r / rings;
+			const float phi = 2.0f * glm::pi<float>() * s / segments;
+			const float radius = 1.0f + 0.05f * std::sin(theta * 17.0f) * std::cos(phi * 13.0f);
+			Vertex vertex = {};
+			vertex.Position = radius * glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta),
+												 std::sin(theta) * std::sin(phi));
+			vertices.push_back(vertex);
+		}
+	}
+	for (unsigned int r = 0; r < rings; ++r)
+	{
+		for (unsigned int s = 0; s < segments; ++s)
+		{
+			const unsigned int a = r * (segments + 1) + s;
+			const unsigned int b = a + segments + 1;
+			indices.insert(indices.end(), {a, b, a + 1, a + 1, b, b + 1});
+		}
+	}
+}
+
+// every triangle, same double sided test as the BVH leaves
+static bool
+brute_force(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const glm::vec3& origin,
+			const glm::vec3& direction, RayHit& hit)
+{
+	bool found = false;
+	float closest = std::numeric_limits<float>::max();
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		const glm::vec3 v0 = vertices[indices[i]].Position;
+		const glm::vec3 edge1 = vertices[indices[i + 1]].Position - v0;
+		const glm::vec3 edge2 = vertices[indices[i + 2]].Position - v0;
+		const glm::vec3 p = glm::cross(direction, edge2);
+		const float det = glm::dot(edge1, p);
+		if (std::abs(det) <= 1e-8f)
+			continue;
+		const float inv_det = 1.0f / det;
+		const glm::vec3 s = origin - v0;
+		const float u = glm::dot(s, p) * inv_det;
+		const glm::vec3 q = glm::cross(s, edge1);
+		const float v = glm::dot(direction, q) * inv_det;
+		const float t = glm::dot(edge2, q) * inv_det;
+		if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t < closest)
+		{
+			closest = t;
+			hit.distance = t;
+			hit.triangle = static_cast<unsigned int>(i / 3);
+			hit.barycentrics = glm::vec2(u, v);
+			found = true;
+		}
+	}
+	return found;
+}
+
+int
+main()
+{
+	JobSystem job_system;
+	const std::string threads = std::to_string(job_system.get_thread_count());
+
+	// rays from a shell around the sphere towards points near its center, most of them hit
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::vector<glm::vec3> origins, directions;
+	for (int i = 0; i < 1024; ++i)
+	{
+		const glm::vec3 origin = 3.0f * glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)));
+		origins.push_back(origin);
+		directions.push_back(glm::normalize(0.8f * glm::vec3(unit(rng), unit(rng), unit(rng)) - origin));
+	}
+
+	int errors = 0;
+	for (unsigned int rings : {64u, 256u, 512u})
+	{
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		build_sphere(rings, vertices, indices);
+		const std::string name = std::to_string(indices.size() / 3) + " triangles";
+
+		TriangleBVH bvh;
+		const BenchmarkResult serial_build =
+			run_benchmark(name + ", build, serial", 1, [&] { bvh.build(vertices, indices); }, 5);
+		print_benchmark_result(serial_build);
+		const BenchmarkResult parallel_build = run_benchmark(
+			name + ", build, " + threads + " threads", 1, [&] { bvh.build(vertices, indices, &job_system); }, 5);
+		print_benchmark_result(parallel_build);
+		std::printf("%-56s %14.2fx\n", "  speedup", serial_build.median_ns / parallel_build.median_ns);
+
+		size_t ray = 0;
+		const BenchmarkResult traversal = run_benchmark(name + ", ray, bvh", 1024, [&] {
+			RayHit hit;
+			do_not_optimize(bvh.intersect(origins[ray], directions[ray], std::numeric_limits<float>::max(), hit));
+			ray = (ray + 1) % origins.size();
+		});
+		print_benchmark_result(traversal);
+
+		// brute force is slow, fewer rays
+		const BenchmarkResult brute = run_benchmark(
+			name + ", ray, every triangle",
+			16,
+			[&] {
+				RayHit hit;
+				do_not_optimize(brute_force(vertices, indices, origins[ray], directions[ray], hit));
+				ray = (ray + 1) % origins.size();
+			},
+			5);
+		print_benchmark_result(brute);
+		std::printf("%-56s %14.2fx\n", "  speedup", brute.median_ns / traversal.median_ns);
+
+		// both must find the same triangles
+		unsigned int mismatches = 0;
+		for (size_t i = 0; i < 256; ++i)
+		{
+			RayHit expected, hit;
+			const bool expected_found = brute_force(vertices, indices, origins[i], directions[i], expected);
+			const bool found = bvh.intersect(origins[i], directions[i], std::numeric_limits<float>::max(), hit);
+			if (expected_found != found || (found && std::abs(expected.distance - hit.distance) > 1e-4f))
+				++mismatches;
+		}
+		if (mismatches > 0)
+		{
+			std::printf("  ERROR: %u of 256 rays differ from the brute force result\n", mismatches);
+			++errors;
+		}
+		std::printf("\n");
+	}
+	return errors;
+}